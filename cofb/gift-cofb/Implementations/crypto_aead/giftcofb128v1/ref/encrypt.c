@@ -141,6 +141,10 @@ static int cofb_crypt(unsigned char *out, unsigned char *k, unsigned char *n,
     else
         emptyM=0;
 
+    /*Key expansion, shared by all blocks*/
+    struct Gift128Key key;
+    giftb128_key(&key, k);
+
     /*Mask-Gen*/
     block Y,input;
     half_block offset;
@@ -148,7 +152,7 @@ static int cofb_crypt(unsigned char *out, unsigned char *k, unsigned char *n,
     for(i=0;i<16;i++)
         input[i] = n[i];
 
-    giftb128(input,k,Y);
+    giftb128_encrypt(input,&key,Y);
     for(i=0;i<8;i++)
         offset[i] = Y[i];
 
@@ -163,7 +167,7 @@ static int cofb_crypt(unsigned char *out, unsigned char *k, unsigned char *n,
         double_half_block(offset,offset);
         xor_topbar_block(input, input, offset);
         /* Y[i] = E(X[i]) */
-        giftb128(input, k, Y);
+        giftb128_encrypt(input, &key, Y);
 
         a = a + 16;
         alen -= 16;
@@ -188,7 +192,7 @@ static int cofb_crypt(unsigned char *out, unsigned char *k, unsigned char *n,
 
     xor_topbar_block(input, input, offset);
     /* Y[a] = E(X[a]) */
-    giftb128(input, k, Y);
+    giftb128_encrypt(input, &key, Y);
 
 
     /* Process M */
@@ -206,7 +210,7 @@ static int cofb_crypt(unsigned char *out, unsigned char *k, unsigned char *n,
 
         xor_topbar_block(input,input,offset);
         /* Y[i] = E(X[i+a]) */
-        giftb128(input, k, Y);
+        giftb128_encrypt(input, &key, Y);
 
         in = in + 16;
         out = out + 16;
@@ -235,7 +239,7 @@ static int cofb_crypt(unsigned char *out, unsigned char *k, unsigned char *n,
 
         xor_topbar_block(input,input,offset);
         /* T = E(X[m+a]) */
-        giftb128(input, k, Y);
+        giftb128_encrypt(input, &key, Y);
     }
 
     if (encrypting) {
@@ -7,6 +7,8 @@ Date: 23 Mar 2019
 #include <stdint.h>
 #include <stdio.h>
 
+#include "gift128.h"
+
 /*Round constants*/
 const unsigned char GIFT_RC[40] = {
     0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3E, 0x3D, 0x3B, 0x37, 0x2F,
@@ -27,16 +29,10 @@ uint32_t rowperm(uint32_t S, int B0_pos, int B1_pos, int B2_pos, int B3_pos){
     return T;
 }
 
-void giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]){
+void giftb128_key(struct Gift128Key* key, const uint8_t K[16]){
     int round;
-    uint32_t S[4],T;
     uint16_t W[8],T6,T7;
 
-    S[0] = ((uint32_t)P[ 0]<<24) | ((uint32_t)P[ 1]<<16) | ((uint32_t)P[ 2]<<8) | (uint32_t)P[ 3];
-    S[1] = ((uint32_t)P[ 4]<<24) | ((uint32_t)P[ 5]<<16) | ((uint32_t)P[ 6]<<8) | (uint32_t)P[ 7];
-    S[2] = ((uint32_t)P[ 8]<<24) | ((uint32_t)P[ 9]<<16) | ((uint32_t)P[10]<<8) | (uint32_t)P[11];
-    S[3] = ((uint32_t)P[12]<<24) | ((uint32_t)P[13]<<16) | ((uint32_t)P[14]<<8) | (uint32_t)P[15];
-
     W[0] = ((uint16_t)K[ 0]<<8) | (uint16_t)K[ 1];
     W[1] = ((uint16_t)K[ 2]<<8) | (uint16_t)K[ 3];
     W[2] = ((uint16_t)K[ 4]<<8) | (uint16_t)K[ 5];
@@ -46,6 +42,35 @@ void giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]){
     W[6] = ((uint16_t)K[12]<<8) | (uint16_t)K[13];
     W[7] = ((uint16_t)K[14]<<8) | (uint16_t)K[15];
 
+    for(round=0; round<40; round++){
+        /*===Round key and round constant===*/
+        key->Rk[round][1] = ((uint32_t)W[6]<<16) | (uint32_t)W[7];
+        key->Rk[round][2] = ((uint32_t)W[2]<<16) | (uint32_t)W[3];
+        key->Rk[round][3] = 0x80000000 ^ GIFT_RC[round];
+
+        /*===Key state update===*/
+        T6 = (W[6]>>2) | (W[6]<<14);
+        T7 = (W[7]>>12) | (W[7]<<4);
+        W[7] = W[5];
+        W[6] = W[4];
+        W[5] = W[3];
+        W[4] = W[2];
+        W[3] = W[1];
+        W[2] = W[0];
+        W[1] = T7;
+        W[0] = T6;
+    }
+}
+
+void giftb128_encrypt(uint8_t P[16], const struct Gift128Key* key, uint8_t C[16]){
+    int round;
+    uint32_t S[4],T;
+
+    S[0] = ((uint32_t)P[ 0]<<24) | ((uint32_t)P[ 1]<<16) | ((uint32_t)P[ 2]<<8) | (uint32_t)P[ 3];
+    S[1] = ((uint32_t)P[ 4]<<24) | ((uint32_t)P[ 5]<<16) | ((uint32_t)P[ 6]<<8) | (uint32_t)P[ 7];
+    S[2] = ((uint32_t)P[ 8]<<24) | ((uint32_t)P[ 9]<<16) | ((uint32_t)P[10]<<8) | (uint32_t)P[11];
+    S[3] = ((uint32_t)P[12]<<24) | ((uint32_t)P[13]<<16) | ((uint32_t)P[14]<<8) | (uint32_t)P[15];
+
     for(round=0; round<40; round++){
         /*===SubCells===*/
         S[1] ^= S[0] & S[2];
@@ -68,23 +93,11 @@ void giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]){
         S[3] = rowperm(S[3],3,2,1,0);
 
         /*===AddRoundKey===*/
-        S[2] ^= ((uint32_t)W[2]<<16) | (uint32_t)W[3];
-        S[1] ^= ((uint32_t)W[6]<<16) | (uint32_t)W[7];
+        S[2] ^= key->Rk[round][2];
+        S[1] ^= key->Rk[round][1];
 
         /*Add round constant*/
-        S[3] ^= 0x80000000 ^ GIFT_RC[round];
-
-        /*===Key state update===*/
-        T6 = (W[6]>>2) | (W[6]<<14);
-        T7 = (W[7]>>12) | (W[7]<<4);
-        W[7] = W[5];
-        W[6] = W[4];
-        W[5] = W[3];
-        W[4] = W[2];
-        W[3] = W[1];
-        W[2] = W[0];
-        W[1] = T7;
-        W[0] = T6;
+        S[3] ^= key->Rk[round][3];
     }
 
     C[ 0] = S[0]>>24;
@@ -103,5 +116,12 @@ void giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]){
     C[13] = S[3]>>16;
     C[14] = S[3]>>8;
     C[15] = S[3];
+}
+
+void giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]){
+    struct Gift128Key key;
+
+    giftb128_key(&key, K);
+    giftb128_encrypt(P, &key, C);
 
 return;}
@@ -7,4 +7,14 @@ Date: 08 Feb 2019
 
 #include <stdint.h>
 
+/*Round keys of the 40 rounds, slice 0 takes no key*/
+struct Gift128Key {
+    uint32_t Rk[40][4];
+};
+
+/*Key expansion, once per key*/
+void giftb128_key(struct Gift128Key* key, const uint8_t K[16]);
+/*Encryption of one block with expanded round keys*/
+void giftb128_encrypt(uint8_t P[16], const struct Gift128Key* key, uint8_t C[16]);
+
 void giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]);
@@ -0,0 +1,266 @@
+/**
+ * Bidirectional cycle walks over the GIFT-64 permutation
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bidir.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crypto.h"
+#include "cycle.h"
+
+#define CHECK_STEPS (1 << 16) // steps between looks at the other walk
+
+//----------------------------------
+// Cipher and inverse
+//----------------------------------
+void
+bidir_cipher(struct BidirCipher* bc,
+             const uint64_t*     subkey,
+             uint16_t            Rounds,
+             _Bool               Decrypt)
+{
+    uint64_t shifted[MAX_ROUNDS];
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    memset(bc, 0, sizeof(*bc));
+    bc->Decrypt = Decrypt;
+    fixslice_key(&bc->Forward, subkey, Rounds);
+
+    if (!Decrypt) {
+        // decrypt() adds subkey[Rounds - 1] first and subkey[0] last
+        if (Rounds > 0) {
+            shifted[0] = 0;
+            memcpy(shifted + 1, subkey, (Rounds - 1) * sizeof(uint64_t));
+        }
+        fixslice_key(&bc->Backward, shifted, Rounds);
+    } else if (Rounds > 0) {
+        // decrypt() ends on subkey[0], which encrypt() has no place for
+        bc->BackwardXor = subkey[0];
+        fixslice_key(&bc->Backward, subkey + 1, Rounds - 1);
+        bc->Backward.Rounds = Rounds;
+    }
+}
+
+uint64_t
+bidir_forward(const struct BidirCipher* bc, uint64_t x)
+{
+    return bc->Decrypt ? decrypt_fixslice(x, &bc->Forward)
+                       : encrypt_fixslice(x, &bc->Forward);
+}
+
+uint64_t
+bidir_backward(const struct BidirCipher* bc, uint64_t x)
+{
+    return bc->Decrypt ? encrypt_fixslice(x ^ bc->BackwardXor, &bc->Backward)
+                       : decrypt_fixslice(x, &bc->Backward);
+}
+
+//----------------------------------
+// Distinguished point tables
+//----------------------------------
+// Every table has one writer, its own walk, and one reader, the other walk.
+// Sequentially consistent stores and loads make sure that of two walks
+// recording the same point at once at least one sees the other.
+struct BidirEntry
+{
+    uint64_t Point; // the distinguished point | DP_USED, 0 if free
+    uint64_t Steps;
+};
+
+struct BidirWalk;
+
+struct BidirSearch
+{
+    struct BidirConfig Config;
+    struct BidirWalk*  Walk[2]; // forward, backward
+    uint64_t           TableMask;
+    struct BidirResult Result;
+    _Bool              Done;
+    struct WorkerPool  Pool;
+    struct Progress    Progress;
+};
+
+struct BidirWalk
+{
+    struct BidirSearch* Search;
+    struct BidirEntry*  Table;
+    uint64_t            Points;
+    _Bool               Backward;
+    _Bool               Full;
+    uint64_t            Steps; // for progress reports
+    uint64_t            X;
+};
+
+static uint64_t
+dp_slot(const struct BidirSearch* bs, uint64_t point)
+{
+    return (point * 0x9E3779B97F4A7C15) >> (64 - bs->Config.TableBits);
+}
+
+// Only the walk that owns the table adds to it. A table three quarters full
+// takes no more points.
+static void
+dp_record(struct BidirWalk* w, uint64_t point, uint64_t steps)
+{
+    struct BidirSearch* bs   = w->Search;
+    uint64_t            slot = dp_slot(bs, point);
+
+    if (w->Points >= bs->TableMask / 4 * 3) {
+        w->Full = 1;
+        return;
+    }
+    while (w->Table[slot].Point != 0) {
+        slot = (slot + 1) & bs->TableMask;
+    }
+    w->Table[slot].Steps = steps;
+    __atomic_store_n(&w->Table[slot].Point, point | DP_USED, __ATOMIC_SEQ_CST);
+    w->Points++;
+}
+
+// The steps the walk took to reach point, 0 if it has not
+static uint64_t
+dp_lookup(const struct BidirWalk* w, uint64_t point)
+{
+    const struct BidirSearch* bs   = w->Search;
+    uint64_t                  slot = dp_slot(bs, point), found;
+
+    for (;;) {
+        found = __atomic_load_n(&w->Table[slot].Point, __ATOMIC_SEQ_CST);
+        if (found == 0)
+            return 0;
+        if (found == (point | DP_USED))
+            return w->Table[slot].Steps;
+        slot = (slot + 1) & bs->TableMask;
+    }
+}
+
+//----------------------------------
+// Walking
+//----------------------------------
+// The first walk to finish the search fills in the result
+static void
+finish(struct BidirSearch* bs, uint8_t state, uint64_t length, uint64_t meet)
+{
+    pthread_mutex_lock(&bs->Pool.Lock);
+    if (!bs->Done) {
+        bs->Result.State  = state;
+        bs->Result.Length = length;
+        bs->Result.Meet   = meet;
+        __atomic_store_n(&bs->Done, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&bs->Pool.Lock);
+}
+
+static void*
+walker(void* arg)
+{
+    struct BidirWalk*         w      = arg;
+    struct BidirSearch*       bs     = w->Search;
+    const struct BidirConfig* cfg    = &bs->Config;
+    const struct BidirWalk*   other  = bs->Walk[!w->Backward];
+    uint64_t                  dpMask = ~(uint64_t)0 << (64 - cfg->DpBits);
+    uint64_t                  x      = cfg->Start, n = 0, m;
+    BidirStep                 step;
+
+    step = w->Backward ? cfg->Backward : cfg->Forward;
+
+    while (!__atomic_load_n(&bs->Done, __ATOMIC_RELAXED)) {
+        do {
+            x = step(cfg->Cipher, x);
+            n++;
+            if (x == cfg->Start) {
+                finish(bs, BIDIR_CLOSED, n, x);
+                goto done;
+            }
+            if ((x & dpMask) == 0) {
+                dp_record(w, x, n);
+                if ((m = dp_lookup(other, x)) != 0) {
+                    finish(bs, BIDIR_MET, n + m, x);
+                    goto done;
+                }
+            }
+        } while (n % CHECK_STEPS != 0 && n != cfg->MaxSteps);
+
+        __atomic_store_n(&w->Steps, n, __ATOMIC_RELAXED);
+        __atomic_store_n(&w->X, x, __ATOMIC_RELAXED);
+        if (n == cfg->MaxSteps)
+            break;
+    }
+
+done:
+    __atomic_store_n(&w->Steps, n, __ATOMIC_RELAXED);
+    pool_done(&bs->Pool);
+    return NULL;
+}
+
+//----------------------------------
+// Search
+//----------------------------------
+static void
+report_progress(void* arg)
+{
+    struct BidirSearch* bs = arg;
+
+    progress_report(&bs->Progress,
+                    __atomic_load_n(&bs->Walk[0]->Steps, __ATOMIC_RELAXED) +
+                      __atomic_load_n(&bs->Walk[1]->Steps, __ATOMIC_RELAXED),
+                    bs->Walk[0]->Points + bs->Walk[1]->Points,
+                    __atomic_load_n(&bs->Done, __ATOMIC_RELAXED),
+                    1,
+                    __atomic_load_n(&bs->Walk[0]->X, __ATOMIC_RELAXED));
+}
+
+int
+bidir_walk(const struct BidirConfig* config, struct BidirResult* result)
+{
+    struct BidirSearch bs;
+    struct BidirWalk   walk[2];
+    unsigned           i;
+
+    memset(&bs, 0, sizeof(bs));
+    memset(walk, 0, sizeof(walk));
+    bs.Config    = *config;
+    bs.TableMask = ((uint64_t)1 << config->TableBits) - 1;
+    for (i = 0; i < 2; i++) {
+        walk[i].Search   = &bs;
+        walk[i].Backward = i;
+        walk[i].Table = calloc(bs.TableMask + 1, sizeof(struct BidirEntry));
+        bs.Walk[i]    = &walk[i];
+    }
+    if (walk[0].Table == NULL || walk[1].Table == NULL) {
+        free(walk[0].Table);
+        free(walk[1].Table);
+        return -1;
+    }
+    pool_init(&bs.Pool);
+    progress_start(&bs.Progress, 0, 2 * config->MaxSteps);
+
+    // The walks run one after the other if no thread can be started
+    pool_run(&bs.Pool,
+             walker,
+             walk,
+             sizeof(walk[0]),
+             2,
+             config->ProgressEvery,
+             report_progress,
+             &bs);
+
+    *result           = bs.Result;
+    result->Forward   = walk[0].Steps;
+    result->Backward  = walk[1].Steps;
+    result->TableFull = walk[0].Full || walk[1].Full;
+
+    free(walk[0].Table);
+    free(walk[1].Table);
+    pool_free(&bs.Pool);
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * Bidirectional cycle walks over the GIFT-64 permutation
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The cycle through a start x is walked from both ends at once: one thread
+ * steps the cipher forward from x, another steps its inverse backward from x.
+ * Each records the distinguished points it reaches, with the steps it took,
+ * in a table of its own, and looks every one of them up in the table of the
+ * other. When a point turns up in both, forward reached it in f steps and
+ * backward in b, so the cycle length is f + b, and each thread has only
+ * walked about half of it (plus the distance between distinguished points).
+ *
+ * decrypt() with the same round keys is not the inverse of encrypt(): its
+ * first key addition belongs to no round of encrypt(). The inverse of
+ * encrypt() is decrypt() with the round keys moved up by one and a zero key
+ * in front, and the inverse of decrypt() is encrypt() with the first round key
+ * dropped, after adding that key to the block. bidir_cipher() sets up both
+ * directions for either, in the fixsliced form of fixslice.h, and
+ * bidir_forward() and bidir_backward() step them. Other permutations plug in
+ * their own pair of steps.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include "fixslice.h"
+#include "progress.h"
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct BidirCipher
+{
+    struct FixsliceKey Forward;
+    struct FixsliceKey Backward;
+    uint64_t           BackwardXor; // added before every backward step
+    _Bool              Decrypt;     // forward is decrypt()
+};
+
+// One step of a walk, handed the Cipher of the config
+typedef uint64_t (*BidirStep)(const struct BidirCipher* bc, uint64_t x);
+
+struct BidirConfig
+{
+    BidirStep                 Forward;
+    BidirStep                 Backward; // undoes Forward
+    const struct BidirCipher* Cipher;
+    uint64_t                  Start;
+    uint64_t                  MaxSteps;  // per direction, 0 for no limit
+    uint8_t                   DpBits;    // 1 to 63
+    uint8_t                   TableBits; // 2^TableBits points per direction
+    unsigned                  ProgressEvery; // seconds, 0 for none
+};
+
+enum BidirState
+{
+    BIDIR_OPEN   = 0, // both walks ran out of steps
+    BIDIR_CLOSED = 1, // one walk came back to the start on its own
+    BIDIR_MET    = 2  // the walks met at the distinguished point Meet
+};
+
+struct BidirResult
+{
+    uint64_t Length;   // the cycle length unless open
+    uint64_t Forward;  // steps walked each way
+    uint64_t Backward;
+    uint64_t Meet;
+    _Bool    TableFull; // points went unrecorded, the walks may meet later
+    uint8_t  State;
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+// Steps of encrypt(), or of decrypt() if Decrypt is set, and their inverse
+void
+bidir_cipher(struct BidirCipher* bc,
+             const uint64_t*     subkey,
+             uint16_t            Rounds,
+             _Bool               Decrypt);
+
+uint64_t
+bidir_forward(const struct BidirCipher* bc, uint64_t x);
+
+uint64_t
+bidir_backward(const struct BidirCipher* bc, uint64_t x);
+
+// Returns 0, or -1 if the tables could not be allocated
+int
+bidir_walk(const struct BidirConfig* config, struct BidirResult* result);
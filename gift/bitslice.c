@@ -0,0 +1,424 @@
+/**
+ * Bitsliced implementation of GIFT-64, 64 blocks per call
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include <string.h>
+
+#include "bitslice.h"
+#include "crypto.h"
+
+// All ones if bit `bit` of the round key is set, so a whole slice can be
+// complemented without a branch
+#define KEY_MASK(key, bit) (-(((key) >> (bit)) & 1))
+
+//----------------------------------
+// Transposition
+//----------------------------------
+// Converts 64 blocks into 64 slices and back (the transpose is its own
+// inverse). After the call, bit j of m[i] is what bit i of m[j] was before.
+void
+bs_transpose(uint64_t m[BS_LANES])
+{
+    uint64_t mask = 0x00000000FFFFFFFF;
+    uint64_t t;
+    int      j, k;
+
+    for (j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            t = ((m[k] >> j) ^ m[k | j]) & mask;
+            m[k] ^= t << j;
+            m[k | j] ^= t;
+        }
+    }
+}
+
+//----------------------------------
+// Substitution layers
+//----------------------------------
+// S-Boxes of every nibble in s, written straight to their P-Box positions
+// in t
+static void
+bs_substitute(const uint64_t s[BS_LANES], uint64_t t[BS_LANES])
+{
+    uint16_t SboxNr;
+
+    for (SboxNr = 0; SboxNr < 16; SboxNr++) {
+        uint64_t s0 = s[4 * SboxNr];
+        uint64_t s1 = s[4 * SboxNr + 1];
+        uint64_t s2 = s[4 * SboxNr + 2];
+        uint64_t s3 = s[4 * SboxNr + 3];
+
+        BS_SBOX(s0, s1, s2, s3);
+
+        t[63 - PboxInv[63 - (4 * SboxNr)]]     = s3;
+        t[63 - PboxInv[63 - (4 * SboxNr + 1)]] = s1;
+        t[63 - PboxInv[63 - (4 * SboxNr + 2)]] = s2;
+        t[63 - PboxInv[63 - (4 * SboxNr + 3)]] = s0;
+    }
+}
+
+// Inverse P-Box, gathered into each inverse S-Box
+static void
+bs_substitute_inv(const uint64_t s[BS_LANES], uint64_t t[BS_LANES])
+{
+    uint16_t SboxNr;
+
+    for (SboxNr = 0; SboxNr < 16; SboxNr++) {
+        uint64_t s0 = s[63 - PboxInv[63 - (4 * SboxNr)]];
+        uint64_t s1 = s[63 - PboxInv[63 - (4 * SboxNr + 1)]];
+        uint64_t s2 = s[63 - PboxInv[63 - (4 * SboxNr + 2)]];
+        uint64_t s3 = s[63 - PboxInv[63 - (4 * SboxNr + 3)]];
+
+        BS_SBOX_INV(s0, s1, s2, s3);
+
+        t[4 * SboxNr]     = s3;
+        t[4 * SboxNr + 1] = s1;
+        t[4 * SboxNr + 2] = s2;
+        t[4 * SboxNr + 3] = s0;
+    }
+}
+
+//----------------------------------
+// Encryption
+//----------------------------------
+// Same round structure as encrypt(): Rounds - 1 times S-Box, P-Box and the
+// round key.
+void
+bs_encrypt(uint64_t s[BS_LANES], const uint64_t* subkey, uint16_t Rounds)
+{
+    uint16_t RoundNr, i;
+    uint64_t t[BS_LANES];
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        bs_substitute(s, t);
+
+        //----------------------------------
+        // Xor with roundkey
+        //----------------------------------
+        for (i = 0; i < 64; i++) {
+            s[i] = t[i] ^ KEY_MASK(subkey[RoundNr - 1], i);
+        }
+    }
+}
+
+void
+encrypt_bitslice(uint64_t blocks[BS_LANES],
+                 const uint64_t* subkey,
+                 uint16_t        Rounds)
+{
+    bs_transpose(blocks);
+    bs_encrypt(blocks, subkey, Rounds);
+    bs_transpose(blocks);
+}
+
+//----------------------------------
+// Decryption
+//----------------------------------
+// Same round structure as decrypt(): Rounds times round key, inverse P-Box
+// and inverse S-Box, where the result is taken after the last key addition.
+void
+bs_decrypt(uint64_t s[BS_LANES], const uint64_t* subkey, uint16_t Rounds)
+{
+    uint16_t RoundNr, i;
+    uint64_t t[BS_LANES];
+
+    if (Rounds == 0)
+        return;
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        for (i = 0; i < 64; i++) {
+            s[i] ^= KEY_MASK(subkey[Rounds - RoundNr], i);
+        }
+
+        bs_substitute_inv(s, t);
+
+        for (i = 0; i < 64; i++) {
+            s[i] = t[i];
+        }
+    }
+
+    // The last round only adds the first round key
+    for (i = 0; i < 64; i++) {
+        s[i] ^= KEY_MASK(subkey[0], i);
+    }
+}
+
+void
+decrypt_bitslice(uint64_t blocks[BS_LANES],
+                 const uint64_t* subkey,
+                 uint16_t        Rounds)
+{
+    bs_transpose(blocks);
+    bs_decrypt(blocks, subkey, Rounds);
+    bs_transpose(blocks);
+}
+
+//----------------------------------
+// Key-sliced Key Scheduling
+//----------------------------------
+// The same steps as key_schedule(), on the 128 key bits of all lanes at
+// once. The key state update only moves bits between words, so it becomes a
+// renaming of slices: word 2 * r + 8 is word 2 * r rotated by 12 and word
+// 2 * r + 9 is word 2 * r + 1 rotated by 2, and round r uses words 2 * r (V)
+// and 2 * r + 1 (U).
+void
+keyslice_init(struct KeySlice* ks,
+              const uint64_t*  key_high,
+              const uint64_t*  key_low,
+              size_t           n,
+              uint16_t         Rounds)
+{
+    uint64_t words[16 * (8 + 2 * MAX_ROUNDS)];
+    uint16_t RoundNr, i;
+
+    if (n > BS_LANES)
+        n = BS_LANES;
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    ks->Rounds = Rounds;
+
+    // Slice j of word w is bit 16 * w + j of the keys, unused lanes get key 0
+    for (i = 0; i < BS_LANES; i++) {
+        words[i]      = i < n ? key_low[i] : 0;
+        words[64 + i] = i < n ? key_high[i] : 0;
+    }
+    bs_transpose(words);
+    bs_transpose(words + 64);
+
+    for (RoundNr = 0; RoundNr < Rounds; RoundNr++) {
+        uint64_t* V = words + 32 * RoundNr;
+        uint64_t* U = V + 16;
+
+        for (i = 0; i < 16; i++) {
+            ks->V[RoundNr][i] = V[i];
+            ks->U[RoundNr][i] = U[i];
+            V[128 + i]        = V[(i + 12) % 16];
+            U[128 + i]        = U[(i + 2) % 16];
+        }
+    }
+}
+
+// Only bits 0 and 1 of each nibble carry key material. The round constant
+// and bit 63 are the same in every lane, so they complement whole slices.
+#define ADD_KEY_SLICES(s, ks, RoundNr)                                         \
+    do {                                                                       \
+        uint16_t j_;                                                           \
+        for (j_ = 0; j_ < 16; j_++) {                                          \
+            s[4 * j_] ^= (ks)->V[RoundNr][j_];                                 \
+            s[4 * j_ + 1] ^= (ks)->U[RoundNr][j_];                             \
+        }                                                                      \
+        for (j_ = 0; j_ < 6; j_++) {                                           \
+            if ((Constants[RoundNr] >> j_) & 1)                                \
+                s[ConstantsLocation[j_]] = ~s[ConstantsLocation[j_]];          \
+        }                                                                      \
+        s[63] = ~s[63];                                                        \
+    } while (0)
+
+//----------------------------------
+// Key-sliced Encryption
+//----------------------------------
+void
+bs_encrypt_keysliced(uint64_t s[BS_LANES], const struct KeySlice* ks)
+{
+    uint16_t RoundNr, i;
+    uint64_t t[BS_LANES];
+
+    for (RoundNr = 1; RoundNr < ks->Rounds; RoundNr++) {
+        bs_substitute(s, t);
+        ADD_KEY_SLICES(t, ks, RoundNr - 1);
+        for (i = 0; i < 64; i++) {
+            s[i] = t[i];
+        }
+    }
+}
+
+void
+encrypt_keysliced(uint64_t blocks[BS_LANES], const struct KeySlice* ks)
+{
+    bs_transpose(blocks);
+    bs_encrypt_keysliced(blocks, ks);
+    bs_transpose(blocks);
+}
+
+//----------------------------------
+// Key-sliced Decryption
+//----------------------------------
+void
+bs_decrypt_keysliced(uint64_t s[BS_LANES], const struct KeySlice* ks)
+{
+    uint16_t RoundNr, i;
+    uint16_t Rounds = ks->Rounds;
+    uint64_t t[BS_LANES];
+
+    if (Rounds == 0)
+        return;
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        ADD_KEY_SLICES(s, ks, Rounds - RoundNr);
+        bs_substitute_inv(s, t);
+        for (i = 0; i < 64; i++) {
+            s[i] = t[i];
+        }
+    }
+    ADD_KEY_SLICES(s, ks, 0);
+}
+
+void
+decrypt_keysliced(uint64_t blocks[BS_LANES], const struct KeySlice* ks)
+{
+    bs_transpose(blocks);
+    bs_decrypt_keysliced(blocks, ks);
+    bs_transpose(blocks);
+}
+
+//----------------------------------
+// Walks
+//----------------------------------
+void
+bs_walk_key(struct BsWalkKey* wk,
+            const uint64_t*   subkey,
+            uint16_t          Rounds,
+            _Bool             Decrypt)
+{
+    uint16_t RoundNr, i;
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    for (RoundNr = 0; RoundNr < Rounds; RoundNr++) {
+        for (i = 0; i < 64; i++) {
+            wk->Mask[RoundNr][i] = KEY_MASK(subkey[RoundNr], i);
+        }
+    }
+    wk->Rounds  = Rounds;
+    wk->Decrypt = Decrypt;
+}
+
+// bs_substitute() with the round key added on the way
+static void
+bs_round(const uint64_t s[BS_LANES], uint64_t t[BS_LANES], const uint64_t* key)
+{
+    uint16_t SboxNr;
+
+    for (SboxNr = 0; SboxNr < 16; SboxNr++) {
+        uint64_t s0 = s[4 * SboxNr];
+        uint64_t s1 = s[4 * SboxNr + 1];
+        uint64_t s2 = s[4 * SboxNr + 2];
+        uint64_t s3 = s[4 * SboxNr + 3];
+        uint8_t  p0 = 63 - PboxInv[63 - (4 * SboxNr)];
+        uint8_t  p1 = 63 - PboxInv[63 - (4 * SboxNr + 1)];
+        uint8_t  p2 = 63 - PboxInv[63 - (4 * SboxNr + 2)];
+        uint8_t  p3 = 63 - PboxInv[63 - (4 * SboxNr + 3)];
+
+        BS_SBOX(s0, s1, s2, s3);
+
+        t[p0] = s3 ^ key[p0];
+        t[p1] = s1 ^ key[p1];
+        t[p2] = s2 ^ key[p2];
+        t[p3] = s0 ^ key[p3];
+    }
+}
+
+// The round key added before bs_substitute_inv()
+static void
+bs_round_inv(const uint64_t s[BS_LANES],
+             uint64_t       t[BS_LANES],
+             const uint64_t* key)
+{
+    uint16_t SboxNr;
+
+    for (SboxNr = 0; SboxNr < 16; SboxNr++) {
+        uint8_t  p0 = 63 - PboxInv[63 - (4 * SboxNr)];
+        uint8_t  p1 = 63 - PboxInv[63 - (4 * SboxNr + 1)];
+        uint8_t  p2 = 63 - PboxInv[63 - (4 * SboxNr + 2)];
+        uint8_t  p3 = 63 - PboxInv[63 - (4 * SboxNr + 3)];
+        uint64_t s0 = s[p0] ^ key[p0];
+        uint64_t s1 = s[p1] ^ key[p1];
+        uint64_t s2 = s[p2] ^ key[p2];
+        uint64_t s3 = s[p3] ^ key[p3];
+
+        BS_SBOX_INV(s0, s1, s2, s3);
+
+        t[4 * SboxNr]     = s3;
+        t[4 * SboxNr + 1] = s1;
+        t[4 * SboxNr + 2] = s2;
+        t[4 * SboxNr + 3] = s0;
+    }
+}
+
+uint64_t
+bs_walk(uint64_t                s[BS_LANES],
+        const uint64_t          start[BS_LANES],
+        uint64_t                steps,
+        uint64_t                mask,
+        const struct BsWalkKey* wk,
+        uint64_t*               back)
+{
+    uint16_t  RoundNr, i;
+    uint16_t  Rounds = wk->Rounds;
+    uint64_t  t[BS_LANES];
+    uint64_t *from, *to, *swap;
+    uint64_t  diff, n;
+
+    for (n = 0; n < steps;) {
+        from = s;
+        to   = t;
+        if (!wk->Decrypt) {
+            for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+                bs_round(from, to, wk->Mask[RoundNr - 1]);
+                swap = from;
+                from = to;
+                to   = swap;
+            }
+        } else if (Rounds > 0) {
+            for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+                bs_round_inv(from, to, wk->Mask[Rounds - RoundNr]);
+                swap = from;
+                from = to;
+                to   = swap;
+            }
+            for (i = 0; i < 64; i++) {
+                from[i] ^= wk->Mask[0][i];
+            }
+        }
+        if (from != s)
+            memcpy(s, from, sizeof(t));
+        n++;
+
+        // A lane is back when none of its bits differ from the start
+        diff = 0;
+        for (i = 0; i < 64; i++) {
+            diff |= s[i] ^ start[i];
+        }
+        if ((~diff & mask) != 0) {
+            *back = ~diff & mask;
+            return n;
+        }
+    }
+    *back = 0;
+    return n;
+}
+
+void
+bs_lane_set(uint64_t s[BS_LANES], unsigned lane, uint64_t block)
+{
+    uint16_t i;
+
+    for (i = 0; i < 64; i++) {
+        s[i] = (s[i] & ~((uint64_t)1 << lane)) | (((block >> i) & 1) << lane);
+    }
+}
+
+uint64_t
+bs_lane_get(const uint64_t s[BS_LANES], unsigned lane)
+{
+    uint64_t block = 0;
+    uint16_t i;
+
+    for (i = 0; i < 64; i++) {
+        block |= ((s[i] >> lane) & 1) << i;
+    }
+    return block;
+}
@@ -0,0 +1,145 @@
+/**
+ * Bitsliced implementation of GIFT-64, 64 blocks per call
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The sliced state is an array of 64 words where word i holds bit i of every
+ * block, and bit j of each word belongs to block j. The S-Box is evaluated
+ * with boolean operations on four slices at once and the P-Box becomes a
+ * renaming of slices, so there are no per-bit loops or table lookups.
+ *
+ * The key-sliced variant runs every lane under its own key: the round keys
+ * are sliced the same way as the state, by keyslice_init(), which runs the
+ * key schedule for all keys at once. Encrypting one plaintext under up to 64
+ * keys is then a single pass, with the plaintext copied into every lane.
+ *
+ * bs_walk() iterates the cipher on 64 independent orbits, each lane feeding
+ * its output back in, and compares every lane with its start after each step.
+ * Its round keys are expanded once into one mask per slice, and the rounds
+ * alternate between two buffers, so a step has no copies or key bit tests.
+ *
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crypto.h"
+
+#define BS_LANES 64
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+// U[r][j] and V[r][j] hold bit j of the key words U and V of round r for
+// every lane. The round constants are the same for all keys and are added
+// by the round function.
+struct KeySlice
+{
+    uint64_t U[MAX_ROUNDS][16];
+    uint64_t V[MAX_ROUNDS][16];
+    uint16_t Rounds;
+};
+
+// Mask[r][i] is all ones if bit i of round key r is set
+struct BsWalkKey
+{
+    uint64_t Mask[MAX_ROUNDS][BS_LANES];
+    uint16_t Rounds;
+    _Bool    Decrypt;
+};
+
+//----------------------------------
+// Bitsliced S-Boxes
+//----------------------------------
+// Both macros take slices 0..3 of a nibble in s0..s3 and work for any
+// unsigned word type. The final swap of the S-Box is left to the caller: the
+// result slice 0 is left in s3 and slice 3 in s0.
+#define BS_SBOX(s0, s1, s2, s3)                                                \
+    do {                                                                       \
+        s1 ^= s0 & s2;                                                         \
+        s0 ^= s1 & s3;                                                         \
+        s2 ^= s0 | s1;                                                         \
+        s3 ^= s2;                                                              \
+        s1 ^= s3;                                                              \
+        s3 = ~s3;                                                              \
+        s2 ^= s0 & s1;                                                         \
+    } while (0)
+
+#define BS_SBOX_INV(s0, s1, s2, s3)                                            \
+    do {                                                                       \
+        s2 ^= s3 & s1;                                                         \
+        s0 = ~s0;                                                              \
+        s1 ^= s0;                                                              \
+        s0 ^= s2;                                                              \
+        s2 ^= s3 | s1;                                                         \
+        s3 ^= s1 & s0;                                                         \
+        s1 ^= s3 & s2;                                                         \
+    } while (0)
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+void
+bs_transpose(uint64_t m[BS_LANES]);
+
+void
+bs_encrypt(uint64_t s[BS_LANES], const uint64_t* subkey, uint16_t Rounds);
+
+void
+bs_decrypt(uint64_t s[BS_LANES], const uint64_t* subkey, uint16_t Rounds);
+
+void
+encrypt_bitslice(uint64_t blocks[BS_LANES],
+                 const uint64_t* subkey,
+                 uint16_t        Rounds);
+
+void
+decrypt_bitslice(uint64_t blocks[BS_LANES],
+                 const uint64_t* subkey,
+                 uint16_t        Rounds);
+
+// Lane i uses key_high[i], key_low[i] (128-bit keys); n is at most 64
+void
+keyslice_init(struct KeySlice* ks,
+              const uint64_t*  key_high,
+              const uint64_t*  key_low,
+              size_t           n,
+              uint16_t         Rounds);
+
+void
+bs_encrypt_keysliced(uint64_t s[BS_LANES], const struct KeySlice* ks);
+
+void
+bs_decrypt_keysliced(uint64_t s[BS_LANES], const struct KeySlice* ks);
+
+void
+encrypt_keysliced(uint64_t blocks[BS_LANES], const struct KeySlice* ks);
+
+void
+decrypt_keysliced(uint64_t blocks[BS_LANES], const struct KeySlice* ks);
+
+// Steps of encrypt(), or decrypt() if Decrypt is set
+void
+bs_walk_key(struct BsWalkKey* wk,
+            const uint64_t*   subkey,
+            uint16_t          Rounds,
+            _Bool             Decrypt);
+
+// Up to steps steps of every lane of s. Ends after the first step that
+// brings one of the lanes set in mask back to its value in start, and
+// returns the steps taken; *back gets the lanes of mask that came back.
+uint64_t
+bs_walk(uint64_t                s[BS_LANES],
+        const uint64_t          start[BS_LANES],
+        uint64_t                steps,
+        uint64_t                mask,
+        const struct BsWalkKey* wk,
+        uint64_t*               back);
+
+// One block of a sliced state
+void
+bs_lane_set(uint64_t s[BS_LANES], unsigned lane, uint64_t block);
+
+uint64_t
+bs_lane_get(const uint64_t s[BS_LANES], unsigned lane);
@@ -0,0 +1,201 @@
+/**
+ * Bitsliced cycle walks, 64 orbits per thread
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bscycle.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CHECK_STEPS (1 << 16) // steps between progress updates
+
+//----------------------------------
+// Walking
+//----------------------------------
+// Puts the next orbit of key into lane, if there is one left
+static void
+lane_fill(struct BsCycleSearch* bs,
+          unsigned              key,
+          struct Lanes*         ls,
+          uint64_t              s[BS_LANES],
+          uint64_t              start[BS_LANES],
+          unsigned              lane)
+{
+    uint64_t x;
+
+    if (!lanes_take(ls, lane, &bs->NextOrbit[key], bs->Config.Orbits))
+        return;
+    x = bs->Config.FirstStart + ls->Orbit[lane];
+    bs_lane_set(s, lane, x);
+    bs_lane_set(start, lane, x);
+}
+
+// All orbits of key this thread gets
+static void
+walk_key(struct BsWalker* wk, unsigned key)
+{
+    struct BsCycleSearch* bs    = wk->Search;
+    struct LaneOrbit*     orbit = &bs->Orbit[key * bs->Config.Orbits];
+    struct Lanes          ls;
+    uint64_t              s[BS_LANES], start[BS_LANES];
+    uint64_t              steps, n, back, lanes, freed;
+    unsigned              l;
+
+    memset(s, 0, sizeof(s));
+    memset(start, 0, sizeof(start));
+    lanes_init(&ls, bs->Config.MaxSteps);
+    for (l = 0; l < BS_LANES; l++) {
+        lane_fill(bs, key, &ls, s, start, l);
+    }
+
+    while (ls.Active != 0) {
+        lanes = ls.Active;
+        steps = lanes_budget(&ls, CHECK_STEPS);
+        n     = bs_walk(s, start, steps, lanes, &bs->Config.Key[key], &back);
+        freed = lanes_finish(&ls, n, back, orbit, &bs->Finished);
+        for (; freed != 0; freed &= freed - 1) {
+            lane_fill(bs, key, &ls, s, start, __builtin_ctzll(freed));
+        }
+
+        __atomic_fetch_add(&wk->Steps,
+                           n * (uint64_t)__builtin_popcountll(lanes),
+                           __ATOMIC_RELAXED);
+        __atomic_store_n(&wk->X, bs_lane_get(s, 0), __ATOMIC_RELAXED);
+    }
+}
+
+// Every key once, starting from a different one on each thread
+static void*
+worker(void* arg)
+{
+    struct BsWalker*      wk   = arg;
+    struct BsCycleSearch* bs   = wk->Search;
+    unsigned              keys = bs->Config.Keys, key, k;
+
+    key = (unsigned)(wk - bs->Walker) % keys;
+    for (k = 0; k < keys; k++) {
+        walk_key(wk, (key + k) % keys);
+    }
+
+    pool_done(&bs->Pool);
+    return NULL;
+}
+
+//----------------------------------
+// Search
+//----------------------------------
+int
+bscycle_init(struct BsCycleSearch* bs, const struct BsCycleConfig* config)
+{
+    uint64_t orbits;
+
+    memset(bs, 0, sizeof(*bs));
+    bs->Config = *config;
+    if (bs->Config.Keys == 0)
+        bs->Config.Keys = 1;
+    if (bs->Config.Threads == 0) {
+        long cores         = sysconf(_SC_NPROCESSORS_ONLN);
+        bs->Config.Threads = cores > 0 ? (unsigned)cores : 1;
+    }
+    pool_init(&bs->Pool);
+
+    orbits        = bs->Config.Keys * config->Orbits;
+    bs->Orbit     = calloc(orbits ? orbits : 1, sizeof(struct LaneOrbit));
+    bs->NextOrbit = calloc(bs->Config.Keys, sizeof(uint64_t));
+    bs->Walker    = calloc(bs->Config.Threads, sizeof(struct BsWalker));
+    if (bs->Orbit == NULL || bs->NextOrbit == NULL || bs->Walker == NULL) {
+        bscycle_free(bs);
+        return -1;
+    }
+    return 0;
+}
+
+void
+bscycle_free(struct BsCycleSearch* bs)
+{
+    free(bs->Orbit);
+    free(bs->NextOrbit);
+    free(bs->Walker);
+    bs->Orbit     = NULL;
+    bs->NextOrbit = NULL;
+    bs->Walker    = NULL;
+    pool_free(&bs->Pool);
+}
+
+static void
+report_progress(void* arg)
+{
+    struct BsCycleSearch* bs    = arg;
+    uint64_t              steps = 0;
+    unsigned              i;
+
+    for (i = 0; i < bs->Config.Threads; i++) {
+        steps += __atomic_load_n(&bs->Walker[i].Steps, __ATOMIC_RELAXED);
+    }
+    progress_report(&bs->Progress,
+                    steps,
+                    0,
+                    __atomic_load_n(&bs->Finished, __ATOMIC_RELAXED),
+                    bs->Config.Keys * bs->Config.Orbits,
+                    __atomic_load_n(&bs->Walker[0].X, __ATOMIC_RELAXED));
+}
+
+void
+bscycle_run(struct BsCycleSearch* bs)
+{
+    const struct BsCycleConfig* cfg = &bs->Config;
+    unsigned                    n = cfg->Threads, i;
+    uint64_t                    orbits = cfg->Keys * cfg->Orbits, limit = 0;
+
+    if (cfg->MaxSteps != 0 && orbits <= UINT64_MAX / cfg->MaxSteps)
+        limit = orbits * cfg->MaxSteps;
+    progress_start(&bs->Progress, 0, limit);
+
+    // Fewer threads than that would leave lanes empty
+    if (n > (orbits + BS_LANES - 1) / BS_LANES)
+        n = (unsigned)((orbits + BS_LANES - 1) / BS_LANES);
+    if (n == 0)
+        n = 1;
+
+    for (i = 0; i < n; i++) {
+        bs->Walker[i].Search = bs;
+    }
+    pool_run(&bs->Pool,
+             worker,
+             bs->Walker,
+             sizeof(struct BsWalker),
+             n,
+             cfg->ProgressEvery,
+             report_progress,
+             bs);
+}
+
+void
+bscycle_summary(const struct BsCycleSearch* bs,
+                unsigned                    key,
+                struct BsSummary*           sum)
+{
+    const struct LaneOrbit* orbit = &bs->Orbit[key * bs->Config.Orbits];
+    uint64_t                i;
+
+    sum->Closed   = 0;
+    sum->Shortest = UINT64_MAX;
+    sum->Longest  = 0;
+    sum->Steps    = 0;
+    for (i = 0; i < bs->Config.Orbits; i++) {
+        sum->Steps += orbit[i].Steps;
+        if (!orbit[i].Closed)
+            continue;
+        sum->Closed++;
+        if (orbit[i].Steps < sum->Shortest)
+            sum->Shortest = orbit[i].Steps;
+        if (orbit[i].Steps > sum->Longest)
+            sum->Longest = orbit[i].Steps;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * Bitsliced cycle walks, 64 orbits per thread
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * Every thread holds 64 orbits in the lanes of a bitsliced state and steps
+ * them together with bs_walk(), which compares every lane with its start
+ * after each step. An orbit that comes back to its start, or that runs out of
+ * steps, hands its lane to the next starting plaintext, so all lanes stay
+ * busy until the orbits run out.
+ *
+ * Unlike the distinguished point search of cycle.h this needs no table and
+ * tells the exact length of every closed orbit, but it walks each cycle once
+ * for every orbit started on it, and a cycle longer than MaxSteps is only
+ * seen as open.
+ *
+ * The same orbits can be walked under several keys at once, say the walk keys
+ * of one key schedule cut to different round counts. All lanes of a state
+ * share a key, so a thread fills its lanes with orbits of one key until they
+ * are all taken, then goes on to the next key that has orbits left. Threads
+ * start on different keys, so they seldom wait on each other.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include "bitslice.h"
+#include "lanes.h"
+#include "progress.h"
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct BsCycleConfig
+{
+    const struct BsWalkKey* Key;           // Keys of them
+    unsigned                Keys;          // 0 is taken as 1
+    uint64_t                FirstStart;    // orbit i starts at FirstStart + i
+    uint64_t                Orbits;        // per key
+    uint64_t                MaxSteps;      // per orbit, 0 for no limit
+    unsigned                Threads;       // 0 for one per core
+    unsigned                ProgressEvery; // seconds, 0 for none
+};
+
+// The orbits of one key after a search
+struct BsSummary
+{
+    uint64_t Closed;   // orbits
+    uint64_t Shortest; // cycle among the closed orbits, UINT64_MAX for none
+    uint64_t Longest;  // 0 for none
+    uint64_t Steps;    // walked by all orbits
+};
+
+struct BsCycleSearch;
+
+struct BsWalker
+{
+    struct BsCycleSearch* Search;
+    uint64_t              Steps; // summed over the lanes, for progress reports
+    uint64_t              X;     // the value of one lane
+};
+
+struct BsCycleSearch
+{
+    struct BsCycleConfig Config;
+    struct LaneOrbit*    Orbit;     // orbit i of key k at k * Orbits + i
+    uint64_t*            NextOrbit; // per key, shared by the threads
+    uint64_t             Finished;
+    struct Progress      Progress;
+
+    struct BsWalker*  Walker;
+    struct WorkerPool Pool;
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+// Returns 0 on success, -1 if memory could not be allocated
+int
+bscycle_init(struct BsCycleSearch* bs, const struct BsCycleConfig* config);
+
+void
+bscycle_free(struct BsCycleSearch* bs);
+
+// Walks all orbits on Config.Threads threads, the results go to Orbit
+void
+bscycle_run(struct BsCycleSearch* bs);
+
+void
+bscycle_summary(const struct BsCycleSearch* bs,
+                unsigned                    key,
+                struct BsSummary*           sum);
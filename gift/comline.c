@@ -18,23 +18,138 @@
 
 #include "comline.h"
 
+// Long options without a short form
+enum
+{
+    OPT_ORBITS = 256,
+    OPT_THREADS,
+    OPT_DP_BITS,
+    OPT_TABLE_BITS,
+    OPT_MAX_STEPS,
+    OPT_CHECKPOINT,
+    OPT_CHECKPOINT_EVERY,
+    OPT_RESUME,
+    OPT_BENCH,
+    OPT_PROGRESS,
+    OPT_BITSLICE,
+    OPT_WIDTH,
+    OPT_BIDIRECTIONAL,
+    OPT_STORE,
+    OPT_SWEEP_ROUNDS,
+    OPT_HUNT,
+    OPT_SUBSPACE,
+    OPT_KEYS,
+    OPT_MODE
+};
+
+static const struct option LongOptions[] = {
+    { "orbits", required_argument, NULL, OPT_ORBITS },
+    { "threads", required_argument, NULL, OPT_THREADS },
+    { "dp-bits", required_argument, NULL, OPT_DP_BITS },
+    { "table-bits", required_argument, NULL, OPT_TABLE_BITS },
+    { "max-steps", required_argument, NULL, OPT_MAX_STEPS },
+    { "checkpoint", required_argument, NULL, OPT_CHECKPOINT },
+    { "checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY },
+    { "resume", no_argument, NULL, OPT_RESUME },
+    { "bench", no_argument, NULL, OPT_BENCH },
+    { "progress", required_argument, NULL, OPT_PROGRESS },
+    { "bitslice", no_argument, NULL, OPT_BITSLICE },
+    { "width", required_argument, NULL, OPT_WIDTH },
+    { "bidirectional", no_argument, NULL, OPT_BIDIRECTIONAL },
+    { "store", required_argument, NULL, OPT_STORE },
+    { "sweep-rounds", required_argument, NULL, OPT_SWEEP_ROUNDS },
+    { "hunt", required_argument, NULL, OPT_HUNT },
+    { "subspace", required_argument, NULL, OPT_SUBSPACE },
+    { "keys", required_argument, NULL, OPT_KEYS },
+    { "mode", required_argument, NULL, OPT_MODE },
+    { NULL, 0, NULL, 0 }
+};
+
 //----------------------------------
 // Functions
 //----------------------------------
+// A decimal (or 0x hexadecimal) number from min to max
+static _Bool
+parse_number(const char* arg, uint64_t min, uint64_t max, uint64_t* value)
+{
+    char* end;
+
+    if (arg == NULL || *arg == '\0' || *arg == '-')
+        return 0;
+    *value = strtoull(arg, &end, 0);
+    return *end == '\0' && *value >= min && *value <= max;
+}
+
+// A list of round counts and ranges of them, as in 1-8,12,16, as a mask with
+// bit r - 1 set for r rounds
+static _Bool
+parse_rounds(const char* arg, uint64_t* mask)
+{
+    unsigned long first, last;
+    char*         end;
+
+    *mask = 0;
+    for (;;) {
+        if (*arg < '0' || *arg > '9')
+            return 0;
+        first = last = strtoul(arg, &end, 10);
+        if (*end == '-') {
+            arg = end + 1;
+            if (*arg < '0' || *arg > '9')
+                return 0;
+            last = strtoul(arg, &end, 10);
+        }
+        if (first == 0 || first > last || last > 47)
+            return 0;
+        for (; first <= last; first++) {
+            *mask |= (uint64_t)1 << (first - 1);
+        }
+        if (*end == '\0')
+            return 1;
+        if (*end != ',')
+            return 0;
+        arg = end + 1;
+    }
+}
+
 void
 comline_fetch_options(struct Options* sOpt, int argc, char** const argv)
 {
     int   c;
     _Bool Opt_Decrypt = 0, Opt_Encrypt = 0, Opt_File = 0, Opt_Verbose = 0;
+    _Bool Opt_SelfTest = 0;
     char *Opt_Text = NULL, *Opt_Key = NULL, *Opt_Rounds = NULL;
     FILE *KeyFile = NULL, *TextFile = NULL;
 
-    sOpt->Error       = 0;
-    sOpt->Verbose     = 1;
-    sOpt->BlockSize64 = 1;
+    uint64_t Number; // argument of a long option
+
+    sOpt->Error           = 0;
+    sOpt->Verbose         = 1;
+    sOpt->BlockSize64     = 1;
+    sOpt->SelfTest        = 0;
+    sOpt->Chaining        = Chain_None;
+    sOpt->Orbits          = 0;
+    sOpt->MaxSteps        = 0;
+    sOpt->Threads         = 0;
+    sOpt->DpBits          = 24;
+    sOpt->TableBits       = 20;
+    sOpt->Checkpoint      = NULL;
+    sOpt->CheckpointEvery = 600;
+    sOpt->Resume          = 0;
+    sOpt->Bench           = 0;
+    sOpt->ProgressEvery   = 60;
+    sOpt->Bitslice        = 0;
+    sOpt->Width           = 0;
+    sOpt->Bidirectional   = 0;
+    sOpt->Store           = NULL;
+    sOpt->SweepRounds     = 0;
+    sOpt->Hunt            = 0;
+    sOpt->Subspace        = 0xFFFFFFFF;
+    sOpt->Keys            = 0;
 
     // Process the command line options
-    while ((c = getopt(argc, argv, "defv:r:k:t:")) != -1) {
+    while ((c = getopt_long(
+              argc, argv, "defsv:r:k:t:", LongOptions, NULL)) != -1) {
         switch (c) {
             case 'd':
                 if (Opt_Encrypt || Opt_Decrypt)
@@ -54,6 +169,12 @@ comline_fetch_options(struct Options* sOpt, int argc, char** const argv)
                 else
                     Opt_File = 1;
                 break;
+            case 's':
+                if (Opt_SelfTest)
+                    sOpt->Error = 1;
+                else
+                    Opt_SelfTest = 1;
+                break;
             case 'v':
                 if (Opt_Verbose)
                     sOpt->Error = 1;
@@ -88,6 +209,110 @@ comline_fetch_options(struct Options* sOpt, int argc, char** const argv)
                 else
                     Opt_Text = optarg;
                 break;
+            case OPT_ORBITS:
+                if (parse_number(optarg, 1, UINT64_MAX, &Number))
+                    sOpt->Orbits = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_THREADS:
+                if (parse_number(optarg, 1, 4096, &Number))
+                    sOpt->Threads = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_DP_BITS:
+                if (parse_number(optarg, 1, 63, &Number))
+                    sOpt->DpBits = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_TABLE_BITS:
+                if (parse_number(optarg, 4, 40, &Number))
+                    sOpt->TableBits = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_MAX_STEPS:
+                if (parse_number(optarg, 1, UINT64_MAX, &Number))
+                    sOpt->MaxSteps = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_CHECKPOINT:
+                if (sOpt->Checkpoint != NULL)
+                    sOpt->Error = 1;
+                else
+                    sOpt->Checkpoint = optarg;
+                break;
+            case OPT_CHECKPOINT_EVERY:
+                if (parse_number(optarg, 1, 86400 * 7, &Number))
+                    sOpt->CheckpointEvery = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_RESUME:
+                sOpt->Resume = 1;
+                break;
+            case OPT_BENCH:
+                sOpt->Bench = 1;
+                break;
+            case OPT_PROGRESS:
+                if (parse_number(optarg, 0, 86400 * 7, &Number))
+                    sOpt->ProgressEvery = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_BITSLICE:
+                sOpt->Bitslice = 1;
+                break;
+            case OPT_WIDTH:
+                if (parse_number(optarg, 1, 64, &Number))
+                    sOpt->Width = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_BIDIRECTIONAL:
+                sOpt->Bidirectional = 1;
+                break;
+            case OPT_STORE:
+                if (sOpt->Store != NULL)
+                    sOpt->Error = 1;
+                else
+                    sOpt->Store = optarg;
+                break;
+            case OPT_SWEEP_ROUNDS:
+                if (!parse_rounds(optarg, &sOpt->SweepRounds))
+                    sOpt->Error = 1;
+                break;
+            case OPT_HUNT:
+                if (parse_number(optarg, 1, UINT32_MAX, &Number))
+                    sOpt->Hunt = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_SUBSPACE:
+                if (parse_number(optarg, 1, UINT64_MAX - 1, &Number))
+                    sOpt->Subspace = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_KEYS:
+                if (parse_number(optarg, 1, UINT32_MAX, &Number))
+                    sOpt->Keys = Number;
+                else
+                    sOpt->Error = 1;
+                break;
+            case OPT_MODE:
+                if (strcmp(optarg, "ecb") == 0)
+                    sOpt->Chaining = Chain_ECB;
+                else if (strcmp(optarg, "cbc") == 0)
+                    sOpt->Chaining = Chain_CBC;
+                else if (strcmp(optarg, "ctr") == 0)
+                    sOpt->Chaining = Chain_CTR;
+                else
+                    sOpt->Error = 1;
+                break;
             case '?':
                 sOpt->Error = 1;
                 break;
@@ -95,6 +320,52 @@ comline_fetch_options(struct Options* sOpt, int argc, char** const argv)
     }
     // Finished parsing command-line options
 
+    // A checkpointed search walks at least the orbit of the text, and only
+    // a checkpointed search can be resumed
+    if (sOpt->Checkpoint != NULL && sOpt->Orbits == 0)
+        sOpt->Orbits = 1;
+    if (sOpt->Resume && sOpt->Checkpoint == NULL)
+        sOpt->Error = 1;
+
+    // The round sweep walks bitsliced, under every round count at once
+    if (sOpt->SweepRounds != 0)
+        sOpt->Bitslice = 1;
+
+    // The bitsliced search fills all 64 lanes by default, and has no table
+    // to checkpoint
+    if (sOpt->Bitslice && sOpt->Orbits == 0)
+        sOpt->Orbits = 64;
+    if (sOpt->Bitslice && sOpt->Checkpoint != NULL)
+        sOpt->Error = 1;
+
+    // Known cycles are kept by distinguished point, so only the table search
+    // uses a store, and it walks at least the orbit of the text
+    if (sOpt->Store != NULL && sOpt->Bitslice)
+        sOpt->Error = 1;
+    if (sOpt->Store != NULL && sOpt->Orbits == 0)
+        sOpt->Orbits = 1;
+
+    // The bidirectional walk follows the orbit of the text alone
+    if (sOpt->Bidirectional && (sOpt->Orbits != 0 || sOpt->Bitslice))
+        sOpt->Error = 1;
+
+    // The hunt tries every text of the subspace instead of walking orbits
+    if (sOpt->Hunt != 0 &&
+        (sOpt->Orbits != 0 || sOpt->Bidirectional || sOpt->Width != 0))
+        sOpt->Error = 1;
+
+    // The key-sliced walk follows the orbit of the text alone, under every
+    // key at once
+    if (sOpt->Keys != 0 && (sOpt->Orbits != 0 || sOpt->Bidirectional ||
+                            sOpt->Width != 0 || sOpt->Hunt != 0))
+        sOpt->Error = 1;
+
+    // The self-test needs no key or text
+    if (Opt_SelfTest) {
+        sOpt->SelfTest = 1;
+        return;
+    }
+
     // Set Error if Parameters missing
     if (Opt_Key == NULL || Opt_Text == NULL ||
         (!(Opt_Decrypt || Opt_Encrypt))) {
@@ -215,6 +486,13 @@ comline_fetch_options(struct Options* sOpt, int argc, char** const argv)
         else
             sOpt->Mode = Decrypt_Mode;
 
+        // GIFT-128 only has the plain multi-orbit walk
+        if (!sOpt->BlockSize64 &&
+            (sOpt->Checkpoint != NULL || sOpt->Store != NULL ||
+             sOpt->Bitslice || sOpt->Bidirectional || sOpt->Width != 0 ||
+             sOpt->Hunt != 0))
+            sOpt->Error = 1;
+
         // Read key and text (file mode)make
     }
 }
@@ -22,17 +22,49 @@ struct Options
     _Bool    Mode;
     _Bool    KeySize80;
     _Bool    BlockSize64;
+    _Bool    SelfTest;
+    uint8_t  Chaining; // mode of operation for blocks on stdin, see below
     uint8_t  Verbose;
     uint64_t KeyHigh;
     uint64_t KeyLow;
     uint64_t Text;
     uint64_t TextHigh;
     uint16_t Rounds;
+
+    // Parallel cycle search of giftCycle, off while Orbits is 0
+    uint64_t Orbits;
+    uint64_t MaxSteps;
+    uint16_t Threads;
+    uint8_t  DpBits;
+    uint8_t  TableBits;
+    _Bool    Bench;         // steps per second of the walk kernels
+    uint32_t ProgressEvery; // seconds between progress reports, 0 for none
+    _Bool    Bitslice;      // 64 orbits per thread, see bscycle.h
+    uint8_t  Width;         // decompose GIFT cut to this width, 0 for off
+    _Bool    Bidirectional; // walk the text both ways, see bidir.h
+    uint64_t SweepRounds;   // bit r - 1 to sweep r rounds, 0 for off
+    uint64_t Hunt;          // longest cycle hunted for, 0 for off
+    uint64_t Subspace;      // bits of the text the hunt varies
+    uint64_t Keys;          // keys walked at once key-sliced, 0 for off
+
+    // Checkpoints of the cycle search, off while Checkpoint is NULL
+    const char* Checkpoint;
+    uint32_t    CheckpointEvery; // seconds
+    _Bool       Resume;
+
+    // Store of known cycles, off while NULL
+    const char* Store;
 };
 
 #define Encrypt_Mode 1
 #define Decrypt_Mode 0
 
+// Chaining of gift --mode, Chain_None for the one block of -t
+#define Chain_None 0
+#define Chain_ECB 1
+#define Chain_CBC 2
+#define Chain_CTR 3
+
 //----------------------------------
 // Function prototype
 //----------------------------------
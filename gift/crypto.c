@@ -11,14 +11,144 @@
 #include "crypto.h"
 #include "bits.h"
 #include "boxes.h"
+#include "slice128.h"
 //#include "verbose.h" // For verbose output
 
 //#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 //----------------------------------
 // Key Scheduling
 //----------------------------------
+// Moves bit j of a 16-bit key word to bit 4 * j
+static uint64_t
+spread16(uint64_t x)
+{
+    x &= 0xFFFF;
+    x = (x | (x << 24)) & 0x000000FF000000FF;
+    x = (x | (x << 12)) & 0x000F000F000F000F;
+    x = (x | (x << 6)) & 0x0303030303030303;
+    x = (x | (x << 3)) & 0x1111111111111111;
+    return x;
+}
+
+// One round of the key state update, on the 8 16-bit words of the key
+#define KEY_STATE_UPDATE(keyState)                                             \
+    do {                                                                       \
+        uint16_t T6_ = rotateRight16Bit(keyState[0], 12);                      \
+        uint16_t T7_ = rotateRight16Bit(keyState[1], 2);                       \
+        int      j_;                                                           \
+        for (j_ = 0; j_ < 6; j_++) {                                           \
+            keyState[j_] = keyState[j_ + 2];                                   \
+        }                                                                      \
+        keyState[6] = T6_;                                                     \
+        keyState[7] = T7_;                                                     \
+    } while (0)
+
+static void
+key_state_init(uint16_t keyState[8], uint64_t key_high, uint64_t key_low)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        // Initlize 128 bit key into 8 16-bit keystates
+        keyState[i]     = ((key_low >> (i * 16)) & 0xffff);
+        keyState[i + 4] = ((key_high >> (i * 16)) & 0xffff);
+    }
+}
+
+// Round constant bits at the locations of the 64-bit block
+static uint64_t
+round_constant(uint16_t RoundNr)
+{
+    uint64_t constant = 0;
+    int      j;
+
+    for (j = 0; j < 6; j++) {
+        constant = setBit(constant, getBit(Constants[RoundNr], j),
+                          ConstantsLocation[j]);
+    }
+    return constant;
+}
+
+void
+key_schedule_init(struct KeySchedule* ks,
+                  uint64_t            key_high,
+                  uint64_t            key_low,
+                  uint16_t            Rounds,
+                  _Bool               KeySize80)
+{
+    uint16_t keyState[8];
+    uint16_t i;
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    ks->Rounds = Rounds;
+
+    // GIFT has no 80-bit key schedule, leave the keys empty
+    if (KeySize80) {
+        for (i = 0; i < Rounds; i++) {
+            ks->Subkey[i] = 0;
+        }
+        return;
+    }
+
+    key_state_init(keyState, key_high, key_low);
+    for (i = 0; i < Rounds; i++) {
+        // U goes to bit 1 and V to bit 0 of every nibble, the constant to
+        // bit 3 of the low nibbles and always having 1 on bit 63
+        ks->Subkey[i] = (spread16(keyState[1]) << 1) | spread16(keyState[0]) |
+                        round_constant(i) | ((uint64_t)1 << 63);
+        KEY_STATE_UPDATE(keyState);
+    }
+}
+
+void
+key_schedule128_init(struct KeySchedule* ks,
+                     uint64_t            key_high,
+                     uint64_t            key_low,
+                     uint16_t            Rounds)
+{
+    uint16_t keyState[8];
+    uint16_t i;
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    ks->Rounds = Rounds;
+
+    key_state_init(keyState, key_high, key_low);
+    for (i = 0; i < Rounds; i++) {
+        // U = keyState[5..4] to bit 2 and V = keyState[1..0] to bit 1 of
+        // every nibble, the low halves into the first word
+        ks->Subkey[2 * i] = (spread16(keyState[4]) << 2) |
+                            (spread16(keyState[0]) << 1) | round_constant(i);
+        ks->Subkey[2 * i + 1] = (spread16(keyState[5]) << 2) |
+                                (spread16(keyState[1]) << 1) |
+                                ((uint64_t)1 << 63);
+        KEY_STATE_UPDATE(keyState);
+    }
+}
+
+void
+key_schedule_batch(struct KeySchedule* ks,
+                   const uint64_t*     key_high,
+                   const uint64_t*     key_low,
+                   size_t              n,
+                   uint16_t            Rounds,
+                   _Bool               BlockSize64)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        if (BlockSize64)
+            key_schedule_init(&ks[i], key_high[i], key_low[i], Rounds, 0);
+        else
+            key_schedule128_init(&ks[i], key_high[i], key_low[i], Rounds);
+    }
+}
+
+// Heap-allocated versions of the above, to be freed by the caller
 uint64_t*
 key_schedule(uint64_t key_high,
              uint64_t key_low,
@@ -26,139 +156,34 @@ key_schedule(uint64_t key_high,
              _Bool    KeySize80,
              _Bool    Output)
 {
-    // uint64_t temp64;
-    uint64_t i;
-
-    uint64_t* subkey = (uint64_t*)malloc(Rounds * sizeof(uint64_t));
+    struct KeySchedule ks;
+    uint64_t*          subkey = (uint64_t*)malloc(Rounds * sizeof(uint64_t));
 
     if (subkey != NULL) {
-        // if(Output) v_key_start();
-
-        if (KeySize80) {
-            // printf(
-            //  "ERROR: key needs to be 128-bit for the GIFT block cipher\n");
-            // exit(1);
-        } else { // 128 Bit
-
-            // if(Output) v_k128_init(key_high, key_low);
-            uint16_t keyState[8];
-            for (i = 0; i < 4; i++) {
-
-                // Initlize 128 bit key into 8 16-bit keystates
-                keyState[i]     = ((key_low >> (i * 16)) & 0xffff);
-                keyState[i + 4] = ((key_high >> (i * 16)) & 0xffff);
-            }
-
-            for (i = 0; i < Rounds; i++) {
-                subkey[i]  = 0;
-                uint16_t U = keyState[1];
-                uint16_t V = keyState[0];
-                // uint8_t  roundConstant = Constants[i];
-
-                // printf("U in round %i value: %i\n", i, U);
-                // printf("V in round %i value: %i\n", i, V);
-
-                int j;
-                for (j = 0; j < 16; j++) {
-                    // Putting keystate into the subkey
-                    subkey[i] = setBit(subkey[i], getBit(U, j), (4 * j + 1));
-                    subkey[i] = setBit(subkey[i], getBit(V, j), (4 * j));
-                }
-                // printf("Constant for round %i value :%i\n",i,Constants[i]);
-
-                for (j = 0; j < 6; j++) {
-                    subkey[i] = setBit(
-                      subkey[i], getBit(Constants[i], j), ConstantsLocation[j]);
-                    // The addition of the round constants of the round key
-                }
-
-                // always having 1 on the blockSize-1 round key
-                subkey[i] = setBit(subkey[i], 0x01, 63);
-
-                // below is the update of the key state.
-                uint16_t keyStateUpdated[8];
-                keyStateUpdated[7] = rotateRight16Bit(keyState[1], 2);
-                keyStateUpdated[6] = rotateRight16Bit(keyState[0], 12);
-                keyStateUpdated[5] = keyState[7];
-                keyStateUpdated[4] = keyState[6];
-                keyStateUpdated[3] = keyState[5];
-                keyStateUpdated[2] = keyState[4];
-                keyStateUpdated[1] = keyState[3];
-                keyStateUpdated[0] = keyState[2];
-
-                for (j = 0; j < 8; j++) {
-                    keyState[j] = keyStateUpdated[j];
-                }
-            }
-        }
-        //  //if(Output) v_final();
-    } else {
-        // printf("RAM problem!\n");
+        key_schedule_init(&ks, key_high, key_low, Rounds, KeySize80);
+        memcpy(subkey, ks.Subkey, ks.Rounds * sizeof(uint64_t));
     }
     return subkey;
 }
 
+// Always holds at least the 40 rounds encrypt128() uses
 uint64_t*
 key_schedule128(uint64_t key_high,
                 uint64_t key_low,
                 uint16_t Rounds,
                 _Bool    Output)
 {
-    uint64_t i;
-
-    uint64_t* subkey = (uint64_t*)malloc(Rounds * 2 * sizeof(uint64_t));
-    uint16_t  keyState[8];
-
-    for (i = 0; i < 4; i++) {
-        // Initlize 128 bit key into 8 16-bit keystates
-        keyState[i]     = ((key_low >> (i * 16)) & 0xffff);
-        keyState[i + 4] = ((key_high >> (i * 16)) & 0xffff);
-    }
-    for (i = 0; i < 40; i++) {
-        subkey[2 * i]       = 0;
-        subkey[(2 * i) + 1] = 0;
-        uint32_t U          = 0;
-        uint32_t V          = 0;
-
-        U = ((uint32_t)keyState[5] << 16) | (uint32_t)(keyState[4]);
-        V = ((uint32_t)keyState[1] << 16) | (uint32_t)(keyState[0]);
-
-        int j;
-
-        for (j = 0; j < 16; j++) {
-            subkey[2 * i] = setBit(subkey[2 * i], getBit(U, j), (4 * j + 2));
-            subkey[2 * i] = setBit(subkey[2 * i], getBit(V, j), (4 * j + 1));
-            // Putting keystate into the subkey
-            subkey[2 * i + 1] =
-              setBit(subkey[2 * i + 1], getBit(U, (j + 16)), (4 * j + 2));
-            subkey[2 * i + 1] =
-              setBit(subkey[2 * i + 1], getBit(V, (j + 16)), (4 * j + 1));
-        }
+    struct KeySchedule ks;
+    uint64_t*          subkey;
 
-        for (j = 0; j < 6; j++) {
-            subkey[2 * i] = setBit(
-              subkey[2 * i], getBit(Constants[i], j), ConstantsLocation[j]);
-            // The addition of the round constants of the round key
-        }
+    if (Rounds < 40)
+        Rounds = 40;
+    subkey = (uint64_t*)malloc(Rounds * 2 * sizeof(uint64_t));
 
-        // always having 1 on the blockSize-1 round key
-        subkey[2 * i + 1] = setBit(subkey[2 * i + 1], 0x01, 63);
-
-        uint16_t keyStateUpdated[8];
-        keyStateUpdated[7] = rotateRight16Bit(keyState[1], 2);
-        keyStateUpdated[6] = rotateRight16Bit(keyState[0], 12);
-        keyStateUpdated[5] = keyState[7];
-        keyStateUpdated[4] = keyState[6];
-        keyStateUpdated[3] = keyState[5];
-        keyStateUpdated[2] = keyState[4];
-        keyStateUpdated[1] = keyState[3];
-        keyStateUpdated[0] = keyState[2];
-
-        for (j = 0; j < 8; j++) {
-            keyState[j] = keyStateUpdated[j];
-        }
+    if (subkey != NULL) {
+        key_schedule128_init(&ks, key_high, key_low, Rounds);
+        memcpy(subkey, ks.Subkey, ks.Rounds * 2 * sizeof(uint64_t));
     }
-
     return subkey;
 }
 
@@ -211,6 +236,34 @@ encrypt(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise)
     return text;
 }
 
+void
+block128_key(struct Block128Key* bk, const uint64_t* subkey, uint16_t Rounds)
+{
+    uint16_t RoundNr, n;
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    bk->Rounds = Rounds;
+
+    n = Rounds < 40 ? 40 : Rounds;
+    for (RoundNr = 0; RoundNr < n; RoundNr++) {
+        slice128_key(
+          bk->Slice[RoundNr], subkey[2 * RoundNr + 1], subkey[2 * RoundNr]);
+    }
+}
+
+// Always 40 rounds, whatever bk->Rounds says. The slice128 functions only
+// read the keys.
+void
+encrypt128_block(struct Block128* block, const struct Block128Key* bk)
+{
+    uint32_t S[4];
+
+    slice128_pack(S, block->High, block->Low);
+    slice128_encrypt(S, (uint32_t(*)[4])bk->Slice, 40);
+    slice128_unpack(S, &block->High, &block->Low);
+}
+
 uint64_t*
 encrypt128(uint64_t  inHigh,
            uint64_t  inLow,
@@ -219,69 +272,14 @@ encrypt128(uint64_t  inHigh,
            _Bool     Roundwise)
 
 {
-    uint64_t* retVal = (uint64_t*)malloc(2 * sizeof(uint64_t));
+    uint64_t*          retVal = (uint64_t*)malloc(2 * sizeof(uint64_t));
+    struct Block128    block  = { inLow, inHigh };
+    struct Block128Key bk;
 
-// note outHigh is the same is inHigh the same goes with low.
-#define outHigh inHigh
-#define outLow inLow
-    uint16_t RoundNr;
-    uint64_t textHigh = inHigh;
-    uint64_t textLow  = inLow;
-
-    for (RoundNr = 0; RoundNr < 40; RoundNr++) {
-
-        uint16_t temp;
-
-        for (SboxNr = 0; SboxNr < 16; SboxNr++) {
-            uint16_t SboxValHigh;
-            uint16_t SboxValLow;
-
-            SboxValHigh = textHigh & 0x0F;
-            SboxValLow  = textLow & 0x0F;
-            // get lowest nibble
-            textHigh &= 0xFFFFFFFFFFFFFFF0;
-            textLow &= 0xFFFFFFFFFFFFFFF0; // kill lowest nibble
-
-            textHigh |= Sbox[SboxValHigh];
-            textLow |= Sbox[SboxValLow]; // put new value to lowest nibble
-                                         // (sbox)
-
-            textHigh = rotate4l_64(textHigh);
-            textLow  = rotate4l_64(textLow); // next(rotate by one nibble)
-        }
-
-        outHigh = 0;
-        outLow  = 0;
-
-        // The four cases that they could permute differnetly form text to
-        // output
-        for (PBit = 0; PBit < 128; PBit++) {
-            uint8_t bitNum = Pbox128[PBit];
-            if (PBit < 64) {
-
-                if (bitNum < 64) {
-                    outLow = setBit(outLow, getBit(textLow, PBit), bitNum);
-                } else {
-                    outHigh =
-                      setBit(outHigh, getBit(textLow, PBit), (bitNum - 64));
-                }
-
-            } else {
-                if (bitNum < 64) {
-                    outLow =
-                      setBit(outLow, getBit(textHigh, (PBit - 64)), bitNum);
-                } else {
-                    outHigh = setBit(
-                      outHigh, getBit(textHigh, (PBit - 64)), (bitNum - 64));
-                }
-            }
-        }
-
-        textLow  = inLow  ^ subkey[2 * RoundNr];
-        textHigh = inHigh ^ subkey[2 * RoundNr + 1];
-    }
-    retVal[0] = textLow;
-    retVal[1] = textHigh;
+    block128_key(&bk, subkey, Rounds);
+    encrypt128_block(&block, &bk);
+    retVal[0] = block.Low;
+    retVal[1] = block.High;
 
     return retVal;
 }
@@ -298,7 +296,7 @@ decrypt(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise)
 {
 #define out in
     uint16_t RoundNr;
-    uint64_t text;
+    uint64_t text = in;
 
     // if (Roundwise)
     // v_dec_start(in);
@@ -355,6 +353,25 @@ decrypt(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise)
     return text;
 }
 
+// Rounds - 1 inverse rounds with keys Rounds - 1 down to 1, then the first
+// round key, as in decrypt()
+void
+decrypt128_block(struct Block128* block, const struct Block128Key* bk)
+{
+    uint32_t S[4];
+    uint16_t b;
+
+    if (bk->Rounds == 0)
+        return;
+
+    slice128_pack(S, block->High, block->Low);
+    slice128_decrypt(S, (uint32_t(*)[4])bk->Slice + 1, bk->Rounds - 1);
+    for (b = 0; b < 4; b++) {
+        S[b] ^= bk->Slice[0][b];
+    }
+    slice128_unpack(S, &block->High, &block->Low);
+}
+
 uint64_t*
 decrypt128(uint64_t  inHigh,
            uint64_t  inLow,
@@ -363,86 +380,114 @@ decrypt128(uint64_t  inHigh,
            _Bool     Roundwise)
 
 {
-    uint64_t* retVal = (uint64_t*)malloc(2 * sizeof(uint64_t));
+    uint64_t*          retVal = (uint64_t*)malloc(2 * sizeof(uint64_t));
+    struct Block128    block  = { inLow, inHigh };
+    struct Block128Key bk;
 
-#define outHigh inHigh
-#define outLow inLow
-    uint16_t RoundNr;
-    uint64_t textHigh;
-    uint64_t textLow;
-    uint16_t temp;
-    // if (Roundwise)
-    // v_dec_start128(inHigh, inLow);
+    block128_key(&bk, subkey, Rounds);
+    decrypt128_block(&block, &bk);
+    retVal[0] = block.Low;
+    retVal[1] = block.High;
 
-    // XOR operation
+    return retVal;
+}
+// End decryption
 
-    for (RoundNr = 1; RoundNr <= Rounds; RoundNr++) {
-        // if (Roundwise)
-        // v_roundstart128(RoundNr,
-        //                subkey[(2 * Rounds) - (2 * (RoundNr)) + 1],
-        //                subkey[(2 * Rounds) - (2 * (RoundNr))]);
-        // printf("Decyrption key low:%i key high
-        // %i\n",((2*Rounds)-(2*(RoundNr))),(2*Rounds)-(2*(RoundNr))+1);
-        textHigh = inHigh ^ subkey[(2 * Rounds) - (2 * (RoundNr)) + 1];
-        textLow  = inLow ^ subkey[(2 * Rounds) - (2 * (RoundNr))];
+//----------------------------------
+// Table-driven encryption
+//----------------------------------
+// S-Layer and P-Layer fused into one lookup per input byte, after the
+// pBox8_* tables of the 32-bit PRESENT implementation. The tables are built
+// from the boxes by table_init(), once, before any thread uses them.
+
+static uint64_t spBox8[8][256];   // P(S(byte << 8i))
+static uint64_t psBoxInv8[8][256]; // PInv(SInv(byte << 8i))
+static uint64_t pBoxInv8[8][256]; // PInv(byte << 8i)
+static uint8_t  sBoxInv8[256];    // SInv on both nibbles of a byte
+static _Bool    TablesReady = 0;
+
+// Same bit order as the P-Box loops in encrypt() and decrypt()
+static uint64_t
+pbox_apply(uint64_t text, const uint8_t* box)
+{
+    uint64_t result = 0;
+    uint16_t bit;
 
-        // if (Roundwise)
-        // v_after_xor128(textHigh, textLow);
-
-        // In the last round nly the textHigh and textLow are used that
-        // is why retVal gets text rather tahn out.
-        outHigh = 0;
-        outLow  = 0;
-
-        for (PBit = 0; PBit < 128; PBit++) {
-            uint8_t bitNum = Pbox128Inv[PBit];
-            if (PBit < 64) {
-
-                if (bitNum < 64) {
-                    outLow = setBit(outLow, getBit(textLow, PBit), bitNum);
-                } else {
-                    outHigh =
-                      setBit(outHigh, getBit(textLow, PBit), (bitNum - 64));
-                }
-
-            } else {
-                if (bitNum < 64) {
-                    outLow =
-                      setBit(outLow, getBit(textHigh, (PBit - 64)), bitNum);
-                } else {
-                    outHigh = setBit(
-                      outHigh, getBit(textHigh, (PBit - 64)), (bitNum - 64));
-                }
-            }
-        }
-        // if (Roundwise)
-        // v_after_p128(outHigh, outLow);
+    for (bit = 0; bit < 64; bit++) {
+        result = rotate1l_64(result);
+        result |= ((text >> (63 - box[bit])) & 1);
+    }
+    return result;
+}
 
-        for (SboxNr = 0; SboxNr < 16; SboxNr++) {
-            uint16_t SboxValHigh;
-            uint16_t SboxValLow;
-            SboxValHigh = outHigh & 0x0F;
-            SboxValLow  = outLow & 0x0F;
-            // get lowest nibble
-            outHigh &= 0xFFFFFFFFFFFFFFF0;
-            outLow &= 0xFFFFFFFFFFFFFFF0; // kill lowest nibble
-
-            outHigh |= SboxInv[SboxValHigh];
-            outLow |= SboxInv[SboxValLow];
-            // put new value to lowest nibble (sbox)
-
-            outHigh = rotate4l_64(outHigh);
-            outLow  = rotate4l_64(outLow); // next(rotate by one nibble)
+void
+table_init(void)
+{
+    uint16_t i, v;
+
+    if (TablesReady)
+        return;
+
+    for (v = 0; v < 256; v++) {
+        uint8_t s    = (Sbox[v >> 4] << 4) | Sbox[v & 0x0F];
+        uint8_t sInv = (SboxInv[v >> 4] << 4) | SboxInv[v & 0x0F];
+
+        sBoxInv8[v] = sInv;
+        for (i = 0; i < 8; i++) {
+            spBox8[i][v]    = pbox_apply((uint64_t)s << (8 * i), Pbox);
+            psBoxInv8[i][v] = pbox_apply((uint64_t)sInv << (8 * i), PboxInv);
+            pBoxInv8[i][v]  = pbox_apply((uint64_t)v << (8 * i), PboxInv);
         }
-        // if (Roundwise)
-        // v_after_s128(outHigh, outLow);
     }
-    // if (Roundwise)
-    // v_final();
+    TablesReady = 1;
+}
 
-    retVal[1] = textHigh;
-    retVal[0] = textLow;
+#define LOOKUP8(table, x)                                                      \
+    (table[0][(x)&0xFF] ^ table[1][((x) >> 8) & 0xFF] ^                        \
+     table[2][((x) >> 16) & 0xFF] ^ table[3][((x) >> 24) & 0xFF] ^             \
+     table[4][((x) >> 32) & 0xFF] ^ table[5][((x) >> 40) & 0xFF] ^             \
+     table[6][((x) >> 48) & 0xFF] ^ table[7][(x) >> 56])
 
-    return retVal;
+uint64_t
+encrypt_table(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise)
+{
+    uint16_t RoundNr;
+    uint64_t text = in;
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        text = LOOKUP8(spBox8, text) ^ subkey[RoundNr - 1];
+    }
+    return text;
 }
-// End decryption
+
+// decrypt() computes SInv(PInv(text ^ key)) each round. Because PInv is
+// linear the key can be moved behind it, which keeps the state in the PInv
+// domain and lets one lookup per byte cover SInv and the next PInv:
+//     PInv(SInv(u) ^ key) = psBoxInv8(u) ^ PInv(key)
+// PInv(key) does not depend on the state, so it overlaps with the lookups.
+uint64_t
+decrypt_table(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise)
+{
+    uint16_t RoundNr, i;
+    uint64_t text, sLayer;
+
+    if (Rounds == 0)
+        return in;
+    if (Rounds == 1)
+        return in ^ subkey[0];
+
+    text = in ^ subkey[Rounds - 1];
+    text = LOOKUP8(pBoxInv8, text);
+    for (RoundNr = 2; RoundNr < Rounds; RoundNr++) {
+        uint64_t key = subkey[Rounds - RoundNr];
+        text         = LOOKUP8(psBoxInv8, text) ^ LOOKUP8(pBoxInv8, key);
+    }
+
+    // Final inverse S-Layer on its own, then the first round key
+    sLayer = 0;
+    for (i = 0; i < 8; i++) {
+        sLayer |= (uint64_t)sBoxInv8[(text >> (8 * i)) & 0xFF] << (8 * i);
+    }
+    return sLayer ^ subkey[0];
+}
+// End table-driven encryption
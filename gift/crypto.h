@@ -9,6 +9,7 @@
  */
 
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
 #define KEY_LENGTH 16
@@ -21,12 +22,66 @@
     0x3c, 0x2f, 0xec, 0xdf, 0x34, 0x12, 0xab, 0xab}
     */
 
+#define MAX_ROUNDS 47
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+// Expanded round keys in caller-owned storage. GIFT-64 uses one word per
+// round, GIFT-128 two (low word first). Each context starts on its own cache
+// line, so an array of them from key_schedule_batch() is cache-aligned too.
+struct KeySchedule
+{
+    uint64_t Subkey[2 * MAX_ROUNDS];
+    uint16_t Rounds;
+} __attribute__((aligned(64)));
+
+// A GIFT-128 block in caller-owned storage, for the in-place functions
+struct Block128
+{
+    uint64_t Low;
+    uint64_t High;
+};
+
+// GIFT-128 round keys in the slice layout of slice128.c, converted once by
+// block128_key() for any number of blocks. Holds the 40 rounds encryption
+// always runs and the Rounds of decryption.
+struct Block128Key
+{
+    uint32_t Slice[MAX_ROUNDS][4];
+    uint16_t Rounds;
+};
+
+//----------------------------------
+// Lookup tables (defined in boxes.h, compiled into crypto.c)
+//----------------------------------
+extern const uint8_t Sbox[16];
+extern const uint8_t SboxInv[16];
+extern const uint8_t Pbox[64];
+extern const uint8_t PboxInv[64];
+extern const uint8_t Pbox128[128];
+extern const uint8_t Pbox128Inv[128];
+extern const uint8_t Constants[48];
+extern const uint8_t ConstantsLocation[6];
+
 //----------------------------------
 // Function prototypes
 //----------------------------------
 uint64_t
 encrypt(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise);
 
+// subkey has to hold at least 40 rounds, as for encrypt128()
+void
+block128_key(struct Block128Key* bk, const uint64_t* subkey, uint16_t Rounds);
+
+// In-place GIFT-128, with the same results as encrypt128() and decrypt128()
+void
+encrypt128_block(struct Block128* block, const struct Block128Key* bk);
+
+void
+decrypt128_block(struct Block128* block, const struct Block128Key* bk);
+
+// The same, returning a malloc'd array {low, high} the caller has to free
 uint64_t*
 encrypt128(uint64_t  inHigh,
            uint64_t  inLow,
@@ -44,6 +99,39 @@ decrypt128(uint64_t  inHigh,
            uint16_t  Rounds,
            _Bool     Roundwise);
 
+// Builds the tables of encrypt_table() and decrypt_table(). Has to be called
+// before them, while no other thread uses them; later calls do nothing.
+void
+table_init(void);
+
+uint64_t
+encrypt_table(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise);
+
+uint64_t
+decrypt_table(uint64_t in, uint64_t* subkey, uint16_t Rounds, _Bool Roundwise);
+
+void
+key_schedule_init(struct KeySchedule* ks,
+                  uint64_t            key_high,
+                  uint64_t            key_low,
+                  uint16_t            Rounds,
+                  _Bool               KeySize80);
+
+void
+key_schedule128_init(struct KeySchedule* ks,
+                     uint64_t            key_high,
+                     uint64_t            key_low,
+                     uint16_t            Rounds);
+
+// Expands n keys into ks[0..n-1], for GIFT-64 or GIFT-128
+void
+key_schedule_batch(struct KeySchedule* ks,
+                   const uint64_t*     key_high,
+                   const uint64_t*     key_low,
+                   size_t              n,
+                   uint16_t            Rounds,
+                   _Bool               BlockSize64);
+
 uint64_t*
 key_schedule(uint64_t key_high,
              uint64_t key_low,
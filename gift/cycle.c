@@ -0,0 +1,794 @@
+/**
+ * Parallel cycle search over the GIFT-64 permutation
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cycle.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CLAIM_TAKEN -1 // someone claimed the point before
+#define CLAIM_FULL -2  // no room left in the table
+
+#define WALK_FIRST -1          // Slot of a walk before its first point
+#define CHECK_STEPS (1 << 20) // steps between looks at the pause flag
+
+//----------------------------------
+// Distinguished point table
+//----------------------------------
+// Distinguished points are zero at the top, so they are mixed before their
+// top bits are used as the slot
+static uint64_t
+dp_slot(const struct CycleSearch* cs, uint64_t point)
+{
+    return (point * 0x9E3779B97F4A7C15) >> (64 - cs->Config.TableBits);
+}
+
+// Linear probing. A point is claimed by swapping it into a free slot, so of
+// all the threads reaching the same point exactly one gets its entry.
+static int64_t
+dp_claim(struct CycleSearch* cs, uint64_t point)
+{
+    uint64_t tag  = point | DP_USED;
+    uint64_t slot = dp_slot(cs, point);
+    uint64_t probe;
+
+    for (probe = 0; probe <= cs->TableMask; probe++) {
+        struct DPEntry* entry = &cs->Table[slot];
+        uint64_t        seen =
+          __atomic_load_n(&entry->Point, __ATOMIC_ACQUIRE);
+
+        if (seen == 0) {
+            // Keep the load factor at 3/4, probing slows down after that
+            if (__atomic_add_fetch(&cs->Points, 1, __ATOMIC_RELAXED) >
+                cs->TableMask / 4 * 3) {
+                __atomic_sub_fetch(&cs->Points, 1, __ATOMIC_RELAXED);
+                __atomic_store_n(&cs->TableFull, 1, __ATOMIC_RELAXED);
+                return CLAIM_FULL;
+            }
+            if (__atomic_compare_exchange_n(&entry->Point,
+                                            &seen,
+                                            tag,
+                                            0,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE))
+                return (int64_t)slot;
+            __atomic_sub_fetch(&cs->Points, 1, __ATOMIC_RELAXED);
+        }
+        if (seen == tag)
+            return CLAIM_TAKEN;
+        slot = (slot + 1) & cs->TableMask;
+    }
+    return CLAIM_FULL;
+}
+
+// Only used while no walker runs
+static int64_t
+dp_find(const struct CycleSearch* cs, uint64_t point)
+{
+    uint64_t tag  = point | DP_USED;
+    uint64_t slot = dp_slot(cs, point);
+    uint64_t probe;
+
+    for (probe = 0; probe <= cs->TableMask; probe++) {
+        if (cs->Table[slot].Point == tag)
+            return (int64_t)slot;
+        if (cs->Table[slot].Point == 0)
+            break;
+        slot = (slot + 1) & cs->TableMask;
+    }
+    return -1;
+}
+
+//----------------------------------
+// Walking
+//----------------------------------
+// Stops the walks while a checkpoint is written, with their states in
+// wk->State for it
+static void
+walk_pause(struct CycleSearch* cs, struct Walker* wk)
+{
+    pthread_mutex_lock(&cs->Pool.Lock);
+    wk->Saved = 1;
+    cs->Paused++;
+    pthread_cond_broadcast(&cs->Pool.Changed);
+    while (cs->Pause) {
+        pthread_cond_wait(&cs->Resume, &cs->Pool.Lock);
+    }
+    cs->Paused--;
+    wk->Saved = 0;
+    pthread_mutex_unlock(&cs->Pool.Lock);
+}
+
+// Up to n steps of every lane, all by the same number, stopping after the
+// first step that brings an active lane to a distinguished point or to its
+// stop value. Lanes outside active are left alone without a kernel, and
+// copy an active lane with one.
+static uint64_t
+advance(const struct CycleConfig* cfg,
+        uint64_t                  x[WALK_LANES],
+        const uint64_t            stop[WALK_LANES],
+        uint64_t                  n,
+        uint64_t                  dpMask,
+        unsigned                  active)
+{
+    uint64_t i;
+    unsigned l, hit;
+
+    if (cfg->Walk != NULL)
+        return cfg->Walk(x, stop, n, dpMask, cfg->WalkKey);
+
+    i = 0;
+    do {
+        hit = 0;
+        for (l = 0; l < WALK_LANES; l++) {
+            if (!(active >> l & 1))
+                continue;
+            x[l] = cfg->Cipher(x[l], cfg->Key);
+            hit |= (x[l] & dpMask) == 0 || x[l] == stop[l];
+        }
+        i++;
+    } while (!hit && i < n);
+    return i;
+}
+
+// The representative of a cycle without distinguished points. Such cycles are
+// rare and short, so it is cheaper to go around once more than to keep track
+// of the smallest value on every step.
+static uint64_t
+cycle_min(const struct CycleConfig* cfg, uint64_t start)
+{
+    uint64_t x = start, min = start;
+
+    do {
+        x = cfg->Cipher(x, cfg->Key);
+        if (x < min)
+            min = x;
+    } while (x != start);
+    return min;
+}
+
+// Acts on where the last steps took w: its first distinguished point, the end
+// of an arc or the start again. A walk just past a claim sits on the claimed
+// point with Arc 0, which is not the end of the next arc. Returns whether the
+// walk is over.
+static _Bool
+walk_event(struct CycleSearch* cs, struct WalkState* w, uint64_t dpMask)
+{
+    const struct CycleConfig* cfg = &cs->Config;
+    struct OrbitResult*       res = &cs->Orbit[w->Orbit];
+    uint64_t                  start = cfg->FirstStart + w->Orbit;
+
+    if ((w->X & dpMask) == 0 && (w->Slot == WALK_FIRST || w->Arc != 0)) {
+        if (w->Slot == WALK_FIRST) {
+            res->Point = w->X;
+            if (cfg->Store != NULL && dp_store_find(cfg->Store, w->X) != NULL) {
+                res->State = ORBIT_KNOWN;
+                return 1;
+            }
+            res->State = ORBIT_POINT;
+        } else {
+            cs->Table[w->Slot].Next = w->X;
+            __atomic_store_n(
+              &cs->Table[w->Slot].Distance, w->Arc, __ATOMIC_RELEASE);
+        }
+        w->Slot  = dp_claim(cs, w->X);
+        w->Point = w->X;
+        w->Arc   = 0;
+        if (w->Slot < 0 || __atomic_load_n(&cs->TableFull, __ATOMIC_RELAXED))
+            return 1;
+    } else if (w->Slot == WALK_FIRST && w->X == start && w->Steps != 0) {
+        res->State = ORBIT_CLOSED;
+        res->Point = cycle_min(cfg, start);
+        return 1;
+    }
+    return cfg->MaxSteps != 0 && w->Steps == cfg->MaxSteps;
+}
+
+// Ends a walk. A report in between may miss its steps, but never counts them
+// twice.
+static void
+walk_done(struct CycleSearch* cs, struct Walker* wk, const struct WalkState* w)
+{
+    cs->Orbit[w->Orbit].Steps = w->Steps;
+    __atomic_fetch_sub(&wk->Steps, w->Steps, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&cs->Steps, w->Steps, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&cs->Finished, 1, __ATOMIC_RELAXED);
+}
+
+// Gives lane a walk: one resumed from a checkpoint, or else a new orbit. A
+// walk that is over before its first step is finished at once, and the lane
+// taken out of Active if no walk is left.
+static void
+walk_take(struct CycleSearch* cs, struct Walker* wk, unsigned lane)
+{
+    struct WalkState* w      = &wk->State[lane];
+    uint64_t          dpMask = ~(uint64_t)0 << (64 - cs->Config.DpBits);
+    uint64_t          i;
+
+    for (;;) {
+        i = __atomic_fetch_add(&cs->NextPending, 1, __ATOMIC_RELAXED);
+        if (i < cs->PendingCount) {
+            *w = cs->Pending[i];
+        } else {
+            i = __atomic_fetch_add(&cs->NextOrbit, 1, __ATOMIC_RELAXED);
+            if (i >= cs->Config.Orbits) {
+                wk->Active &= ~(1u << lane);
+                return;
+            }
+            w->Orbit = i;
+            w->X     = cs->Config.FirstStart + i;
+            w->Steps = 0;
+            w->Arc   = 0;
+            w->Slot  = WALK_FIRST;
+            w->Point = 0;
+        }
+
+        // Walks resumed past their first point have their result set already
+        if (w->Slot == WALK_FIRST)
+            cs->Orbit[w->Orbit].State = ORBIT_OPEN;
+        wk->Active |= 1u << lane;
+        __atomic_fetch_add(&wk->Steps, w->Steps, __ATOMIC_RELAXED);
+        if (!walk_event(cs, w, dpMask))
+            return;
+        walk_done(cs, wk, w);
+    }
+}
+
+// The lanes step together, so a chunk of steps ends at the first event in
+// any of them, and at most after CHECK_STEPS, when the walker looks for a
+// pause. A lane whose walk is over takes the next one.
+static void*
+worker(void* arg)
+{
+    struct Walker*            wk     = arg;
+    struct CycleSearch*       cs     = wk->Search;
+    const struct CycleConfig* cfg    = &cs->Config;
+    uint64_t                  dpMask = ~(uint64_t)0 << (64 - cfg->DpBits);
+    uint64_t                  x[WALK_LANES], stop[WALK_LANES], n, chunk;
+    struct WalkState*         w;
+    unsigned                  l, first;
+
+    wk->Active = 0;
+    for (l = 0; l < WALK_LANES; l++) {
+        walk_take(cs, wk, l);
+    }
+
+    while (wk->Active != 0) {
+        if (__atomic_load_n(&cs->Pause, __ATOMIC_RELAXED))
+            walk_pause(cs, wk);
+
+        first = __builtin_ctz(wk->Active);
+        chunk = CHECK_STEPS;
+        for (l = 0; l < WALK_LANES; l++) {
+            w       = &wk->State[wk->Active >> l & 1 ? l : first];
+            x[l]    = w->X;
+            stop[l] = w->Slot == WALK_FIRST ? cfg->FirstStart + w->Orbit : 0;
+            if (cfg->MaxSteps != 0 && cfg->MaxSteps - w->Steps < chunk)
+                chunk = cfg->MaxSteps - w->Steps;
+        }
+
+        n = advance(cfg, x, stop, chunk, dpMask, wk->Active);
+        __atomic_fetch_add(&wk->Steps,
+                           n * (uint64_t)__builtin_popcount(wk->Active),
+                           __ATOMIC_RELAXED);
+        __atomic_store_n(&wk->X, x[first], __ATOMIC_RELAXED);
+
+        for (l = 0; l < WALK_LANES; l++) {
+            if (!(wk->Active >> l & 1))
+                continue;
+            w    = &wk->State[l];
+            w->X = x[l];
+            w->Steps += n;
+            if (w->Slot != WALK_FIRST)
+                w->Arc += n;
+            if (walk_event(cs, w, dpMask)) {
+                walk_done(cs, wk, w);
+                walk_take(cs, wk, l);
+            }
+        }
+    }
+
+    pool_done(&cs->Pool);
+    return NULL;
+}
+
+//----------------------------------
+// Setup
+//----------------------------------
+int
+cycle_search_init(struct CycleSearch* cs, const struct CycleConfig* config)
+{
+    memset(cs, 0, sizeof(*cs));
+    cs->Config    = *config;
+    cs->TableMask = ((uint64_t)1 << config->TableBits) - 1;
+    if (cs->Config.Threads == 0) {
+        long cores          = sysconf(_SC_NPROCESSORS_ONLN);
+        cs->Config.Threads = cores > 0 ? (unsigned)cores : 1;
+    }
+    pool_init(&cs->Pool);
+    pthread_cond_init(&cs->Resume, NULL);
+
+    cs->Table  = calloc(cs->TableMask + 1, sizeof(struct DPEntry));
+    cs->Orbit  = calloc(config->Orbits ? config->Orbits : 1,
+                       sizeof(struct OrbitResult));
+    cs->Walker = calloc(cs->Config.Threads, sizeof(struct Walker));
+    if (cs->Table == NULL || cs->Orbit == NULL || cs->Walker == NULL) {
+        cycle_search_free(cs);
+        return -1;
+    }
+    return 0;
+}
+
+void
+cycle_search_free(struct CycleSearch* cs)
+{
+    free(cs->Table);
+    free(cs->Orbit);
+    free(cs->Walker);
+    free(cs->Pending);
+    cs->Table   = NULL;
+    cs->Orbit   = NULL;
+    cs->Walker  = NULL;
+    cs->Pending = NULL;
+    pool_free(&cs->Pool);
+    pthread_cond_destroy(&cs->Resume);
+}
+
+// Stops all walkers, writes the checkpoint and lets them go on. Called with
+// the lock held.
+static void
+pause_and_save(struct CycleSearch* cs)
+{
+    __atomic_store_n(&cs->Pause, 1, __ATOMIC_RELAXED);
+    while (cs->Paused < cs->Pool.Running) {
+        pthread_cond_wait(&cs->Pool.Changed, &cs->Pool.Lock);
+    }
+    if (cycle_checkpoint_save(cs) != 0)
+        cs->CheckpointErrors++;
+    __atomic_store_n(&cs->Pause, 0, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&cs->Resume);
+}
+
+// Steps of the finished walks and of those under way. Called with the lock
+// held.
+static void
+report_progress(struct CycleSearch* cs)
+{
+    uint64_t steps = __atomic_load_n(&cs->Steps, __ATOMIC_RELAXED);
+    unsigned i;
+
+    for (i = 0; i < cs->Config.Threads; i++) {
+        steps += __atomic_load_n(&cs->Walker[i].Steps, __ATOMIC_RELAXED);
+    }
+    progress_report(&cs->Progress,
+                    steps,
+                    __atomic_load_n(&cs->Points, __ATOMIC_RELAXED),
+                    __atomic_load_n(&cs->Finished, __ATOMIC_RELAXED),
+                    cs->Config.Orbits,
+                    __atomic_load_n(&cs->Walker[0].X, __ATOMIC_RELAXED));
+}
+
+// The calling thread only looks after the walkers: it wakes up for every
+// checkpoint and progress report, and writes a last one of each when they are
+// done. If no thread can be started it walks the orbits itself.
+void
+cycle_search_run(struct CycleSearch* cs)
+{
+    const struct CycleConfig* cfg = &cs->Config;
+    unsigned                  n = cfg->Threads, i;
+    time_t                    nextSave, nextReport, until;
+    uint64_t                  steps = cs->Steps, limit = 0, walks;
+
+    // A resumed walk reports the steps it made before the checkpoint again
+    for (i = 0; i < cs->PendingCount; i++) {
+        steps += cs->Pending[i].Steps;
+    }
+    if (cfg->MaxSteps != 0 && cfg->Orbits <= UINT64_MAX / cfg->MaxSteps)
+        limit = cfg->Orbits * cfg->MaxSteps;
+    progress_start(&cs->Progress, steps, limit);
+
+    // Fewer threads than that would leave lanes empty
+    walks = cfg->Orbits + cs->PendingCount;
+    if (n > (walks + WALK_LANES - 1) / WALK_LANES)
+        n = (unsigned)((walks + WALK_LANES - 1) / WALK_LANES);
+    if (n == 0)
+        n = 1;
+
+    for (i = 0; i < n; i++) {
+        cs->Walker[i].Search = cs;
+    }
+    pool_start(&cs->Pool, worker, cs->Walker, sizeof(struct Walker), n);
+
+    nextSave   = pool_now() + cfg->CheckpointEvery;
+    nextReport = pool_now() + cfg->ProgressEvery;
+    for (;;) {
+        if (cfg->Checkpoint == NULL)
+            until = cfg->ProgressEvery != 0 ? nextReport : 0;
+        else if (cfg->ProgressEvery == 0 || nextSave < nextReport)
+            until = nextSave;
+        else
+            until = nextReport;
+        if (!pool_wait(&cs->Pool, until))
+            break;
+
+        if (cfg->Checkpoint != NULL && pool_now() >= nextSave) {
+            pause_and_save(cs);
+            nextSave = pool_now() + cfg->CheckpointEvery;
+        }
+        if (cfg->ProgressEvery != 0 && pool_now() >= nextReport) {
+            report_progress(cs);
+            nextReport = pool_now() + cfg->ProgressEvery;
+        }
+    }
+    pool_join(&cs->Pool);
+
+    if (cfg->ProgressEvery != 0)
+        report_progress(cs);
+
+    if (cfg->Checkpoint != NULL && cycle_checkpoint_save(cs) != 0)
+        cs->CheckpointErrors++;
+}
+
+//----------------------------------
+// Checkpoints
+//----------------------------------
+// The header is followed by the orbit results, the walks that were under way
+// and the used table entries
+struct CheckpointHeader
+{
+    char     Magic[8];
+    uint64_t KeyHigh;
+    uint64_t KeyLow;
+    uint64_t FirstStart;
+    uint64_t Orbits;
+    uint64_t MaxSteps;
+    uint64_t NextOrbit;
+    uint64_t Steps;
+    uint64_t Pending;
+    uint64_t Points;
+    uint16_t Rounds;
+    uint8_t  Decrypt;
+    uint8_t  DpBits;
+};
+
+static const char CheckpointMagic[8] = {
+    'G', 'I', 'F', 'T', 'C', 'Y', 'C', '3'
+};
+
+// Written to a temporary file that replaces the old checkpoint only once it
+// is complete and on disk, so a crash leaves one or the other
+int
+cycle_checkpoint_save(struct CycleSearch* cs)
+{
+    const struct CycleConfig* cfg = &cs->Config;
+    struct CheckpointHeader   hdr;
+    struct WalkState*         pending;
+    char*                     tmp;
+    FILE*                     f;
+    uint64_t                  e, i;
+    unsigned                  l;
+    int                       ok;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.Magic, CheckpointMagic, sizeof(hdr.Magic));
+    hdr.KeyHigh    = cfg->KeyHigh;
+    hdr.KeyLow     = cfg->KeyLow;
+    hdr.FirstStart = cfg->FirstStart;
+    hdr.Orbits     = cfg->Orbits;
+    hdr.MaxSteps   = cfg->MaxSteps;
+    hdr.NextOrbit  = cs->NextOrbit < cfg->Orbits ? cs->NextOrbit : cfg->Orbits;
+    hdr.Steps      = cs->Steps;
+    hdr.Rounds     = cfg->Rounds;
+    hdr.Decrypt    = cfg->Decrypt;
+    hdr.DpBits     = cfg->DpBits;
+
+    // Paused walks, and resumed ones no thread has picked up yet
+    pending = malloc((cfg->Threads * WALK_LANES + cs->PendingCount) *
+                     sizeof(*pending));
+    if (pending == NULL)
+        return -1;
+    for (i = 0; i < cfg->Threads; i++) {
+        for (l = 0; cs->Walker[i].Saved && l < WALK_LANES; l++) {
+            if (cs->Walker[i].Active >> l & 1)
+                pending[hdr.Pending++] = cs->Walker[i].State[l];
+        }
+    }
+    for (i = cs->NextPending; i < cs->PendingCount; i++) {
+        pending[hdr.Pending++] = cs->Pending[i];
+    }
+    for (e = 0; e <= cs->TableMask; e++) {
+        hdr.Points += cs->Table[e].Point != 0;
+    }
+
+    tmp = malloc(strlen(cfg->Checkpoint) + 5);
+    if (tmp == NULL) {
+        free(pending);
+        return -1;
+    }
+    sprintf(tmp, "%s.tmp", cfg->Checkpoint);
+
+    f  = fopen(tmp, "wb");
+    ok = f != NULL;
+    ok = ok && fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    ok = ok && fwrite(cs->Orbit, sizeof(*cs->Orbit), cfg->Orbits, f) ==
+                 cfg->Orbits;
+    ok = ok && fwrite(pending, sizeof(*pending), hdr.Pending, f) == hdr.Pending;
+    for (e = 0; ok && e <= cs->TableMask; e++) {
+        if (cs->Table[e].Point != 0)
+            ok = fwrite(&cs->Table[e], sizeof(struct DPEntry), 1, f) == 1;
+    }
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (f != NULL)
+        ok = (fclose(f) == 0) && ok;
+    ok = ok && rename(tmp, cfg->Checkpoint) == 0;
+    if (!ok)
+        remove(tmp);
+
+    free(tmp);
+    free(pending);
+    return ok ? 0 : -1;
+}
+
+int
+cycle_checkpoint_load(struct CycleSearch* cs)
+{
+    const struct CycleConfig* cfg = &cs->Config;
+    struct CheckpointHeader   hdr;
+    struct DPEntry            entry;
+    FILE*                     f;
+    uint64_t                  i;
+    int                       ret = CHECKPOINT_CORRUPT;
+
+    f = fopen(cfg->Checkpoint, "rb");
+    if (f == NULL)
+        return CHECKPOINT_NONE;
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(hdr.Magic, CheckpointMagic, sizeof(hdr.Magic)) != 0)
+        goto out;
+    if (hdr.KeyHigh != cfg->KeyHigh || hdr.KeyLow != cfg->KeyLow ||
+        hdr.Rounds != cfg->Rounds || hdr.Decrypt != cfg->Decrypt ||
+        hdr.FirstStart != cfg->FirstStart || hdr.Orbits != cfg->Orbits ||
+        hdr.MaxSteps != cfg->MaxSteps || hdr.DpBits != cfg->DpBits) {
+        ret = CHECKPOINT_MISMATCH;
+        goto out;
+    }
+
+    if (fread(cs->Orbit, sizeof(*cs->Orbit), hdr.Orbits, f) != hdr.Orbits)
+        goto out;
+    cs->Pending =
+      malloc((hdr.Pending ? hdr.Pending : 1) * sizeof(*cs->Pending));
+    if (cs->Pending == NULL ||
+        fread(cs->Pending, sizeof(*cs->Pending), hdr.Pending, f) != hdr.Pending)
+        goto out;
+
+    // The table may have a different size this time
+    for (i = 0; i < hdr.Points; i++) {
+        int64_t slot;
+
+        if (fread(&entry, sizeof(entry), 1, f) != 1)
+            goto out;
+        slot = dp_claim(cs, entry.Point & ~DP_USED);
+        if (slot < 0)
+            goto out;
+        cs->Table[slot].Next     = entry.Next;
+        cs->Table[slot].Distance = entry.Distance;
+    }
+
+    // The points moved with the table, the walks follow them
+    for (i = 0; i < hdr.Pending; i++) {
+        if (cs->Pending[i].Slot == WALK_FIRST)
+            continue;
+        cs->Pending[i].Slot = dp_find(cs, cs->Pending[i].Point);
+        if (cs->Pending[i].Slot < 0)
+            goto out;
+    }
+
+    cs->PendingCount = hdr.Pending;
+    cs->NextOrbit    = hdr.NextOrbit;
+    cs->Finished     = hdr.NextOrbit - hdr.Pending;
+    cs->Steps        = hdr.Steps;
+    ret              = CHECKPOINT_RESUMED;
+
+out:
+    fclose(f);
+    return ret;
+}
+
+//----------------------------------
+// Census
+//----------------------------------
+static int
+compare_cycles(const void* a, const void* b)
+{
+    const struct CycleInfo* x = a;
+    const struct CycleInfo* y = b;
+
+    if (x->Complete != y->Complete)
+        return x->Complete ? -1 : 1;
+    if (x->Length != y->Length)
+        return x->Length > y->Length ? -1 : 1;
+    return (x->Representative > y->Representative) -
+           (x->Representative < y->Representative);
+}
+
+static int
+compare_orbits(const void* a, const void* b)
+{
+    const struct OrbitResult* x = a;
+    const struct OrbitResult* y = b;
+
+    return (x->Point > y->Point) - (x->Point < y->Point);
+}
+
+// Appends to a growing array of cycles, NULL when memory runs out
+static struct CycleInfo*
+add_cycle(struct CycleInfo* list, uint64_t* count, uint64_t* size)
+{
+    if (*count == *size) {
+        struct CycleInfo* grown;
+
+        *size = *size ? 2 * *size : 64;
+        grown = realloc(list, *size * sizeof(struct CycleInfo));
+        if (grown == NULL) {
+            free(list);
+            return NULL;
+        }
+        list = grown;
+    }
+    memset(&list[*count], 0, sizeof(struct CycleInfo));
+    list[*count].Representative = UINT64_MAX;
+    (*count)++;
+    return list;
+}
+
+struct CycleInfo*
+cycle_census(struct CycleSearch* cs, uint64_t* count)
+{
+    struct CycleInfo*   cycles = NULL;
+    struct OrbitResult* closed = NULL;
+    uint64_t*           id; // 1 + index into cycles, 0 if not yet seen
+    uint64_t            size = 0, nClosed = 0;
+    uint64_t            e, o;
+
+    *count = 0;
+    id     = calloc(cs->TableMask + 1, sizeof(uint64_t));
+    if (id == NULL)
+        return NULL;
+
+    // Follow the arcs from every point not seen yet. A path either comes back
+    // to where it started (a cycle), runs into a path seen before (and joins
+    // it), or ends at an arc that was not walked to the end (open).
+    for (e = 0; e <= cs->TableMask; e++) {
+        uint64_t c, cur, join = 0;
+        int64_t  next;
+
+        if (cs->Table[e].Point == 0 || id[e] != 0)
+            continue;
+
+        cycles = add_cycle(cycles, count, &size);
+        if (cycles == NULL)
+            goto fail;
+        c = *count;
+
+        for (cur = e;; cur = (uint64_t)next) {
+            id[cur] = c;
+            if (cs->Table[cur].Distance == 0)
+                break;
+            next = dp_find(cs, cs->Table[cur].Next);
+            if (next < 0)
+                break;
+            if (id[next] == c) {
+                cycles[c - 1].Complete = 1;
+                break;
+            }
+            if (id[next] != 0) {
+                join = id[next];
+                break;
+            }
+        }
+
+        // Relabel the path as part of the one it ran into
+        if (join != 0) {
+            for (cur = e; id[cur] == c;
+                 cur = (uint64_t)dp_find(cs, cs->Table[cur].Next)) {
+                id[cur] = join;
+            }
+            (*count)--;
+        }
+    }
+
+    for (e = 0; e <= cs->TableMask; e++) {
+        struct CycleInfo* ci;
+        uint64_t          point = cs->Table[e].Point & ~DP_USED;
+
+        if (cs->Table[e].Point == 0)
+            continue;
+        ci = &cycles[id[e] - 1];
+        if (point < ci->Representative)
+            ci->Representative = point;
+        ci->Length += cs->Table[e].Distance;
+    }
+
+    // Orbits go with the cycle of their first point. Those that came back to
+    // their start without one are counted once per smallest value, and so are
+    // those on a stored cycle, by its representative (a distinguished point,
+    // which the former cycles have none of).
+    closed = malloc((cs->Config.Orbits ? cs->Config.Orbits : 1) *
+                    sizeof(struct OrbitResult));
+    if (closed == NULL)
+        goto fail;
+    for (o = 0; o < cs->Config.Orbits; o++) {
+        const struct OrbitResult* res = &cs->Orbit[o];
+        const struct StoredPoint* known = NULL;
+        int64_t                   slot;
+
+        if (res->State == ORBIT_CLOSED) {
+            closed[nClosed++] = *res;
+            continue;
+        }
+        if (res->State == ORBIT_KNOWN && cs->Config.Store != NULL)
+            known = dp_store_find(cs->Config.Store, res->Point);
+        if (known != NULL) {
+            closed[nClosed].Point =
+              cs->Config.Store->Cycle[known->Cycle].Representative;
+            closed[nClosed++].Steps =
+              cs->Config.Store->Cycle[known->Cycle].Length;
+            continue;
+        }
+        slot = res->State == ORBIT_POINT ? dp_find(cs, res->Point) : -1;
+        if (slot >= 0) {
+            cycles[id[slot] - 1].Starts++;
+            continue;
+        }
+
+        // Stopped before its first point: an open chain of its own
+        cycles = add_cycle(cycles, count, &size);
+        if (cycles == NULL)
+            goto fail;
+        cycles[*count - 1].Length         = res->Steps;
+        cycles[*count - 1].Representative = cs->Config.FirstStart + o;
+        cycles[*count - 1].Starts         = 1;
+    }
+
+    qsort(closed, nClosed, sizeof(*closed), compare_orbits);
+    for (o = 0; o < nClosed; o++) {
+        if (o > 0 && closed[o].Point == closed[o - 1].Point) {
+            cycles[*count - 1].Starts++;
+            continue;
+        }
+        cycles = add_cycle(cycles, count, &size);
+        if (cycles == NULL)
+            goto fail;
+        cycles[*count - 1].Length         = closed[o].Steps;
+        cycles[*count - 1].Representative = closed[o].Point;
+        cycles[*count - 1].Starts         = 1;
+        cycles[*count - 1].Complete       = 1;
+    }
+
+    free(closed);
+    free(id);
+    if (*count == 0) {
+        free(cycles);
+        return NULL;
+    }
+    qsort(cycles, *count, sizeof(*cycles), compare_cycles);
+    return cycles;
+
+fail:
+    free(closed);
+    free(id);
+    free(cycles);
+    *count = 0;
+    return NULL;
+}
@@ -0,0 +1,199 @@
+/**
+ * Parallel cycle search over the GIFT-64 permutation
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * Many orbits are walked at once on all cores. A thread keeps WALK_LANES
+ * walks going through the lanes of the walk kernel (see walk.h), and for each
+ * lane takes the next starting plaintext when its walk is over. A walk
+ * iterates the cipher until it reaches a distinguished point, a value with
+ * DpBits leading zero bits, which it claims in a table shared by all
+ * threads. From a point it claimed it walks on to the next
+ * distinguished point, records that arc (next point and distance) in the
+ * entry, and claims the new point. The walk stops at the first point that is
+ * already claimed: the cycle from there on is walked by the orbit that owns
+ * it, so no part of a cycle is walked twice.
+ *
+ * The cipher is a permutation, so the arcs of a cycle close into a ring and
+ * the cycle length is the sum of their distances. The representative of a
+ * cycle is its smallest distinguished point, which does not depend on the
+ * starting plaintexts. Cycles without any distinguished point are found by
+ * the walk coming back to its start, and represented by their smallest value.
+ *
+ * With a checkpoint file set the search is saved every CheckpointEvery
+ * seconds and when it ends: the walkers are paused, the table, the orbit
+ * results and the walks under way go to a temporary file, which then
+ * replaces the checkpoint. Walkers only look for a pause between chunks of
+ * steps, so the hot loop does not change. cycle_checkpoint_load() continues
+ * from such a file.
+ *
+ * With a store of known cycles (see dpstore.h) a walk whose first
+ * distinguished point is stored stops there: its cycle was walked all the way
+ * round by an earlier run, and the census takes the cycle from the store.
+ *
+ * Progress reports work the same way: after every chunk a walker stores its
+ * step count and current value, and every ProgressEvery seconds the thread
+ * that started the search adds them up for progress_report().
+ *
+ */
+
+#pragma once
+#include <pthread.h>
+#include <stdint.h>
+
+#include "dpstore.h"
+#include "fixslice.h"
+#include "progress.h"
+#include "walk.h"
+
+// Set in the Point of used table entries; distinguished points never have it
+#define DP_USED 0x8000000000000000
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct CycleConfig
+{
+    UnrolledCipher        Cipher;
+    struct UnrolledKey*   Key;
+    WalkKernel            Walk;       // NULL to step with Cipher
+    const struct WalkKey* WalkKey;
+    uint64_t              FirstStart; // orbit i starts at FirstStart + i
+    uint64_t              Orbits;
+    uint64_t              MaxSteps;   // per orbit, 0 for no limit
+    unsigned              Threads;    // 0 for one per core
+    uint8_t               DpBits;     // 1 to 63
+    uint8_t               TableBits;  // table of 2^TableBits entries
+
+    // Checkpoints, off if Checkpoint is NULL. The key and the cipher are
+    // saved with them, so a checkpoint is never resumed for another search.
+    const char* Checkpoint;
+    unsigned    CheckpointEvery; // seconds
+    uint64_t    KeyHigh;
+    uint64_t    KeyLow;
+    uint16_t    Rounds;
+    _Bool       Decrypt;
+
+    // Progress reports, see progress.h
+    unsigned ProgressEvery; // seconds, 0 for none
+
+    // Cycles known from earlier runs, NULL for none
+    const struct DpStore* Store;
+};
+
+// Arcs have a Distance of 0 until the owner has walked them
+struct DPEntry
+{
+    uint64_t Point; // the distinguished point | DP_USED, 0 if free
+    uint64_t Next;
+    uint64_t Distance;
+};
+
+enum OrbitState
+{
+    ORBIT_OPEN   = 0, // ran out of steps before a distinguished point
+    ORBIT_POINT  = 1, // reached the distinguished point Point
+    ORBIT_CLOSED = 2, // came back to its start first, Point is the smallest
+    ORBIT_KNOWN  = 3  // reached Point, which is on a cycle in the store
+};
+
+struct OrbitResult
+{
+    uint64_t Point;
+    uint64_t Steps;
+    uint8_t  State;
+};
+
+// Where a walk is. Slot is the entry of the arc being walked, or -1 before
+// the first distinguished point. Point is the point of that entry: a resumed
+// search rebuilds the table, so its slot is looked up again.
+struct WalkState
+{
+    uint64_t Orbit;
+    uint64_t X;
+    uint64_t Steps;
+    uint64_t Arc; // steps into the arc
+    int64_t  Slot;
+    uint64_t Point;
+};
+
+struct CycleSearch;
+
+struct Walker
+{
+    struct CycleSearch* Search;
+    struct WalkState    State[WALK_LANES];
+    unsigned            Active; // lanes of State with a walk under way
+    _Bool               Saved;  // paused for a checkpoint
+    uint64_t            Steps;  // of the walks under way, for progress reports
+    uint64_t            X;
+};
+
+struct CycleInfo
+{
+    uint64_t Length; // for an open chain, the steps known so far
+    uint64_t Representative;
+    uint64_t Starts; // orbits that were found on this cycle
+    _Bool    Complete;
+};
+
+struct CycleSearch
+{
+    struct CycleConfig  Config;
+    struct DPEntry*     Table;
+    uint64_t            TableMask;
+    struct OrbitResult* Orbit;
+    uint64_t            NextOrbit; // shared by the threads
+    uint64_t            Steps;
+    uint64_t            Points;
+    uint64_t            Finished; // orbits
+    _Bool               TableFull;
+    struct Progress     Progress;
+
+    // Walks resumed from a checkpoint
+    struct WalkState* Pending;
+    uint64_t          PendingCount;
+    uint64_t          NextPending;
+
+    // Pausing for checkpoints
+    struct Walker*    Walker;
+    struct WorkerPool Pool; // Changed also when a walker paused
+    pthread_cond_t    Resume;
+    unsigned          Paused;
+    _Bool             Pause;
+    unsigned          CheckpointErrors;
+};
+
+// Results of cycle_checkpoint_load()
+#define CHECKPOINT_RESUMED 0
+#define CHECKPOINT_NONE 1      // no file, the search starts from scratch
+#define CHECKPOINT_CORRUPT -1  // unreadable or cut short
+#define CHECKPOINT_MISMATCH -2 // saved for another key, cipher or start
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+// Returns 0 on success, -1 if memory could not be allocated
+int
+cycle_search_init(struct CycleSearch* cs, const struct CycleConfig* config);
+
+void
+cycle_search_free(struct CycleSearch* cs);
+
+// Walks all orbits on Config.Threads threads
+void
+cycle_search_run(struct CycleSearch* cs);
+
+// Right after cycle_search_init(), with Config.Checkpoint set
+int
+cycle_checkpoint_load(struct CycleSearch* cs);
+
+// Returns 0, or -1 if the file could not be written. Only safe while no
+// walker runs; cycle_search_run() calls it itself.
+int
+cycle_checkpoint_save(struct CycleSearch* cs);
+
+// The cycles found, sorted by decreasing length, as a malloc'd array the
+// caller has to free. Returns NULL if there are none or memory ran out.
+struct CycleInfo*
+cycle_census(struct CycleSearch* cs, uint64_t* count);
@@ -0,0 +1,247 @@
+/**
+ * Cycle walks over the GIFT-128 permutation, many orbits per thread
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cycle128.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "slice128.h"
+
+#define CHECK_STEPS (1 << 14) // steps between progress updates
+
+// The slice128 functions take the round keys as a mutable array
+#define SLICES(key) ((uint32_t(*)[4])(key)->Slice)
+
+//----------------------------------
+// Stepping
+//----------------------------------
+void
+cycle128_key(struct Cycle128Key* key,
+             const uint64_t*     subkey,
+             uint16_t            Rounds,
+             _Bool               Decrypt)
+{
+    uint16_t r;
+
+    memset(key, 0, sizeof(*key));
+    key->Decrypt = Decrypt;
+    key->Rounds  = Decrypt ? (Rounds > MAX_ROUNDS ? MAX_ROUNDS : Rounds) : 40;
+    for (r = 0; r < key->Rounds; r++) {
+        slice128_key(key->Slice[r], subkey[2 * r + 1], subkey[2 * r]);
+    }
+}
+
+// decrypt128_block() on a sliced block
+static void
+decrypt_slices(const struct Cycle128Key* key, uint32_t S[4])
+{
+    unsigned b;
+
+    if (key->Rounds == 0)
+        return;
+    slice128_decrypt(S, SLICES(key) + 1, key->Rounds - 1);
+    for (b = 0; b < 4; b++) {
+        S[b] ^= key->Slice[0][b];
+    }
+}
+
+void
+cycle128_step(const struct Cycle128Key* key, struct Block128* block)
+{
+    uint32_t S[4];
+
+    slice128_pack(S, block->High, block->Low);
+    if (key->Decrypt)
+        decrypt_slices(key, S);
+    else
+        slice128_encrypt(S, SLICES(key), key->Rounds);
+    slice128_unpack(S, &block->High, &block->Low);
+}
+
+//----------------------------------
+// Walking
+//----------------------------------
+// Puts the next orbit into lane, if there is one left
+static void
+lane_fill(struct Cycle128Search* cs,
+          struct Lanes*          ls,
+          uint32_t               s[4],
+          uint32_t               start[4],
+          unsigned               lane)
+{
+    const struct Block128* first = &cs->Config.FirstStart;
+    uint64_t               low;
+
+    if (!lanes_take(ls, lane, &cs->NextOrbit, cs->Config.Orbits))
+        return;
+    low = first->Low + ls->Orbit[lane];
+    slice128_pack(start, first->High + (low < first->Low), low);
+    memcpy(s, start, 4 * sizeof(uint32_t));
+}
+
+// Up to steps steps of all lanes, stopping after the first step that brings
+// an active lane back to its start. The lanes that came back are set in
+// *back.
+static uint64_t
+walk_lanes(const struct Cycle128Search* cs,
+           uint32_t                     s[CYCLE128_LANES][4],
+           uint32_t                     start[CYCLE128_LANES][4],
+           uint64_t                     steps,
+           uint64_t                     active,
+           uint64_t*                    back)
+{
+    const struct Cycle128Key* key = cs->Config.Key;
+    uint64_t                  n;
+    unsigned                  l;
+
+    *back = 0;
+    for (n = 0; n < steps && *back == 0; n++) {
+        if (key->Decrypt) {
+            for (l = 0; l < CYCLE128_LANES; l++) {
+                if (active >> l & 1)
+                    decrypt_slices(key, s[l]);
+            }
+        } else {
+            slice128_encrypt_lanes(
+              cs->Level, s, CYCLE128_LANES, SLICES(key), key->Rounds);
+        }
+
+        for (l = 0; l < CYCLE128_LANES; l++) {
+            if (((s[l][0] ^ start[l][0]) | (s[l][1] ^ start[l][1]) |
+                 (s[l][2] ^ start[l][2]) | (s[l][3] ^ start[l][3])) == 0)
+                *back |= (uint64_t)1 << l;
+        }
+        *back &= active;
+    }
+    return n;
+}
+
+static void*
+worker(void* arg)
+{
+    struct Cycle128Walker* wk = arg;
+    struct Cycle128Search* cs = wk->Search;
+    struct Lanes           ls;
+    uint32_t               s[CYCLE128_LANES][4];
+    uint32_t               start[CYCLE128_LANES][4];
+    uint64_t               steps, n, back, lanes, freed, high, low;
+    unsigned               l;
+
+    memset(s, 0, sizeof(s));
+    memset(start, 0, sizeof(start));
+    lanes_init(&ls, cs->Config.MaxSteps);
+    for (l = 0; l < CYCLE128_LANES; l++) {
+        lane_fill(cs, &ls, s[l], start[l], l);
+    }
+
+    while (ls.Active != 0) {
+        lanes = ls.Active;
+        steps = lanes_budget(&ls, CHECK_STEPS);
+        n     = walk_lanes(cs, s, start, steps, lanes, &back);
+        freed = lanes_finish(&ls, n, back, cs->Orbit, &cs->Finished);
+        for (; freed != 0; freed &= freed - 1) {
+            l = __builtin_ctzll(freed);
+            lane_fill(cs, &ls, s[l], start[l], l);
+        }
+
+        slice128_unpack(s[0], &high, &low);
+        __atomic_fetch_add(&wk->Steps,
+                           n * (uint64_t)__builtin_popcountll(lanes),
+                           __ATOMIC_RELAXED);
+        __atomic_store_n(&wk->X, low, __ATOMIC_RELAXED);
+    }
+
+    pool_done(&cs->Pool);
+    return NULL;
+}
+
+//----------------------------------
+// Search
+//----------------------------------
+int
+cycle128_init(struct Cycle128Search* cs, const struct Cycle128Config* config)
+{
+    memset(cs, 0, sizeof(*cs));
+    cs->Config = *config;
+    cs->Level  = simd_detect();
+    if (cs->Config.Threads == 0) {
+        long cores         = sysconf(_SC_NPROCESSORS_ONLN);
+        cs->Config.Threads = cores > 0 ? (unsigned)cores : 1;
+    }
+    pool_init(&cs->Pool);
+
+    cs->Orbit  = calloc(config->Orbits ? config->Orbits : 1,
+                       sizeof(struct LaneOrbit));
+    cs->Walker = calloc(cs->Config.Threads, sizeof(struct Cycle128Walker));
+    if (cs->Orbit == NULL || cs->Walker == NULL) {
+        cycle128_free(cs);
+        return -1;
+    }
+    return 0;
+}
+
+void
+cycle128_free(struct Cycle128Search* cs)
+{
+    free(cs->Orbit);
+    free(cs->Walker);
+    cs->Orbit  = NULL;
+    cs->Walker = NULL;
+    pool_free(&cs->Pool);
+}
+
+static void
+report_progress(void* arg)
+{
+    struct Cycle128Search* cs    = arg;
+    uint64_t               steps = 0;
+    unsigned               i;
+
+    for (i = 0; i < cs->Config.Threads; i++) {
+        steps += __atomic_load_n(&cs->Walker[i].Steps, __ATOMIC_RELAXED);
+    }
+    progress_report(&cs->Progress,
+                    steps,
+                    0,
+                    __atomic_load_n(&cs->Finished, __ATOMIC_RELAXED),
+                    cs->Config.Orbits,
+                    __atomic_load_n(&cs->Walker[0].X, __ATOMIC_RELAXED));
+}
+
+void
+cycle128_run(struct Cycle128Search* cs)
+{
+    const struct Cycle128Config* cfg = &cs->Config;
+    unsigned                     n = cfg->Threads, i;
+    uint64_t                     limit = 0;
+
+    if (cfg->MaxSteps != 0 && cfg->Orbits <= UINT64_MAX / cfg->MaxSteps)
+        limit = cfg->Orbits * cfg->MaxSteps;
+    progress_start(&cs->Progress, 0, limit);
+
+    // Fewer threads than that would leave lanes empty
+    if (n > (cfg->Orbits + CYCLE128_LANES - 1) / CYCLE128_LANES)
+        n = (unsigned)((cfg->Orbits + CYCLE128_LANES - 1) / CYCLE128_LANES);
+    if (n == 0)
+        n = 1;
+
+    for (i = 0; i < n; i++) {
+        cs->Walker[i].Search = cs;
+    }
+    pool_run(&cs->Pool,
+             worker,
+             cs->Walker,
+             sizeof(struct Cycle128Walker),
+             n,
+             cfg->ProgressEvery,
+             report_progress,
+             cs);
+}
@@ -0,0 +1,99 @@
+/**
+ * Cycle walks over the GIFT-128 permutation, many orbits per thread
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The GIFT-128 counterpart of bscycle.h. The round keys are turned into
+ * slices once, and the blocks stay in the sliced form of slice128.h for the
+ * whole walk: packing is a bijection, so an orbit comes back to its start in
+ * sliced form exactly when it does as a block. A step then costs the rounds
+ * and nothing else, with no key expansion and no allocation.
+ *
+ * Every thread keeps CYCLE128_LANES orbits, which encryption steps together
+ * through slice128_encrypt_lanes() (one AVX-512 pass, or two of AVX2);
+ * decryption has no multi-block kernel and steps them one by one. After each
+ * step every orbit is compared with its start, so the exact length of every
+ * short cycle is found, fixed points after one step. An orbit that closes or
+ * runs out of steps hands its lane to the next start.
+ *
+ * Like encrypt128(), encryption always runs 40 rounds.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include "crypto.h"
+#include "lanes.h"
+#include "progress.h"
+#include "simd.h"
+
+#define CYCLE128_LANES 16
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct Cycle128Key
+{
+    uint32_t Slice[MAX_ROUNDS][4];
+    uint16_t Rounds;
+    _Bool    Decrypt;
+};
+
+struct Cycle128Config
+{
+    const struct Cycle128Key* Key;
+    struct Block128           FirstStart; // orbit i starts at FirstStart + i
+    uint64_t                  Orbits;
+    uint64_t                  MaxSteps;      // per orbit, 0 for no limit
+    unsigned                  Threads;       // 0 for one per core
+    unsigned                  ProgressEvery; // seconds, 0 for none
+};
+
+struct Cycle128Search;
+
+struct Cycle128Walker
+{
+    struct Cycle128Search* Search;
+    uint64_t               Steps; // summed over the lanes, for progress reports
+    uint64_t               X;     // low word of one lane
+};
+
+struct Cycle128Search
+{
+    struct Cycle128Config Config;
+    enum SimdLevel        Level;
+    struct LaneOrbit*     Orbit;
+    uint64_t              NextOrbit; // shared by the threads
+    uint64_t              Finished;
+    struct Progress       Progress;
+
+    struct Cycle128Walker* Walker;
+    struct WorkerPool      Pool;
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+// The steps of encrypt128_block(), or of decrypt128_block() if Decrypt is
+// set, for the subkeys of key_schedule128_init()
+void
+cycle128_key(struct Cycle128Key* key,
+             const uint64_t*     subkey,
+             uint16_t            Rounds,
+             _Bool               Decrypt);
+
+// One step on a block, the same as encrypt128_block() or decrypt128_block()
+void
+cycle128_step(const struct Cycle128Key* key, struct Block128* block);
+
+// Returns 0 on success, -1 if memory could not be allocated
+int
+cycle128_init(struct Cycle128Search* cs, const struct Cycle128Config* config);
+
+void
+cycle128_free(struct Cycle128Search* cs);
+
+// Walks all orbits on Config.Threads threads, the results go to Orbit
+void
+cycle128_run(struct Cycle128Search* cs);
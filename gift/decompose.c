@@ -0,0 +1,477 @@
+/**
+ * Exact cycle decomposition of scaled-down GIFT
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS, MAP_NORESERVE
+
+#include "decompose.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define CHUNK_BITS 16           // starting values per range a thread takes
+#define SHORT_LENGTHS 65536     // cycles shorter than this are counted in place
+#define PUBLISH_STEPS (1 << 20) // steps between progress updates
+
+//----------------------------------
+// Scaled-down cipher
+//----------------------------------
+// GIFTPerm.permutation(): where bit i of a Width-bit block goes
+static uint8_t
+small_perm(uint8_t i, uint8_t Width)
+{
+    return 4 * (i / 16) + (Width / 4) * ((3 * ((i % 16) / 4) + i % 4) % 4) +
+           i % 4;
+}
+
+// Same bit order as pbox_apply() in crypto.c
+static uint64_t
+small_pbox(uint64_t text, const uint8_t* box, uint8_t Width)
+{
+    uint64_t result = 0;
+    uint8_t  bit;
+
+    for (bit = 0; bit < Width; bit++) {
+        result = (result << 1) | ((text >> (Width - 1 - box[bit])) & 1);
+    }
+    return result;
+}
+
+int
+small_gift_init(struct SmallGift* sg,
+                uint8_t           Width,
+                const uint64_t*   subkey,
+                uint16_t          Rounds,
+                _Bool             Decrypt)
+{
+    uint8_t  box[64], boxInv[64];
+    uint16_t v, RoundNr;
+    uint8_t  i;
+
+    if (Width == 0 || Width > 64 || Width % 16 != 0)
+        return -1;
+
+    memset(sg, 0, sizeof(*sg));
+    sg->Width   = Width;
+    sg->Mask    = Width == 64 ? UINT64_MAX : ((uint64_t)1 << Width) - 1;
+    sg->Rounds  = Rounds > MAX_ROUNDS ? MAX_ROUNDS : Rounds;
+    sg->Decrypt = Decrypt;
+    for (RoundNr = 0; RoundNr < sg->Rounds; RoundNr++) {
+        sg->Key[RoundNr] = subkey[RoundNr] & sg->Mask;
+    }
+
+    for (i = 0; i < Width; i++) {
+        box[i]         = small_perm(i, Width);
+        boxInv[box[i]] = i;
+    }
+    for (v = 0; v < 256; v++) {
+        uint8_t s = (Sbox[v >> 4] << 4) | Sbox[v & 0x0F];
+
+        sg->SInv[v] = (SboxInv[v >> 4] << 4) | SboxInv[v & 0x0F];
+        for (i = 0; i < Width / 8; i++) {
+            sg->SP[i][v]   = small_pbox((uint64_t)s << (8 * i), box, Width);
+            sg->PInv[i][v] = small_pbox((uint64_t)v << (8 * i), boxInv, Width);
+        }
+    }
+    return 0;
+}
+
+// The tables of the bytes past the width are all zero
+#define LOOKUP8(table, x)                                                      \
+    (table[0][(x)&0xFF] ^ table[1][((x) >> 8) & 0xFF] ^                        \
+     table[2][((x) >> 16) & 0xFF] ^ table[3][((x) >> 24) & 0xFF] ^             \
+     table[4][((x) >> 32) & 0xFF] ^ table[5][((x) >> 40) & 0xFF] ^             \
+     table[6][((x) >> 48) & 0xFF] ^ table[7][(x) >> 56])
+
+uint64_t
+small_gift(const struct SmallGift* sg, uint64_t x)
+{
+    uint16_t RoundNr, i;
+    uint64_t sLayer;
+
+    if (!sg->Decrypt) {
+        for (RoundNr = 1; RoundNr < sg->Rounds; RoundNr++) {
+            x = LOOKUP8(sg->SP, x) ^ sg->Key[RoundNr - 1];
+        }
+        return x;
+    }
+
+    if (sg->Rounds == 0)
+        return x;
+    for (RoundNr = 1; RoundNr < sg->Rounds; RoundNr++) {
+        x ^= sg->Key[sg->Rounds - RoundNr];
+        x      = LOOKUP8(sg->PInv, x);
+        sLayer = 0;
+        for (i = 0; i < sg->Width / 8; i++) {
+            sLayer |= (uint64_t)sg->SInv[(x >> (8 * i)) & 0xFF] << (8 * i);
+        }
+        x = sLayer;
+    }
+    return x ^ sg->Key[0];
+}
+
+//----------------------------------
+// Decomposition
+//----------------------------------
+// A piece of a cycle walked by one thread, from Start up to the start of
+// another piece
+struct Segment
+{
+    uint64_t Start;
+    uint64_t Next;
+    uint64_t Length;
+};
+
+struct Decomposer;
+
+struct DecomposeWorker
+{
+    struct Decomposer* Shared;
+    struct Segment*    Segment;
+    uint64_t           Segments, SegmentSize;
+    uint64_t*          Long; // lengths of cycles of SHORT_LENGTHS and more
+    uint64_t           Longs, LongSize;
+    uint64_t           Steps;
+    _Bool              NoMemory;
+};
+
+struct Decomposer
+{
+    struct DecomposeConfig  Config;
+    uint64_t*               Visited; // 2^Width bits
+    size_t                  VisitedSize;
+    uint64_t                NextChunk;
+    uint64_t                Chunks;
+    uint64_t                Short[SHORT_LENGTHS];
+    struct DecomposeWorker* Worker;
+    struct WorkerPool       Pool;
+    struct Progress         Progress;
+};
+
+// Whether x was marked before
+static _Bool
+claim(uint64_t* visited, uint64_t x)
+{
+    uint64_t bit = (uint64_t)1 << (x & 63);
+
+    return (__atomic_fetch_or(&visited[x >> 6], bit, __ATOMIC_RELAXED) & bit) !=
+           0;
+}
+
+// Appends value to a growing array of item-sized entries
+static int
+push(void**      list,
+     uint64_t*   count,
+     uint64_t*   size,
+     size_t      item,
+     const void* value)
+{
+    void* grown;
+
+    if (*count == *size) {
+        *size = *size ? 2 * *size : 1024;
+        grown = realloc(*list, *size * item);
+        if (grown == NULL)
+            return -1;
+        *list = grown;
+    }
+    memcpy((char*)*list + *count * item, value, item);
+    (*count)++;
+    return 0;
+}
+
+static void
+count_cycle(struct DecomposeWorker* w, uint64_t length)
+{
+    if (length < SHORT_LENGTHS)
+        __atomic_fetch_add(&w->Shared->Short[length], 1, __ATOMIC_RELAXED);
+    else if (push((void**)&w->Long,
+                  &w->Longs,
+                  &w->LongSize,
+                  sizeof(uint64_t),
+                  &length) != 0)
+        w->NoMemory = 1;
+}
+
+static void*
+worker(void* arg)
+{
+    struct DecomposeWorker* w       = arg;
+    struct Decomposer*      d       = w->Shared;
+    const struct SmallGift* sg      = d->Config.Cipher;
+    uint64_t*               visited = d->Visited;
+    uint64_t                chunk, s, end, x, word, length, unpublished = 0;
+    struct Segment          piece;
+
+    for (;;) {
+        chunk = __atomic_fetch_add(&d->NextChunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= d->Chunks)
+            break;
+        s   = chunk << CHUNK_BITS;
+        end = s + ((uint64_t)1 << CHUNK_BITS);
+        if (end > sg->Mask)
+            end = sg->Mask + 1;
+
+        for (; s < end; s++) {
+            // Most values are marked by the time their range comes up, and
+            // a plain read is much cheaper than claiming them
+            word = __atomic_load_n(&visited[s >> 6], __ATOMIC_RELAXED);
+            if (word == UINT64_MAX && (s & 63) == 0 && s + 63 < end) {
+                s += 63;
+                continue;
+            }
+            if ((word >> (s & 63) & 1) || claim(visited, s))
+                continue;
+            unpublished++;
+
+            // A walk can only run into a piece of its cycle at the start of
+            // that piece, so x is a start when it is already marked
+            length = 1;
+            x      = small_gift(sg, s);
+            while (x != s && !claim(visited, x)) {
+                length++;
+                x = small_gift(sg, x);
+                if (++unpublished >= PUBLISH_STEPS) {
+                    __atomic_fetch_add(
+                      &w->Steps, unpublished, __ATOMIC_RELAXED);
+                    unpublished = 0;
+                }
+            }
+
+            if (x == s) {
+                count_cycle(w, length);
+            } else {
+                piece.Start  = s;
+                piece.Next   = x;
+                piece.Length = length;
+                if (push((void**)&w->Segment,
+                         &w->Segments,
+                         &w->SegmentSize,
+                         sizeof(struct Segment),
+                         &piece) != 0)
+                    w->NoMemory = 1;
+            }
+        }
+        __atomic_fetch_add(&w->Steps, unpublished, __ATOMIC_RELAXED);
+        unpublished = 0;
+    }
+
+    pool_done(&d->Pool);
+    return NULL;
+}
+
+static int
+compare_segments(const void* a, const void* b)
+{
+    uint64_t x = ((const struct Segment*)a)->Start;
+    uint64_t y = ((const struct Segment*)b)->Start;
+
+    return (x > y) - (x < y);
+}
+
+static int
+compare_lengths(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Joins the pieces of all workers into cycles. The pieces of a cycle form a
+// ring through Next; a joined piece gets Length 0.
+static int
+join_segments(struct Decomposer* d, struct DecomposeWorker* into)
+{
+    struct Segment *all = NULL, key, *at;
+    uint64_t        count = 0, size = 0, i, length;
+    unsigned        t;
+
+    for (t = 0; t < d->Config.Threads; t++) {
+        for (i = 0; i < d->Worker[t].Segments; i++) {
+            if (push((void**)&all,
+                     &count,
+                     &size,
+                     sizeof(struct Segment),
+                     &d->Worker[t].Segment[i]) != 0) {
+                free(all);
+                return -1;
+            }
+        }
+    }
+    qsort(all, count, sizeof(struct Segment), compare_segments);
+
+    for (i = 0; i < count; i++) {
+        if (all[i].Length == 0)
+            continue;
+        length = 0;
+        at     = &all[i];
+        while (at != NULL && at->Length != 0) {
+            length += at->Length;
+            at->Length = 0;
+            key.Start  = at->Next;
+            at         = bsearch(
+              &key, all, count, sizeof(struct Segment), compare_segments);
+        }
+        count_cycle(into, length);
+    }
+    free(all);
+    return into->NoMemory ? -1 : 0;
+}
+
+static void
+report_progress(void* arg)
+{
+    struct Decomposer* d     = arg;
+    uint64_t           steps = 0, taken;
+    unsigned           i;
+
+    for (i = 0; i < d->Config.Threads; i++) {
+        steps += __atomic_load_n(&d->Worker[i].Steps, __ATOMIC_RELAXED);
+    }
+    taken = __atomic_load_n(&d->NextChunk, __ATOMIC_RELAXED);
+    if (taken > d->Chunks)
+        taken = d->Chunks;
+    progress_report(&d->Progress, steps, 0, taken, d->Chunks, 0);
+}
+
+static void
+run(struct Decomposer* d)
+{
+    unsigned i;
+
+    for (i = 0; i < d->Config.Threads; i++) {
+        d->Worker[i].Shared = d;
+    }
+    pool_run(&d->Pool,
+             worker,
+             d->Worker,
+             sizeof(struct DecomposeWorker),
+             d->Config.Threads,
+             d->Config.ProgressEvery,
+             report_progress,
+             d);
+}
+
+int
+decompose(const struct DecomposeConfig* config, struct Decomposition* result)
+{
+    struct Decomposer* d;
+    struct CycleCount  entry;
+    uint64_t           width = config->Cipher->Width, i, *lengths = NULL;
+    uint64_t           count = 0, size = 0, lengthSize = 0;
+    unsigned           t;
+    int                error = 0;
+
+    memset(result, 0, sizeof(*result));
+    if (width > DECOMPOSE_MAX_WIDTH)
+        return -1;
+    d = calloc(1, sizeof(struct Decomposer));
+    if (d == NULL)
+        return -1;
+
+    d->Config = *config;
+    if (d->Config.Threads == 0) {
+        long cores        = sysconf(_SC_NPROCESSORS_ONLN);
+        d->Config.Threads = cores > 0 ? (unsigned)cores : 1;
+    }
+    d->Chunks = width > CHUNK_BITS ? (uint64_t)1 << (width - CHUNK_BITS) : 1;
+    pool_init(&d->Pool);
+
+    // Anonymous pages read as zero and are only backed once written
+    d->VisitedSize = width >= 6 ? ((size_t)1 << width) / 8 : 8;
+    d->Visited     = mmap(NULL,
+                      d->VisitedSize,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                      -1,
+                      0);
+    d->Worker =
+      calloc(d->Config.Threads + 1, sizeof(struct DecomposeWorker));
+    if (d->Visited == MAP_FAILED || d->Worker == NULL) {
+        error = -1;
+        goto done;
+    }
+    progress_start(&d->Progress, 0, (uint64_t)1 << width);
+
+    run(d);
+
+    // The extra worker collects the cycles that were walked in pieces
+    d->Worker[d->Config.Threads].Shared = d;
+    if (join_segments(d, &d->Worker[d->Config.Threads]) != 0)
+        error = -1;
+
+    for (i = 1; i < SHORT_LENGTHS; i++) {
+        entry.Length = i;
+        entry.Count  = d->Short[i];
+        if (entry.Count != 0 && push((void**)&result->Histogram,
+                                     &result->Lengths,
+                                     &size,
+                                     sizeof(entry),
+                                     &entry) != 0)
+            error = -1;
+    }
+    for (t = 0; t <= d->Config.Threads; t++) {
+        error |= d->Worker[t].NoMemory ? -1 : 0;
+        for (i = 0; i < d->Worker[t].Longs; i++) {
+            if (push((void**)&lengths,
+                     &count,
+                     &lengthSize,
+                     sizeof(uint64_t),
+                     &d->Worker[t].Long[i]) != 0)
+                error = -1;
+        }
+    }
+    qsort(lengths, count, sizeof(uint64_t), compare_lengths);
+
+    // The long cycles are few, count them from the sorted list
+    for (i = 0; i < count; i++) {
+        if (i > 0 && lengths[i] == lengths[i - 1]) {
+            result->Histogram[result->Lengths - 1].Count++;
+            continue;
+        }
+        entry.Length = lengths[i];
+        entry.Count  = 1;
+        if (push((void**)&result->Histogram,
+                 &result->Lengths,
+                 &size,
+                 sizeof(entry),
+                 &entry) != 0)
+            error = -1;
+    }
+    for (i = 0; i < result->Lengths; i++) {
+        result->Cycles += result->Histogram[i].Count;
+    }
+    result->Threads = d->Config.Threads;
+    free(lengths);
+
+done:
+    if (d->Worker != NULL) {
+        for (t = 0; t <= d->Config.Threads; t++) {
+            free(d->Worker[t].Segment);
+            free(d->Worker[t].Long);
+        }
+    }
+    free(d->Worker);
+    if (d->Visited != MAP_FAILED && d->Visited != NULL)
+        munmap(d->Visited, d->VisitedSize);
+    pool_free(&d->Pool);
+    free(d);
+    if (error != 0)
+        decomposition_free(result);
+    return error;
+}
+
+void
+decomposition_free(struct Decomposition* result)
+{
+    free(result->Histogram);
+    result->Histogram = NULL;
+    result->Lengths   = 0;
+}
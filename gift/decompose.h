@@ -0,0 +1,87 @@
+/**
+ * Exact cycle decomposition of scaled-down GIFT
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The cycles of the 64-bit permutation can only be sampled, but GIFT cut down
+ * to a 16 or 32-bit block can be taken apart completely. SmallGift keeps the
+ * round structure of encrypt() and decrypt(): the S-box on every nibble, the
+ * GIFT bit permutation for the width (the one Java/Code/GIFTPerm.java
+ * generates, which is Pbox at 64 bits) and the GIFT-64 round keys cut to the
+ * low Width bits. The permutation groups the S-boxes by four, so the width
+ * has to be a multiple of 16; at 64 bits SmallGift is encrypt() itself.
+ *
+ * decompose() walks every cycle once. A bitmap of 2^Width bits, mapped
+ * anonymously (512 MiB at 32 bits), marks the values walked so far. The
+ * threads take disjoint ranges of starting values and skip the marked ones.
+ * A walk claims every value it reaches, so when two threads start on the same
+ * cycle at once each stops at the start of the other, and their pieces are
+ * joined into the cycle when all threads are done.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include "crypto.h"
+#include "progress.h"
+
+#define DECOMPOSE_MAX_WIDTH 32 // the bitmap is 2^Width bits
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct SmallGift
+{
+    uint64_t SP[8][256];      // P(S(byte << 8i)) at this width
+    uint64_t PInv[8][256];    // PInv(byte << 8i)
+    uint8_t  SInv[256];       // SInv on both nibbles of a byte
+    uint64_t Key[MAX_ROUNDS]; // the GIFT-64 round keys cut to Width bits
+    uint64_t Mask;
+    uint16_t Rounds;
+    uint8_t  Width;
+    _Bool    Decrypt;
+};
+
+struct DecomposeConfig
+{
+    const struct SmallGift* Cipher; // Width up to DECOMPOSE_MAX_WIDTH
+    unsigned                Threads;       // 0 for one per core
+    unsigned                ProgressEvery; // seconds, 0 for none
+};
+
+struct CycleCount
+{
+    uint64_t Length;
+    uint64_t Count;
+};
+
+struct Decomposition
+{
+    struct CycleCount* Histogram; // by increasing length, malloc'd
+    uint64_t           Lengths;   // entries of Histogram
+    uint64_t           Cycles;
+    unsigned           Threads;
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+// Returns 0, or -1 if Width is not 16, 32, 48 or 64
+int
+small_gift_init(struct SmallGift* sg,
+                uint8_t           Width,
+                const uint64_t*   subkey,
+                uint16_t          Rounds,
+                _Bool             Decrypt);
+
+// One step, encrypt() or decrypt() at the width
+uint64_t
+small_gift(const struct SmallGift* sg, uint64_t x);
+
+// Returns 0, or -1 if the bitmap or the results did not fit in memory
+int
+decompose(const struct DecomposeConfig* config, struct Decomposition* result);
+
+void
+decomposition_free(struct Decomposition* result);
@@ -0,0 +1,354 @@
+/**
+ * Persistent store of the distinguished points of known cycles
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dpstore.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cycle.h"
+
+struct StoreHeader
+{
+    char             Magic[8];
+    struct DpStoreId Id;
+    uint64_t         Cycles;
+    uint64_t         Points;
+};
+
+static const char StoreMagic[8] = { 'G', 'I', 'F', 'T', 'D', 'P', 'S', '1' };
+
+//----------------------------------
+// Reading
+//----------------------------------
+int
+dp_store_open(struct DpStore* ds, const char* path, const struct DpStoreId* id)
+{
+    const struct StoreHeader* hdr;
+    struct stat               st;
+    int                       fd;
+
+    memset(ds, 0, sizeof(*ds));
+    ds->Path = path;
+    ds->Id   = *id;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return STORE_NONE;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*hdr)) {
+        close(fd);
+        return STORE_CORRUPT;
+    }
+    ds->Size = st.st_size;
+    ds->Map  = mmap(NULL, ds->Size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ds->Map == MAP_FAILED) {
+        ds->Map = NULL;
+        return STORE_CORRUPT;
+    }
+
+    hdr = ds->Map;
+    if (memcmp(hdr->Magic, StoreMagic, sizeof(hdr->Magic)) != 0 ||
+        hdr->Cycles > ds->Size / sizeof(struct StoredCycle) ||
+        hdr->Points > ds->Size / sizeof(struct StoredPoint) ||
+        ds->Size != sizeof(*hdr) + hdr->Cycles * sizeof(struct StoredCycle) +
+                      hdr->Points * sizeof(struct StoredPoint)) {
+        dp_store_close(ds);
+        return STORE_CORRUPT;
+    }
+    if (hdr->Id.KeyHigh != id->KeyHigh || hdr->Id.KeyLow != id->KeyLow ||
+        hdr->Id.Rounds != id->Rounds || hdr->Id.Decrypt != id->Decrypt ||
+        hdr->Id.DpBits != id->DpBits) {
+        dp_store_close(ds);
+        return STORE_MISMATCH;
+    }
+
+    ds->Cycles = hdr->Cycles;
+    ds->Points = hdr->Points;
+    ds->Cycle  = (const struct StoredCycle*)(hdr + 1);
+    ds->Point  = (const struct StoredPoint*)(ds->Cycle + ds->Cycles);
+    return STORE_OPENED;
+}
+
+void
+dp_store_close(struct DpStore* ds)
+{
+    if (ds->Map != NULL)
+        munmap(ds->Map, ds->Size);
+    ds->Map    = NULL;
+    ds->Cycle  = NULL;
+    ds->Point  = NULL;
+    ds->Cycles = 0;
+    ds->Points = 0;
+}
+
+const struct StoredPoint*
+dp_store_find(const struct DpStore* ds, uint64_t point)
+{
+    uint64_t lo = 0, hi = ds->Points, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (ds->Point[mid].Point < point)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < ds->Points && ds->Point[lo].Point == point)
+        return &ds->Point[lo];
+    return NULL;
+}
+
+//----------------------------------
+// Cycles of a search
+//----------------------------------
+static int
+compare_entries(const void* a, const void* b)
+{
+    const struct DPEntry* x = a;
+    const struct DPEntry* y = b;
+
+    return (x->Point > y->Point) - (x->Point < y->Point);
+}
+
+static int
+compare_points(const void* a, const void* b)
+{
+    const struct StoredPoint* x = a;
+    const struct StoredPoint* y = b;
+
+    return (x->Point > y->Point) - (x->Point < y->Point);
+}
+
+// Index of point in the sorted entries, -1 if it has none
+static int64_t
+entry_find(const struct DPEntry* entry, uint64_t n, uint64_t point)
+{
+    uint64_t lo = 0, hi = n, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (entry[mid].Point < point)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < n && entry[lo].Point == point ? (int64_t)lo : -1;
+}
+
+// The complete cycles of the table, as cycles and points numbered from 0.
+// Every point of a cycle has its predecessor on it, so a path from a point
+// either comes back to it, ends at an arc not walked to the end, or runs into
+// such an open path; and the first point of a cycle met in order of value is
+// its smallest, the representative.
+static int
+table_cycles(struct CycleSearch*  cs,
+             struct StoredCycle** cycles,
+             uint64_t*            nCycles,
+             struct StoredPoint** points,
+             uint64_t*            nPoints)
+{
+    struct DPEntry* entry;
+    uint64_t*       mark; // 1 + the path that reached the entry, 0 if none
+    uint64_t        n = 0, e, i, cur, offset;
+    int64_t         next;
+
+    *cycles  = NULL;
+    *points  = NULL;
+    *nCycles = 0;
+    *nPoints = 0;
+
+    entry = malloc((cs->TableMask + 1) * sizeof(*entry));
+    mark  = calloc(cs->TableMask + 1, sizeof(*mark));
+    if (entry == NULL || mark == NULL)
+        goto fail;
+    for (e = 0; e <= cs->TableMask; e++) {
+        if (cs->Table[e].Point == 0)
+            continue;
+        entry[n]         = cs->Table[e];
+        entry[n++].Point = cs->Table[e].Point & ~DP_USED;
+    }
+    qsort(entry, n, sizeof(*entry), compare_entries);
+
+    // No more cycles than points, and no more points than entries
+    *cycles = malloc((n ? n : 1) * sizeof(**cycles));
+    *points = malloc((n ? n : 1) * sizeof(**points));
+    if (*cycles == NULL || *points == NULL)
+        goto fail;
+
+    for (i = 0; i < n; i++) {
+        if (mark[i] != 0)
+            continue;
+        for (cur = i;; cur = (uint64_t)next) {
+            mark[cur] = i + 1;
+            next      = entry[cur].Distance == 0
+                          ? -1
+                          : entry_find(entry, n, entry[cur].Next);
+            if (next < 0 || mark[next] != 0)
+                break;
+        }
+        if (next != (int64_t)i)
+            continue;
+
+        offset = 0;
+        cur    = i;
+        do {
+            (*points)[*nPoints].Point  = entry[cur].Point;
+            (*points)[*nPoints].Cycle  = *nCycles;
+            (*points)[*nPoints].Offset = offset;
+            (*nPoints)++;
+            offset += entry[cur].Distance;
+            cur = (uint64_t)entry_find(entry, n, entry[cur].Next);
+        } while (cur != i);
+        (*cycles)[*nCycles].Representative = entry[i].Point;
+        (*cycles)[*nCycles].Length         = offset;
+        (*nCycles)++;
+    }
+
+    free(entry);
+    free(mark);
+    return 0;
+
+fail:
+    free(entry);
+    free(mark);
+    free(*cycles);
+    free(*points);
+    *cycles = NULL;
+    *points = NULL;
+    return -1;
+}
+
+//----------------------------------
+// Writing
+//----------------------------------
+// The store on disk may have grown since ds was opened, by other jobs of the
+// campaign, so the new cycles are merged into what the file holds now
+int
+dp_store_add(const struct DpStore* ds, struct CycleSearch* cs, uint64_t* added)
+{
+    struct StoredCycle *found, *cycle = NULL;
+    struct StoredPoint *fresh, *point = NULL;
+    struct StoreHeader  hdr;
+    struct DpStore      cur;
+    struct flock        lock;
+    uint64_t           *id = NULL, nFound, nFresh, c, p;
+    char*               name;
+    FILE*               f = NULL;
+    int                 lockFd, loaded, ok = 0;
+
+    *added = 0;
+    if (table_cycles(cs, &found, &nFound, &fresh, &nFresh) != 0)
+        return -1;
+    if (nFound == 0) {
+        free(found);
+        free(fresh);
+        return 0;
+    }
+
+    name = malloc(strlen(ds->Path) + 6);
+    if (name == NULL) {
+        free(found);
+        free(fresh);
+        return -1;
+    }
+    sprintf(name, "%s.lock", ds->Path);
+    lockFd = open(name, O_RDWR | O_CREAT, 0644);
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type   = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if (lockFd < 0 || fcntl(lockFd, F_SETLKW, &lock) != 0) {
+        if (lockFd >= 0)
+            close(lockFd);
+        free(name);
+        free(found);
+        free(fresh);
+        return -1;
+    }
+
+    loaded = dp_store_open(&cur, ds->Path, &ds->Id);
+    if (loaded != STORE_OPENED && loaded != STORE_NONE)
+        goto out;
+
+    // Cycles the file knows already keep their index, the others are
+    // numbered after them
+    id = malloc(nFound * sizeof(*id));
+    if (id == NULL)
+        goto out;
+    for (c = 0; c < nFound; c++) {
+        const struct StoredPoint* known =
+          dp_store_find(&cur, found[c].Representative);
+
+        if (known != NULL) {
+            id[c] = UINT64_MAX;
+            continue;
+        }
+        id[c] = cur.Cycles + *added;
+        found[*added] = found[c];
+        (*added)++;
+    }
+    if (*added == 0) {
+        ok = 1;
+        goto out;
+    }
+
+    cycle = malloc((cur.Cycles + *added) * sizeof(*cycle));
+    point = malloc((cur.Points + nFresh) * sizeof(*point));
+    if (cycle == NULL || point == NULL)
+        goto out;
+    if (cur.Cycles != 0)
+        memcpy(cycle, cur.Cycle, cur.Cycles * sizeof(*cycle));
+    memcpy(cycle + cur.Cycles, found, *added * sizeof(*cycle));
+    if (cur.Points != 0)
+        memcpy(point, cur.Point, cur.Points * sizeof(*point));
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.Magic, StoreMagic, sizeof(hdr.Magic));
+    hdr.Id     = ds->Id;
+    hdr.Cycles = cur.Cycles + *added;
+    hdr.Points = cur.Points;
+    for (p = 0; p < nFresh; p++) {
+        if (id[fresh[p].Cycle] == UINT64_MAX)
+            continue;
+        point[hdr.Points]         = fresh[p];
+        point[hdr.Points++].Cycle = id[fresh[p].Cycle];
+    }
+    qsort(point, hdr.Points, sizeof(*point), compare_points);
+
+    // Same dance as the checkpoints: a crash leaves the old file or the new
+    sprintf(name, "%s.tmp", ds->Path);
+    f  = fopen(name, "wb");
+    ok = f != NULL;
+    ok = ok && fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    ok = ok && fwrite(cycle, sizeof(*cycle), hdr.Cycles, f) == hdr.Cycles;
+    ok = ok && fwrite(point, sizeof(*point), hdr.Points, f) == hdr.Points;
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (f != NULL)
+        ok = (fclose(f) == 0) && ok;
+    ok = ok && rename(name, ds->Path) == 0;
+    if (!ok)
+        remove(name);
+
+out:
+    if (!ok)
+        *added = 0;
+    dp_store_close(&cur);
+    close(lockFd); // drops the lock
+    free(name);
+    free(id);
+    free(cycle);
+    free(point);
+    free(found);
+    free(fresh);
+    return ok ? 0 : -1;
+}
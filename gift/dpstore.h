@@ -0,0 +1,93 @@
+/**
+ * Persistent store of the distinguished points of known cycles
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * Campaigns walk the orbits of many texts under the same key, and most of
+ * those orbits end up on cycles an earlier run has walked all the way round.
+ * The store keeps every distinguished point of such a complete cycle, tagged
+ * with the cycle and its offset (steps from the representative, the smallest
+ * distinguished point), so a later search that reaches one of them knows the
+ * whole cycle at once and stops.
+ *
+ * A store holds the cycles of one key, round count, direction and DpBits,
+ * which its header records. The file is the header, the cycles in the order
+ * they were added (a point names its cycle by index), and the points sorted by
+ * value. It is mapped read-only and searched in place, so opening even a
+ * large store costs nothing up front.
+ *
+ * dp_store_add() merges the complete cycles of a finished search into the file
+ * on disk. It holds a lock on path.lock while it reads the current file and
+ * writes the merged one to path.tmp, which then replaces it, so jobs of a
+ * campaign can share one store.
+ *
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+// What the cycles in a store were walked with
+struct DpStoreId
+{
+    uint64_t KeyHigh;
+    uint64_t KeyLow;
+    uint16_t Rounds;
+    uint8_t  Decrypt;
+    uint8_t  DpBits;
+};
+
+struct StoredCycle
+{
+    uint64_t Representative;
+    uint64_t Length;
+};
+
+struct StoredPoint
+{
+    uint64_t Point;
+    uint64_t Cycle;  // index of its cycle
+    uint64_t Offset; // steps from the representative of the cycle
+};
+
+struct DpStore
+{
+    const char*               Path;
+    struct DpStoreId          Id;
+    const struct StoredCycle* Cycle;
+    const struct StoredPoint* Point;
+    uint64_t                  Cycles;
+    uint64_t                  Points;
+    void*                     Map; // NULL for an empty store
+    size_t                    Size;
+};
+
+struct CycleSearch;
+
+// Results of dp_store_open()
+#define STORE_OPENED 0
+#define STORE_NONE 1      // no file, the store starts out empty
+#define STORE_CORRUPT -1  // not a store, or cut short
+#define STORE_MISMATCH -2 // kept for another key, cipher or DpBits
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+int
+dp_store_open(struct DpStore* ds, const char* path, const struct DpStoreId* id);
+
+void
+dp_store_close(struct DpStore* ds);
+
+// The stored point, or NULL if it is on no known cycle
+const struct StoredPoint*
+dp_store_find(const struct DpStore* ds, uint64_t point);
+
+// Adds the complete cycles of cs not in the file yet, and sets added to their
+// number. Only once no walker runs. Returns 0, or -1 if the file could not be
+// read or written.
+int
+dp_store_add(const struct DpStore* ds, struct CycleSearch* cs, uint64_t* added);
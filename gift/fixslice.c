@@ -0,0 +1,518 @@
+/**
+ * Fixsliced implementation of GIFT-64, one block per call
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include "fixslice.h"
+#include "bitslice.h"
+
+//----------------------------------
+// Macros for slice manipulation
+//----------------------------------
+// Swap the bits selected by mask with the bits shift positions above them
+#define DELTA_SWAP(x, mask, shift)                                             \
+    do {                                                                       \
+        uint64_t t_ = ((x) ^ ((x) >> (shift))) & (mask);                       \
+        (x) ^= t_ ^ (t_ << (shift));                                           \
+    } while (0)
+
+// A slice is a 4x4 grid, bit 4 * row + col holding nibble 4 * row + col.
+// The P-Box maps slice b to T(R_b(slice)) where T transposes the grid and R_b
+// swaps rows. T(R_b(T(x))) is the matching column swap C_b, so a round that
+// starts transposed needs only C_b to get back to the normal layout.
+#define SWAP_NIBBLES(x) ((((x)&0x0F0F) << 4) | (((x) >> 4) & 0x0F0F))
+#define SWAP_BITS(x) ((((x)&0x5555) << 1) | (((x) >> 1) & 0x5555))
+#define SWAP_PAIRS(x) ((((x)&0x3333) << 2) | (((x) >> 2) & 0x3333))
+
+// Row swaps: 0 <-> 3 and 1 <-> 2, 1 <-> 3, 0 <-> 1 and 2 <-> 3, 0 <-> 2
+#define ROWS_0(x) (x = SWAP_NIBBLES(x), x = ((x) << 8 | (x) >> 8) & 0xFFFF)
+#define ROWS_1(x) DELTA_SWAP(x, 0x00F0, 8)
+#define ROWS_2(x) (x = SWAP_NIBBLES(x))
+#define ROWS_3(x) DELTA_SWAP(x, 0x000F, 8)
+
+// The same swaps on the bits of every nibble
+#define COLS_0(x) (x = SWAP_BITS(x), x = SWAP_PAIRS(x))
+#define COLS_1(x) DELTA_SWAP(x, 0x2222, 2)
+#define COLS_2(x) (x = SWAP_BITS(x))
+#define COLS_3(x) DELTA_SWAP(x, 0x1111, 2)
+
+// S-Box on the four slices, including the swap BS_SBOX leaves out
+#define SBOX_LAYER(s0, s1, s2, s3)                                             \
+    do {                                                                       \
+        uint16_t t_;                                                           \
+        BS_SBOX(s0, s1, s2, s3);                                               \
+        t_ = s0;                                                               \
+        s0 = s3;                                                               \
+        s3 = t_;                                                               \
+    } while (0)
+
+#define SBOX_INV_LAYER(s0, s1, s2, s3)                                         \
+    do {                                                                       \
+        uint16_t t_;                                                           \
+        BS_SBOX_INV(s0, s1, s2, s3);                                           \
+        t_ = s0;                                                               \
+        s0 = s3;                                                               \
+        s3 = t_;                                                               \
+    } while (0)
+
+#define ADD_KEY(s0, s1, s2, s3, key)                                           \
+    do {                                                                       \
+        s0 ^= (key);                                                           \
+        s1 ^= (key) >> 16;                                                     \
+        s2 ^= (key) >> 32;                                                     \
+        s3 ^= (key) >> 48;                                                     \
+    } while (0)
+
+//----------------------------------
+// Layout conversion
+//----------------------------------
+// Moves bit 4 * n + b of the block to bit 16 * b + n, which rotates the bit
+// index right by two: two chains of index bit swaps (0 2 4) and (1 3 5)
+uint64_t
+fixslice_pack(uint64_t in)
+{
+    DELTA_SWAP(in, 0x0A0A0A0A0A0A0A0A, 3);
+    DELTA_SWAP(in, 0x0000F0F00000F0F0, 12);
+    DELTA_SWAP(in, 0x00CC00CC00CC00CC, 6);
+    DELTA_SWAP(in, 0x00000000FF00FF00, 24);
+    return in;
+}
+
+uint64_t
+fixslice_unpack(uint64_t in)
+{
+    DELTA_SWAP(in, 0x0000F0F00000F0F0, 12);
+    DELTA_SWAP(in, 0x0A0A0A0A0A0A0A0A, 3);
+    DELTA_SWAP(in, 0x00000000FF00FF00, 24);
+    DELTA_SWAP(in, 0x00CC00CC00CC00CC, 6);
+    return in;
+}
+
+static uint64_t
+transpose_slices(uint64_t in)
+{
+    DELTA_SWAP(in, 0x0A0A0A0A0A0A0A0A, 3);
+    DELTA_SWAP(in, 0x00CC00CC00CC00CC, 6);
+    return in;
+}
+
+//----------------------------------
+// Key Scheduling
+//----------------------------------
+void
+fixslice_key(struct FixsliceKey* fk, const uint64_t* subkey, uint16_t Rounds)
+{
+    uint16_t i;
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    for (i = 0; i < Rounds; i++) {
+        fk->Normal[i]     = fixslice_pack(subkey[i]);
+        fk->Transposed[i] = transpose_slices(fk->Normal[i]);
+    }
+    fk->Rounds = Rounds;
+}
+
+//----------------------------------
+// Encryption
+//----------------------------------
+// Same round structure as encrypt(): Rounds - 1 times S-Box, P-Box and the
+// round key.
+uint64_t
+encrypt_fixslice(uint64_t in, const struct FixsliceKey* fk)
+{
+    uint16_t RoundNr;
+    uint64_t state = fixslice_pack(in);
+    uint16_t s0    = state;
+    uint16_t s1    = state >> 16;
+    uint16_t s2    = state >> 32;
+    uint16_t s3    = state >> 48;
+
+    // Rounds come in pairs: the odd one starts in the normal layout and ends
+    // transposed, the even one goes back
+    for (RoundNr = 1; RoundNr < fk->Rounds; RoundNr++) {
+        SBOX_LAYER(s0, s1, s2, s3);
+        ROWS_0(s0);
+        ROWS_1(s1);
+        ROWS_2(s2);
+        ROWS_3(s3);
+        ADD_KEY(s0, s1, s2, s3, fk->Transposed[RoundNr - 1]);
+
+        if (++RoundNr == fk->Rounds)
+            break;
+
+        SBOX_LAYER(s0, s1, s2, s3);
+        COLS_0(s0);
+        COLS_1(s1);
+        COLS_2(s2);
+        COLS_3(s3);
+        ADD_KEY(s0, s1, s2, s3, fk->Normal[RoundNr - 1]);
+    }
+
+    state = s0 | ((uint64_t)s1 << 16) | ((uint64_t)s2 << 32) |
+            ((uint64_t)s3 << 48);
+    if (fk->Rounds > 1 && !(fk->Rounds & 1))
+        state = transpose_slices(state);
+    return fixslice_unpack(state);
+}
+
+//----------------------------------
+// Decryption
+//----------------------------------
+// Same round structure as decrypt(): Rounds times round key, inverse P-Box
+// and inverse S-Box, where the result is taken after the last key addition.
+// The inverse P-Box is R_b(T(x)), and both R_b and C_b are their own inverse.
+uint64_t
+decrypt_fixslice(uint64_t in, const struct FixsliceKey* fk)
+{
+    uint16_t RoundNr;
+    uint16_t Rounds = fk->Rounds;
+    uint64_t state  = fixslice_pack(in);
+    uint16_t s0     = state;
+    uint16_t s1     = state >> 16;
+    uint16_t s2     = state >> 32;
+    uint16_t s3     = state >> 48;
+    uint64_t key;
+
+    if (Rounds == 0)
+        return in;
+
+    // Odd rounds start in the normal layout, even rounds transposed
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        ADD_KEY(s0, s1, s2, s3, fk->Normal[Rounds - RoundNr]);
+        COLS_0(s0);
+        COLS_1(s1);
+        COLS_2(s2);
+        COLS_3(s3);
+        SBOX_INV_LAYER(s0, s1, s2, s3);
+
+        if (++RoundNr == Rounds)
+            break;
+
+        ADD_KEY(s0, s1, s2, s3, fk->Transposed[Rounds - RoundNr]);
+        ROWS_0(s0);
+        ROWS_1(s1);
+        ROWS_2(s2);
+        ROWS_3(s3);
+        SBOX_INV_LAYER(s0, s1, s2, s3);
+    }
+
+    // The last round only adds the first round key
+    key   = (Rounds & 1) ? fk->Normal[0] : fk->Transposed[0];
+    state = s0 | ((uint64_t)s1 << 16) | ((uint64_t)s2 << 32) |
+            ((uint64_t)s3 << 48);
+    state ^= key;
+    if (!(Rounds & 1))
+        state = transpose_slices(state);
+    return fixslice_unpack(state);
+}
+
+//----------------------------------
+// Round-specialized kernels
+//----------------------------------
+// The constants added by the key schedule (Constants[r] in bits 3 of the
+// first six nibbles, and bit 63), in the normal and the transposed layout
+#define RC_NORMAL(c) (((uint64_t)(c) << 48) | 0x8000000000000000)
+#define RC_TRANSPOSED(c)                                                       \
+    (((uint64_t)(((c)&0x01) | ((c)&0x02) << 3 | ((c)&0x04) << 6 |              \
+                 ((c)&0x08) << 9 | ((c)&0x10) >> 3 | ((c)&0x20))               \
+      << 48) |                                                                 \
+     0x8000000000000000)
+
+static const uint64_t RcNormal[47] = {
+    RC_NORMAL(0x01), RC_NORMAL(0x03), RC_NORMAL(0x07),
+    RC_NORMAL(0x0f), RC_NORMAL(0x1f), RC_NORMAL(0x3e),
+    RC_NORMAL(0x3d), RC_NORMAL(0x3b), RC_NORMAL(0x37),
+    RC_NORMAL(0x2f), RC_NORMAL(0x1e), RC_NORMAL(0x3c),
+    RC_NORMAL(0x39), RC_NORMAL(0x33), RC_NORMAL(0x27),
+    RC_NORMAL(0x0e), RC_NORMAL(0x1d), RC_NORMAL(0x3a),
+    RC_NORMAL(0x35), RC_NORMAL(0x2b), RC_NORMAL(0x16),
+    RC_NORMAL(0x2c), RC_NORMAL(0x18), RC_NORMAL(0x30),
+    RC_NORMAL(0x21), RC_NORMAL(0x02), RC_NORMAL(0x05),
+    RC_NORMAL(0x0b), RC_NORMAL(0x17), RC_NORMAL(0x2e),
+    RC_NORMAL(0x1c), RC_NORMAL(0x38), RC_NORMAL(0x31),
+    RC_NORMAL(0x23), RC_NORMAL(0x06), RC_NORMAL(0x0d),
+    RC_NORMAL(0x1b), RC_NORMAL(0x36), RC_NORMAL(0x2d),
+    RC_NORMAL(0x1a), RC_NORMAL(0x34), RC_NORMAL(0x29),
+    RC_NORMAL(0x12), RC_NORMAL(0x24), RC_NORMAL(0x08),
+    RC_NORMAL(0x11), RC_NORMAL(0x22),
+};
+
+static const uint64_t RcTransposed[47] = {
+    RC_TRANSPOSED(0x01), RC_TRANSPOSED(0x03), RC_TRANSPOSED(0x07),
+    RC_TRANSPOSED(0x0f), RC_TRANSPOSED(0x1f), RC_TRANSPOSED(0x3e),
+    RC_TRANSPOSED(0x3d), RC_TRANSPOSED(0x3b), RC_TRANSPOSED(0x37),
+    RC_TRANSPOSED(0x2f), RC_TRANSPOSED(0x1e), RC_TRANSPOSED(0x3c),
+    RC_TRANSPOSED(0x39), RC_TRANSPOSED(0x33), RC_TRANSPOSED(0x27),
+    RC_TRANSPOSED(0x0e), RC_TRANSPOSED(0x1d), RC_TRANSPOSED(0x3a),
+    RC_TRANSPOSED(0x35), RC_TRANSPOSED(0x2b), RC_TRANSPOSED(0x16),
+    RC_TRANSPOSED(0x2c), RC_TRANSPOSED(0x18), RC_TRANSPOSED(0x30),
+    RC_TRANSPOSED(0x21), RC_TRANSPOSED(0x02), RC_TRANSPOSED(0x05),
+    RC_TRANSPOSED(0x0b), RC_TRANSPOSED(0x17), RC_TRANSPOSED(0x2e),
+    RC_TRANSPOSED(0x1c), RC_TRANSPOSED(0x38), RC_TRANSPOSED(0x31),
+    RC_TRANSPOSED(0x23), RC_TRANSPOSED(0x06), RC_TRANSPOSED(0x0d),
+    RC_TRANSPOSED(0x1b), RC_TRANSPOSED(0x36), RC_TRANSPOSED(0x2d),
+    RC_TRANSPOSED(0x1a), RC_TRANSPOSED(0x34), RC_TRANSPOSED(0x29),
+    RC_TRANSPOSED(0x12), RC_TRANSPOSED(0x24), RC_TRANSPOSED(0x08),
+    RC_TRANSPOSED(0x11), RC_TRANSPOSED(0x22),
+};
+
+void
+unrolled_key(struct UnrolledKey* uk, const uint64_t* subkey, uint16_t Rounds)
+{
+    uint16_t i;
+
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+    for (i = 0; i < Rounds; i++) {
+        uk->Normal[i]     = fixslice_pack(subkey[i]) ^ RcNormal[i];
+        uk->Transposed[i] = transpose_slices(uk->Normal[i]);
+    }
+    uk->Rounds = Rounds;
+}
+
+// The bodies below are written out for every round and guarded by the round
+// count. They are only instantiated with a constant Rounds, so the compiler
+// drops the rounds that are not needed, turns every key index and constant
+// into an immediate and can schedule across round boundaries.
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+// Key index k belongs to round k + 1, which starts transposed for odd k
+#define ENCRYPT_ROUND(k)                                                       \
+    if ((k) + 1 < Rounds) {                                                    \
+        SBOX_LAYER(s0, s1, s2, s3);                                            \
+        if ((k) % 2 == 0) {                                                    \
+            ROWS_0(s0);                                                        \
+            ROWS_1(s1);                                                        \
+            ROWS_2(s2);                                                        \
+            ROWS_3(s3);                                                        \
+            ADD_KEY(s0, s1, s2, s3, uk->Transposed[k] ^ RcTransposed[k]);      \
+        } else {                                                               \
+            COLS_0(s0);                                                        \
+            COLS_1(s1);                                                        \
+            COLS_2(s2);                                                        \
+            COLS_3(s3);                                                        \
+            ADD_KEY(s0, s1, s2, s3, uk->Normal[k] ^ RcNormal[k]);              \
+        }                                                                      \
+    }
+
+ALWAYS_INLINE uint64_t
+encrypt_unrolled_body(uint64_t                  in,
+                      const struct UnrolledKey* uk,
+                      uint16_t                  Rounds)
+{
+    uint64_t state = fixslice_pack(in);
+    uint32_t s0    = state & 0xFFFF;
+    uint32_t s1    = (state >> 16) & 0xFFFF;
+    uint32_t s2    = (state >> 32) & 0xFFFF;
+    uint32_t s3    = state >> 48;
+
+    ENCRYPT_ROUND(0);
+    ENCRYPT_ROUND(1);
+    ENCRYPT_ROUND(2);
+    ENCRYPT_ROUND(3);
+    ENCRYPT_ROUND(4);
+    ENCRYPT_ROUND(5);
+    ENCRYPT_ROUND(6);
+    ENCRYPT_ROUND(7);
+    ENCRYPT_ROUND(8);
+    ENCRYPT_ROUND(9);
+    ENCRYPT_ROUND(10);
+    ENCRYPT_ROUND(11);
+    ENCRYPT_ROUND(12);
+    ENCRYPT_ROUND(13);
+    ENCRYPT_ROUND(14);
+    ENCRYPT_ROUND(15);
+    ENCRYPT_ROUND(16);
+    ENCRYPT_ROUND(17);
+    ENCRYPT_ROUND(18);
+    ENCRYPT_ROUND(19);
+    ENCRYPT_ROUND(20);
+    ENCRYPT_ROUND(21);
+    ENCRYPT_ROUND(22);
+    ENCRYPT_ROUND(23);
+    ENCRYPT_ROUND(24);
+    ENCRYPT_ROUND(25);
+    ENCRYPT_ROUND(26);
+    ENCRYPT_ROUND(27);
+    ENCRYPT_ROUND(28);
+    ENCRYPT_ROUND(29);
+    ENCRYPT_ROUND(30);
+    ENCRYPT_ROUND(31);
+    ENCRYPT_ROUND(32);
+    ENCRYPT_ROUND(33);
+    ENCRYPT_ROUND(34);
+    ENCRYPT_ROUND(35);
+    ENCRYPT_ROUND(36);
+    ENCRYPT_ROUND(37);
+    ENCRYPT_ROUND(38);
+    ENCRYPT_ROUND(39);
+    ENCRYPT_ROUND(40);
+    ENCRYPT_ROUND(41);
+    ENCRYPT_ROUND(42);
+    ENCRYPT_ROUND(43);
+    ENCRYPT_ROUND(44);
+    ENCRYPT_ROUND(45);
+    state = (s0 & 0xFFFF) | ((uint64_t)(s1 & 0xFFFF) << 16) |
+            ((uint64_t)(s2 & 0xFFFF) << 32) | ((uint64_t)(s3 & 0xFFFF) << 48);
+    if (Rounds > 1 && !(Rounds & 1))
+        state = transpose_slices(state);
+    return fixslice_unpack(state);
+}
+
+// Round r uses key index Rounds - r and starts in the normal layout when r is
+// odd
+#define DECRYPT_ROUND(r)                                                       \
+    if ((r) < Rounds) {                                                        \
+        if ((r) % 2 == 1) {                                                    \
+            ADD_KEY(s0,                                                        \
+                    s1,                                                        \
+                    s2,                                                        \
+                    s3,                                                        \
+                    uk->Normal[Rounds - (r)] ^ RcNormal[Rounds - (r)]);        \
+            COLS_0(s0);                                                        \
+            COLS_1(s1);                                                        \
+            COLS_2(s2);                                                        \
+            COLS_3(s3);                                                        \
+        } else {                                                               \
+            ADD_KEY(s0,                                                        \
+                    s1,                                                        \
+                    s2,                                                        \
+                    s3,                                                        \
+                    uk->Transposed[Rounds - (r)] ^                             \
+                      RcTransposed[Rounds - (r)]);                             \
+            ROWS_0(s0);                                                        \
+            ROWS_1(s1);                                                        \
+            ROWS_2(s2);                                                        \
+            ROWS_3(s3);                                                        \
+        }                                                                      \
+        SBOX_INV_LAYER(s0, s1, s2, s3);                                        \
+    }
+
+ALWAYS_INLINE uint64_t
+decrypt_unrolled_body(uint64_t                  in,
+                      const struct UnrolledKey* uk,
+                      uint16_t                  Rounds)
+{
+    uint64_t state = fixslice_pack(in);
+    uint32_t s0    = state & 0xFFFF;
+    uint32_t s1    = (state >> 16) & 0xFFFF;
+    uint32_t s2    = (state >> 32) & 0xFFFF;
+    uint32_t s3    = state >> 48;
+
+    if (Rounds == 0)
+        return in;
+
+    DECRYPT_ROUND(1);
+    DECRYPT_ROUND(2);
+    DECRYPT_ROUND(3);
+    DECRYPT_ROUND(4);
+    DECRYPT_ROUND(5);
+    DECRYPT_ROUND(6);
+    DECRYPT_ROUND(7);
+    DECRYPT_ROUND(8);
+    DECRYPT_ROUND(9);
+    DECRYPT_ROUND(10);
+    DECRYPT_ROUND(11);
+    DECRYPT_ROUND(12);
+    DECRYPT_ROUND(13);
+    DECRYPT_ROUND(14);
+    DECRYPT_ROUND(15);
+    DECRYPT_ROUND(16);
+    DECRYPT_ROUND(17);
+    DECRYPT_ROUND(18);
+    DECRYPT_ROUND(19);
+    DECRYPT_ROUND(20);
+    DECRYPT_ROUND(21);
+    DECRYPT_ROUND(22);
+    DECRYPT_ROUND(23);
+    DECRYPT_ROUND(24);
+    DECRYPT_ROUND(25);
+    DECRYPT_ROUND(26);
+    DECRYPT_ROUND(27);
+    DECRYPT_ROUND(28);
+    DECRYPT_ROUND(29);
+    DECRYPT_ROUND(30);
+    DECRYPT_ROUND(31);
+    DECRYPT_ROUND(32);
+    DECRYPT_ROUND(33);
+    DECRYPT_ROUND(34);
+    DECRYPT_ROUND(35);
+    DECRYPT_ROUND(36);
+    DECRYPT_ROUND(37);
+    DECRYPT_ROUND(38);
+    DECRYPT_ROUND(39);
+    DECRYPT_ROUND(40);
+    DECRYPT_ROUND(41);
+    DECRYPT_ROUND(42);
+    DECRYPT_ROUND(43);
+    DECRYPT_ROUND(44);
+    DECRYPT_ROUND(45);
+    DECRYPT_ROUND(46);
+    // The last round only adds the first round key
+    state = (s0 & 0xFFFF) | ((uint64_t)(s1 & 0xFFFF) << 16) |
+            ((uint64_t)(s2 & 0xFFFF) << 32) | ((uint64_t)(s3 & 0xFFFF) << 48);
+    if (Rounds & 1) {
+        state ^= uk->Normal[0] ^ RcNormal[0];
+    } else {
+        state ^= uk->Transposed[0] ^ RcTransposed[0];
+        state = transpose_slices(state);
+    }
+    return fixslice_unpack(state);
+}
+
+// One instance per supported round count
+#define UNROLLED_ROUNDS(X)                                                  \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) \
+    X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) \
+    X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31) \
+    X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39) \
+    X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47)
+#define DEFINE_UNROLLED(R)                                                     \
+    static uint64_t encrypt_r##R(uint64_t in, const struct UnrolledKey* uk)    \
+    {                                                                          \
+        return encrypt_unrolled_body(in, uk, R);                               \
+    }                                                                          \
+    static uint64_t decrypt_r##R(uint64_t in, const struct UnrolledKey* uk)    \
+    {                                                                          \
+        return decrypt_unrolled_body(in, uk, R);                               \
+    }
+#define ENCRYPT_ENTRY(R) encrypt_r##R,
+#define DECRYPT_ENTRY(R) decrypt_r##R,
+
+UNROLLED_ROUNDS(DEFINE_UNROLLED)
+
+static const UnrolledCipher EncryptUnrolled[] = { UNROLLED_ROUNDS(
+  ENCRYPT_ENTRY) };
+static const UnrolledCipher DecryptUnrolled[] = { UNROLLED_ROUNDS(
+  DECRYPT_ENTRY) };
+
+//----------------------------------
+// Dispatch
+//----------------------------------
+UnrolledCipher
+unrolled_encrypt_for(uint16_t Rounds)
+{
+    return Rounds <= 47 ? EncryptUnrolled[Rounds] : NULL;
+}
+
+UnrolledCipher
+unrolled_decrypt_for(uint16_t Rounds)
+{
+    return Rounds <= 47 ? DecryptUnrolled[Rounds] : NULL;
+}
+
+uint64_t
+encrypt_unrolled(uint64_t in, const struct UnrolledKey* uk)
+{
+    return EncryptUnrolled[uk->Rounds](in, uk);
+}
+
+uint64_t
+decrypt_unrolled(uint64_t in, const struct UnrolledKey* uk)
+{
+    return DecryptUnrolled[uk->Rounds](in, uk);
+}
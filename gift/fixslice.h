@@ -0,0 +1,79 @@
+/**
+ * Fixsliced implementation of GIFT-64, one block per call
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The block is held as four 16-bit slices (slice b holds bit b of every
+ * nibble), where the S-Box is a handful of boolean operations. Within a slice
+ * the P-Box is a transpose of the 4x4 nibble grid combined with a cheap row
+ * swap. Every other round the state is left transposed, which turns the next
+ * row swap into a column swap and cancels both transposes, so no round needs
+ * a general bit permutation. The round keys are converted once, in both
+ * layouts, by fixslice_key().
+ *
+ * No lookups depend on the key or the data, so the code runs in constant time.
+ *
+ * encrypt_unrolled() and decrypt_unrolled() run the same rounds from a
+ * separate kernel for every round count, fully unrolled with the round
+ * constants as immediates. Their UnrolledKey holds only the key material;
+ * unrolled_key() removes the constants that key_schedule() added.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct FixsliceKey
+{
+    uint64_t Normal[47];     // round keys as 4 packed slices
+    uint64_t Transposed[47]; // the same, for rounds left transposed
+    uint16_t Rounds;
+};
+
+// Same layout as FixsliceKey, without the round constants
+struct UnrolledKey
+{
+    uint64_t Normal[47];
+    uint64_t Transposed[47];
+    uint16_t Rounds;
+};
+
+typedef uint64_t (*UnrolledCipher)(uint64_t in, const struct UnrolledKey* uk);
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+uint64_t
+fixslice_pack(uint64_t in);
+
+uint64_t
+fixslice_unpack(uint64_t in);
+
+void
+fixslice_key(struct FixsliceKey* fk, const uint64_t* subkey, uint16_t Rounds);
+
+uint64_t
+encrypt_fixslice(uint64_t in, const struct FixsliceKey* fk);
+
+uint64_t
+decrypt_fixslice(uint64_t in, const struct FixsliceKey* fk);
+
+void
+unrolled_key(struct UnrolledKey* uk, const uint64_t* subkey, uint16_t Rounds);
+
+// The kernels for a round count (0 to 47), NULL for any other count
+UnrolledCipher
+unrolled_encrypt_for(uint16_t Rounds);
+
+UnrolledCipher
+unrolled_decrypt_for(uint16_t Rounds);
+
+// Dispatch on uk->Rounds
+uint64_t
+encrypt_unrolled(uint64_t in, const struct UnrolledKey* uk);
+
+uint64_t
+decrypt_unrolled(uint64_t in, const struct UnrolledKey* uk);
@@ -25,9 +25,79 @@
 #include <stdio.h> //Standard C headers...
 #include <stdlib.h>
 
-#include "comline.h" // Command Line
-#include "crypto.h"  // Crypto functions
-#include "verbose.h" // For verbose output
+#include "comline.h"  // Command Line
+#include "crypto.h"   // Crypto functions
+#include "fixslice.h" // Fast single-block GIFT-64
+#include "modes.h"    // ECB, CBC and CTR
+#include "simd.h"     // SSSE3/AVX2 kernels
+#include "verbose.h"  // For verbose output
+
+//----------------------------------
+// Modes of operation
+//----------------------------------
+#define MODE_BATCH 1024 // blocks per call of modes.c
+
+// Encrypts or decrypts the blocks on stdin, one hexadecimal block per line,
+// in the mode of --mode and prints them the same way. The text is the IV of
+// CBC or the first counter block of CTR, and its length sets the block size.
+// The blocks go to modes.c in batches, so the multi-block kernels get many of
+// them per call; the IV or counter carries over from one batch to the next.
+static int
+mode_run(const struct Options* Opt)
+{
+    static uint64_t buf[2 * MODE_BATCH];
+    struct ModeKey  mk;
+    uint64_t        iv[2] = { Opt->Text, Opt->TextHigh };
+    char            line[128];
+    size_t          n, i;
+    _Bool           more = 1;
+
+    mode_key_init(
+      &mk, Opt->KeyHigh, Opt->KeyLow, Opt->Rounds, Opt->BlockSize64);
+
+    while (more) {
+        for (n = 0; n < MODE_BATCH;) {
+            if (fgets(line, sizeof(line), stdin) == NULL) {
+                more = 0;
+                break;
+            }
+            if (line[0] == '\n')
+                continue;
+            // Low word first in buf, high word first on the line
+            if (Opt->BlockSize64
+                  ? sscanf(line, "%16" SCNx64, &buf[n]) != 1
+                  : sscanf(line,
+                           "%16" SCNx64 "%16" SCNx64,
+                           &buf[2 * n + 1],
+                           &buf[2 * n]) != 2) {
+                fprintf(stderr, "Not a block: %s", line);
+                return 1;
+            }
+            n++;
+        }
+
+        if (Opt->Chaining == Chain_ECB && Opt->Mode == Encrypt_Mode)
+            ecb_encrypt(&mk, buf, n);
+        else if (Opt->Chaining == Chain_ECB)
+            ecb_decrypt(&mk, buf, n);
+        else if (Opt->Chaining == Chain_CBC && Opt->Mode == Encrypt_Mode)
+            cbc_encrypt(&mk, iv, buf, n);
+        else if (Opt->Chaining == Chain_CBC)
+            cbc_decrypt(&mk, iv, buf, n);
+        else
+            ctr_crypt(&mk, iv, buf, n);
+
+        for (i = 0; i < n; i++) {
+            if (Opt->BlockSize64)
+                printf("%016" PRIx64 "\n", buf[i]);
+            else
+                printf("%016" PRIx64 " %016" PRIx64 "\n",
+                       buf[2 * i + 1],
+                       buf[2 * i]);
+        }
+    }
+    return 0;
+}
 
 //----------------------------------
 // Start of code
@@ -36,9 +106,9 @@ int
 main(int argc, char** const argv)
 {
     // Initialize variables
-    uint64_t       result;
-    uint64_t*      result128 = NULL;
-    struct Options Opt;
+    uint64_t        result;
+    struct Block128 result128;
+    struct Options  Opt;
 
     // Get Commandline Options
     comline_fetch_options(&Opt, argc, argv);
@@ -53,8 +123,18 @@ main(int argc, char** const argv)
         printf("---------------------------------------\n\n");
     }
 
+    // Check the vector kernels against the reference code
+    if (Opt.SelfTest && !Opt.Error)
+        return simd_selftest(Opt.Verbose != 0) != 0;
+
+    // Many blocks from stdin
+    if (!Opt.Error && Opt.Chaining != Chain_None)
+        return mode_run(&Opt);
+
     if (!Opt.Error) {
-        uint64_t* subkey = NULL;
+        struct KeySchedule ks;
+        struct UnrolledKey uk;
+        struct Block128Key key128;
         if (Opt.BlockSize64) {
 
             if (Opt.Mode == Encrypt_Mode) {
@@ -75,17 +155,15 @@ main(int argc, char** const argv)
                 }
 
                 // Generate Subkeys
-                subkey = key_schedule(Opt.KeyHigh,
-                                      Opt.KeyLow,
-                                      Opt.Rounds,
-                                      Opt.KeySize80,
-                                      (Opt.Verbose > 1));
+                key_schedule_init(
+                  &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+
+                unrolled_key(&uk, ks.Subkey, Opt.Rounds);
 
                 // Start Encryption
                 if (Opt.Verbose != 0)
                     printf("Starting encryption...\n");
-                result =
-                  encrypt(Opt.Text, subkey, Opt.Rounds, (Opt.Verbose > 1));
+                result = unrolled_encrypt_for(Opt.Rounds)(Opt.Text, &uk);
                 if (Opt.Verbose != 0)
                     printf("Resulting Cipher: %016" PRIx64 " \n\n", result);
                 else
@@ -110,30 +188,27 @@ main(int argc, char** const argv)
                 }
 
                 // Generate Subkeys
-                subkey = key_schedule(Opt.KeyHigh,
-                                      Opt.KeyLow,
-                                      Opt.Rounds,
-                                      Opt.KeySize80,
-                                      (Opt.Verbose > 1));
+                key_schedule_init(
+                  &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+
+                unrolled_key(&uk, ks.Subkey, Opt.Rounds);
 
                 // Start Decryption
                 if (Opt.Verbose != 0)
                     printf("Starting decryption...\n");
-                result =
-                  decrypt(Opt.Text, subkey, Opt.Rounds, (Opt.Verbose > 1));
+                result = unrolled_decrypt_for(Opt.Rounds)(Opt.Text, &uk);
                 if (Opt.Verbose != 0)
                     printf("Resulting Plaintext: %016" PRIx64 " \n", result);
                 else
                     printf("%016" PRIx64 "\n", result);
             }
-
-            free(subkey);
         }
 
         else {
 
-            subkey = key_schedule128(
-              Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, (Opt.Verbose > 1));
+            // encrypt128() always runs 40 rounds, expand them all
+            key_schedule128_init(&ks, Opt.KeyHigh, Opt.KeyLow, MAX_ROUNDS);
+            block128_key(&key128, ks.Subkey, Opt.Rounds);
 
             // printf("128-bit option reached\n");
 
@@ -159,20 +234,18 @@ main(int argc, char** const argv)
 
                 if (Opt.Verbose != 0)
                     printf("Starting encryption...\n");
-                result128 = encrypt128(Opt.TextHigh,
-                                       Opt.Text,
-                                       subkey,
-                                       Opt.Rounds,
-                                       (Opt.Verbose > 1));
+                result128.High = Opt.TextHigh;
+                result128.Low  = Opt.Text;
+                encrypt128_block(&result128, &key128);
                 if (Opt.Verbose != 0)
                     printf("Resulting Cipher: %016" PRIx64 " %016" PRIx64
                            " \n\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
                 else
                     printf("%016" PRIx64 " %016" PRIx64 "\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
             } else if (Opt.Mode == Decrypt_Mode) {
 
                 if (Opt.Verbose != 0) {
@@ -194,24 +267,19 @@ main(int argc, char** const argv)
 
                 if (Opt.Verbose != 0)
                     printf("Starting decryption...\n");
-                result128 = decrypt128(Opt.TextHigh,
-                                       Opt.Text,
-                                       subkey,
-                                       Opt.Rounds,
-                                       (Opt.Verbose > 1));
+                result128.High = Opt.TextHigh;
+                result128.Low  = Opt.Text;
+                decrypt128_block(&result128, &key128);
                 if (Opt.Verbose != 0)
                     printf("Resulting Plaintext: %016" PRIx64 " %016" PRIx64
                            " \n\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
                 else
                     printf("%016" PRIx64 " %016" PRIx64 "\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
             }
-
-            free(subkey);
-            free(result128);
         }
 
     }
@@ -231,6 +299,11 @@ main(int argc, char** const argv)
         printf("-k key: Key in hexadecimal (length: *EXACTLY* 20 "
                "chars(80bit)/32 chars(128bit))\n");
         printf("-t text: Text in hexadecimal (length: *EXACTLY* 16 chars)\n");
+        printf("--mode m (optional): Encrypt or decrypt the blocks on stdin, "
+               "one per line, in\n");
+        printf("   mode ecb, cbc or ctr; text is the IV or first counter "
+               "block and its length\n");
+        printf("   (16 or 32 chars) sets the block size\n");
         printf("If -f is set, key and text represent files containing the "
                "values,\n");
         printf("otherwise they must be passed directly via commandline.\n\n");
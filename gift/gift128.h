@@ -5,8 +5,28 @@ Email: crypto.s.m.sim@gmail.com
 Date: 08 Feb 2019
 */
 
+#pragma once
+#include <stddef.h>
 #include <stdint.h>
 
+/*Round keys of giftb128(), expanded once per key by giftb128_key()*/
+struct Gift128Key
+{
+    uint32_t Rk[40][4];
+};
+
+void
+giftb128_key(struct Gift128Key* key, const uint8_t K[16]);
+void
+giftb128_encrypt(uint8_t P[16], const struct Gift128Key* key, uint8_t C[16]);
+/*n independent blocks of 16 bytes, several at a time in SIMD lanes when the
+  CPU has them. P and C may be the same buffer.*/
+void
+giftb128_blocks(uint8_t*                 P,
+                size_t                   n,
+                const struct Gift128Key* key,
+                uint8_t*                 C);
+
 void
 giftb128(uint8_t P[16], const uint8_t K[16], uint8_t C[16]);
 void
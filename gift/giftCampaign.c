@@ -0,0 +1,583 @@
+/**
+ * Campaign runner for giftCycle
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * A campaign file lists the runs of giftCycle to make, and giftCampaign
+ * runs them on local worker processes, one job per process. Workers do not
+ * own a share of the jobs: whichever worker is idle first takes the next
+ * job, so one long job never leaves the other cores waiting behind it.
+ *
+ * The file is read line by line, # starts a comment:
+ *
+ *   program ../bin/giftCycle     (relative to the campaign file, standard is
+ *                                 the giftCycle next to giftCampaign)
+ *   mode e d                     (standard e)
+ *   rounds 29 32                 (standard: the giftCycle default)
+ *   options --max-steps 1000000  (passed on to every job)
+ *   key 1234567887654321abab1234dfec2f3c
+ *   text 0122158975785254 89464aabaac87187
+ *
+ * Every key takes the texts that follow it, up to the next key, and every
+ * (key, text) pair is run once for every mode and round count. Each job runs
+ * as
+ *
+ *   program -v 0 -e|-d [-r rounds] -k key -t text options...
+ *
+ * Everything goes to one output of key=value records. A campaign line and
+ * one job line per job come first, the rest is written as it happens, so a
+ * campaign that is cut short still has the jobs it finished:
+ *
+ *   start job=3 mode=e rounds=29 key=... text=...
+ *   out job=3 Cycle length 4005693
+ *   err job=3 progress elapsed=60.0 steps=...
+ *   end job=3 status=0 seconds=12.5
+ *   ...
+ *   finished jobs=35 failed=0 seconds=3600.2
+ *
+ * The stdout of a job goes to out records and its stderr (progress lines,
+ * error messages, and the message of a job that could not be run at all) to
+ * err records. Lines of jobs running at the same time interleave, the job
+ * number tells them apart. Whenever a job ends a campaign line goes to
+ * stderr.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "progress.h"
+
+#define MAX_WORDS 64    // words on one line of a campaign file
+#define LINE_SIZE 4096  // longest output line kept whole
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct Job
+{
+    const char* Key;
+    const char* Text;
+    const char* Rounds; // NULL for the giftCycle default
+    char        Mode;   // 'e' or 'd'
+};
+
+struct Campaign
+{
+    char*        Program;
+    char         Modes[2];
+    unsigned     ModeCount;
+    char**       Rounds;
+    unsigned     RoundCount;
+    char**       Options;
+    unsigned     OptionCount;
+    struct Job*  Job;
+    size_t       JobCount;
+    size_t       JobSize;
+};
+
+// One output of a job, read through a pipe
+struct JobStream
+{
+    int    Fd; // -1 once the job closed it
+    char   Line[LINE_SIZE];
+    size_t Used;
+};
+
+struct Worker
+{
+    pid_t            Pid; // 0 while idle
+    size_t           Job;
+    double           Start;
+    struct JobStream Stream[2]; // the job's stdout and stderr
+};
+
+// The record of each stream of a job
+static const char* const StreamRecord[2] = { "out", "err" };
+
+//----------------------------------
+// Campaign files
+//----------------------------------
+static _Bool
+is_hex(const char* s, size_t length)
+{
+    return strlen(s) == length && strspn(s, "0123456789abcdefABCDEF") == length;
+}
+
+static char*
+copy(const char* s)
+{
+    char* c = malloc(strlen(s) + 1);
+
+    if (c != NULL)
+        strcpy(c, s);
+    return c;
+}
+
+// A path of the campaign file is taken from where the file lies
+static char*
+relative_to(const char* file, const char* path)
+{
+    const char* slash = strrchr(file, '/');
+    size_t      dir   = slash != NULL ? (size_t)(slash - file) + 1 : 0;
+    char*       c;
+
+    if (path[0] == '/' || dir == 0)
+        return copy(path);
+    c = malloc(dir + strlen(path) + 1);
+    if (c != NULL) {
+        memcpy(c, file, dir);
+        strcpy(c + dir, path);
+    }
+    return c;
+}
+
+static char**
+copy_words(char** word, unsigned count)
+{
+    char**   c = calloc(count ? count : 1, sizeof(char*));
+    unsigned i;
+
+    for (i = 0; c != NULL && i < count; i++) {
+        c[i] = copy(word[i]);
+    }
+    return c;
+}
+
+static int
+add_job(struct Campaign* cp, const char* key, const char* text)
+{
+    struct Job* grown;
+    struct Job* job;
+    unsigned    m, r;
+
+    for (m = 0; m < cp->ModeCount; m++) {
+        for (r = 0; r < (cp->RoundCount ? cp->RoundCount : 1); r++) {
+            if (cp->JobCount == cp->JobSize) {
+                cp->JobSize = cp->JobSize ? 2 * cp->JobSize : 64;
+                grown       = realloc(cp->Job, cp->JobSize * sizeof(*grown));
+                if (grown == NULL)
+                    return -1;
+                cp->Job = grown;
+            }
+            job         = &cp->Job[cp->JobCount++];
+            job->Key    = key;
+            job->Text   = text;
+            job->Rounds = cp->RoundCount ? cp->Rounds[r] : NULL;
+            job->Mode   = cp->Modes[m];
+        }
+    }
+    return 0;
+}
+
+// Returns 0, or -1 after printing what is wrong with the file. mode, rounds
+// and options have to come before the first text they apply to.
+static int
+campaign_load(struct Campaign* cp, const char* file)
+{
+    FILE*       f = fopen(file, "r");
+    char        line[LINE_SIZE], *word[MAX_WORDS], *key = NULL, *text;
+    unsigned    n, i, lineNr = 0;
+    const char* error = NULL;
+
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open %s: %s\n", file, strerror(errno));
+        return -1;
+    }
+    while (error == NULL && fgets(line, sizeof(line), f) != NULL) {
+        lineNr++;
+        if (strchr(line, '#') != NULL)
+            *strchr(line, '#') = '\0';
+        n = 0;
+        word[n] = strtok(line, " \t\r\n");
+        while (word[n] != NULL && n + 1 < MAX_WORDS) {
+            word[++n] = strtok(NULL, " \t\r\n");
+        }
+        if (n == 0)
+            continue;
+
+        if (strcmp(word[0], "program") == 0 && n == 2) {
+            free(cp->Program);
+            cp->Program = relative_to(file, word[1]);
+        } else if (strcmp(word[0], "mode") == 0 && n >= 2 && n <= 3) {
+            cp->ModeCount = 0;
+            for (i = 1; i < n; i++) {
+                if (strcmp(word[i], "e") != 0 && strcmp(word[i], "d") != 0)
+                    error = "mode is e or d";
+                cp->Modes[cp->ModeCount++] = word[i][0];
+            }
+        } else if (strcmp(word[0], "rounds") == 0 && n >= 2) {
+            for (i = 1; i < n; i++) {
+                if (strspn(word[i], "0123456789") != strlen(word[i]))
+                    error = "rounds are numbers";
+            }
+            cp->Rounds     = copy_words(word + 1, n - 1);
+            cp->RoundCount = n - 1;
+        } else if (strcmp(word[0], "options") == 0) {
+            cp->Options     = copy_words(word + 1, n - 1);
+            cp->OptionCount = n - 1;
+        } else if (strcmp(word[0], "key") == 0 && n == 2) {
+            if (!is_hex(word[1], 20) && !is_hex(word[1], 32))
+                error = "a key has 20 or 32 hex digits";
+            key = copy(word[1]);
+        } else if (strcmp(word[0], "text") == 0 && n >= 2) {
+            if (key == NULL)
+                error = "text before the first key";
+            for (i = 1; error == NULL && i < n; i++) {
+                if (!is_hex(word[i], 16) && !is_hex(word[i], 32))
+                    error = "a text has 16 or 32 hex digits";
+                else if ((text = copy(word[i])) == NULL
+                         || add_job(cp, key, text) != 0)
+                    error = "out of memory";
+            }
+        } else
+            error = "unknown or incomplete line";
+    }
+    fclose(f);
+
+    if (error != NULL) {
+        fprintf(stderr, "%s:%u: %s\n", file, lineNr, error);
+        return -1;
+    }
+    return 0;
+}
+
+//----------------------------------
+// Workers
+//----------------------------------
+// Starts job j on w with its stdout and stderr on pipes. Returns 0, or -1 if
+// the process could not be made.
+static int
+job_start(FILE* out, const struct Campaign* cp, struct Worker* w, size_t j)
+{
+    const struct Job* job = &cp->Job[j];
+    char*             argv[12 + MAX_WORDS];
+    char              mode[3] = { '-', job->Mode, '\0' };
+    unsigned          n = 0, i;
+    int               fd[2], err[2];
+
+    argv[n++] = cp->Program;
+    argv[n++] = "-v";
+    argv[n++] = "0";
+    argv[n++] = mode;
+    if (job->Rounds != NULL) {
+        argv[n++] = "-r";
+        argv[n++] = (char*)job->Rounds;
+    }
+    argv[n++] = "-k";
+    argv[n++] = (char*)job->Key;
+    argv[n++] = "-t";
+    argv[n++] = (char*)job->Text;
+    for (i = 0; i < cp->OptionCount; i++) {
+        argv[n++] = cp->Options[i];
+    }
+    argv[n] = NULL;
+
+    if (pipe(fd) != 0)
+        return -1;
+    if (pipe(err) != 0) {
+        close(fd[0]);
+        close(fd[1]);
+        return -1;
+    }
+    fprintf(out,
+            "start job=%zu mode=%c rounds=%s key=%s text=%s\n",
+            j,
+            job->Mode,
+            job->Rounds ? job->Rounds : "-",
+            job->Key,
+            job->Text);
+    fflush(NULL);
+    w->Pid = fork();
+    if (w->Pid < 0) {
+        w->Pid = 0;
+        close(fd[0]);
+        close(fd[1]);
+        close(err[0]);
+        close(err[1]);
+        return -1;
+    }
+    if (w->Pid == 0) {
+        dup2(fd[1], STDOUT_FILENO);
+        dup2(err[1], STDERR_FILENO);
+        close(fd[0]);
+        close(fd[1]);
+        close(err[0]);
+        close(err[1]);
+        execv(argv[0], argv);
+        fprintf(stderr, "Cannot run %s: %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+    close(fd[1]);
+    close(err[1]);
+    w->Stream[0].Fd   = fd[0];
+    w->Stream[0].Used = 0;
+    w->Stream[1].Fd   = err[0];
+    w->Stream[1].Used = 0;
+    w->Job            = j;
+    w->Start          = progress_now();
+    return 0;
+}
+
+static void
+job_line(FILE* out, const struct Worker* w, unsigned s)
+{
+    const struct JobStream* st = &w->Stream[s];
+
+    fprintf(out,
+            "%s job=%zu %.*s\n",
+            StreamRecord[s],
+            w->Job,
+            (int)st->Used,
+            st->Line);
+}
+
+// Passes on the whole lines read so far, and whatever is left at the end
+static void
+job_read(FILE* out, struct Worker* w, unsigned s, const char* data, size_t size)
+{
+    struct JobStream* st = &w->Stream[s];
+    size_t            i;
+
+    for (i = 0; i < size; i++) {
+        if (data[i] == '\n' || st->Used == LINE_SIZE) {
+            job_line(out, w, s);
+            st->Used = 0;
+            if (data[i] == '\n')
+                continue;
+        }
+        st->Line[st->Used++] = data[i];
+    }
+    fflush(out);
+}
+
+// The job closed stream s, most likely by exiting
+static void
+job_close(FILE* out, struct Worker* w, unsigned s)
+{
+    struct JobStream* st = &w->Stream[s];
+
+    if (st->Used != 0)
+        job_line(out, w, s);
+    close(st->Fd);
+    st->Fd = -1;
+}
+
+// Once both streams are closed
+static int
+job_end(FILE* out, struct Worker* w)
+{
+    int status = 0;
+
+    while (waitpid(w->Pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    if (WIFEXITED(status))
+        status = WEXITSTATUS(status);
+    else
+        status = 128 + WTERMSIG(status);
+    fprintf(out,
+            "end job=%zu status=%d seconds=%.1f\n",
+            w->Job,
+            status,
+            progress_now() - w->Start);
+    fflush(out);
+    w->Pid = 0;
+    return status;
+}
+
+//----------------------------------
+// Start of code
+//----------------------------------
+static void
+usage(void)
+{
+    printf("Syntax:\n");
+    printf("giftCampaign [-j workers] [-o file] [-n] campaign\n\n");
+    printf("Runs the giftCycle jobs of the campaign file on local "
+           "processes\n\n");
+    printf("-j workers (optional): Jobs at once (standard is one per core)\n");
+    printf("-o file (optional): Write the records to file instead of "
+           "stdout\n");
+    printf("-n (optional): Only print the jobs\n\n");
+    printf("Returned Errorlevel: 0 if every job returned 0, 1 if not\n");
+}
+
+int
+main(int argc, char** const argv)
+{
+    struct Campaign cp;
+    struct Worker*  worker;
+    struct pollfd*  ready;
+    FILE*           out = stdout;
+    long            cores = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned        workers = cores > 0 ? (unsigned)cores : 1;
+    unsigned        running = 0, i, s;
+    size_t          next = 0, done = 0, failed = 0;
+    _Bool           dryRun = 0;
+    char            data[LINE_SIZE];
+    ssize_t         got;
+    const char*     slash;
+    double          start;
+    int             c;
+
+    while ((c = getopt(argc, argv, "j:o:n")) != -1) {
+        switch (c) {
+            case 'j':
+                workers = (unsigned)strtoul(optarg, NULL, 0);
+                if (workers == 0 || workers > 4096) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'o':
+                out = fopen(optarg, "a");
+                if (out == NULL) {
+                    fprintf(stderr,
+                            "Cannot open %s: %s\n",
+                            optarg,
+                            strerror(errno));
+                    return 1;
+                }
+                break;
+            case 'n':
+                dryRun = 1;
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (optind + 1 != argc) {
+        usage();
+        return 1;
+    }
+
+    memset(&cp, 0, sizeof(cp));
+    cp.Modes[0]  = 'e';
+    cp.ModeCount = 1;
+    slash        = strrchr(argv[0], '/');
+    if (slash != NULL) {
+        cp.Program = malloc(slash - argv[0] + sizeof("/giftCycle"));
+        if (cp.Program != NULL) {
+            memcpy(cp.Program, argv[0], slash - argv[0]);
+            strcpy(cp.Program + (slash - argv[0]), "/giftCycle");
+        }
+    } else
+        cp.Program = copy("giftCycle");
+    if (campaign_load(&cp, argv[optind]) != 0)
+        return 1;
+
+    fprintf(out,
+            "campaign file=%s program=%s jobs=%zu workers=%u\n",
+            argv[optind],
+            cp.Program,
+            cp.JobCount,
+            workers);
+    for (next = 0; next < cp.JobCount; next++) {
+        fprintf(out,
+                "job job=%zu mode=%c rounds=%s key=%s text=%s\n",
+                next,
+                cp.Job[next].Mode,
+                cp.Job[next].Rounds ? cp.Job[next].Rounds : "-",
+                cp.Job[next].Key,
+                cp.Job[next].Text);
+    }
+    fflush(out);
+    if (dryRun)
+        return 0;
+
+    if (workers > cp.JobCount)
+        workers = cp.JobCount ? (unsigned)cp.JobCount : 1;
+    worker = calloc(workers, sizeof(struct Worker));
+    ready  = calloc(2 * workers, sizeof(struct pollfd));
+    if (worker == NULL || ready == NULL) {
+        fprintf(stderr, "Not enough memory for %u workers\n", workers);
+        return 1;
+    }
+    // A job whose reader went away should not take the runner down with it
+    signal(SIGPIPE, SIG_IGN);
+
+    start = progress_now();
+    next  = 0;
+    while (next < cp.JobCount || running > 0) {
+        // Idle workers take the next jobs
+        for (i = 0; i < workers && next < cp.JobCount; i++) {
+            if (worker[i].Pid != 0)
+                continue;
+            if (job_start(out, &cp, &worker[i], next) != 0) {
+                fprintf(stderr,
+                        "Cannot start job %zu: %s\n",
+                        next,
+                        strerror(errno));
+                if (running == 0)
+                    return 1;
+                break;
+            }
+            next++;
+            running++;
+        }
+
+        // Both streams of every worker, poll() skips the closed ones at -1
+        for (i = 0; i < workers; i++) {
+            for (s = 0; s < 2; s++) {
+                ready[2 * i + s].fd =
+                  worker[i].Pid != 0 ? worker[i].Stream[s].Fd : -1;
+                ready[2 * i + s].events = POLLIN;
+            }
+        }
+        if (poll(ready, 2 * workers, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "poll: %s\n", strerror(errno));
+            return 1;
+        }
+
+        for (i = 0; i < workers; i++) {
+            if (worker[i].Pid == 0)
+                continue;
+            for (s = 0; s < 2; s++) {
+                if (ready[2 * i + s].fd < 0 || ready[2 * i + s].revents == 0)
+                    continue;
+                got = read(worker[i].Stream[s].Fd, data, sizeof(data));
+                if (got > 0)
+                    job_read(out, &worker[i], s, data, (size_t)got);
+                else if (got == 0 || errno != EINTR)
+                    job_close(out, &worker[i], s);
+            }
+            if (worker[i].Stream[0].Fd >= 0 || worker[i].Stream[1].Fd >= 0)
+                continue;
+
+            if (job_end(out, &worker[i]) != 0)
+                failed++;
+            done++;
+            running--;
+            fprintf(stderr,
+                    "campaign elapsed=%.1f jobs=%zu/%zu running=%u "
+                    "failed=%zu\n",
+                    progress_now() - start,
+                    done,
+                    cp.JobCount,
+                    running,
+                    failed);
+        }
+    }
+
+    fprintf(out,
+            "finished jobs=%zu failed=%zu seconds=%.1f\n",
+            done,
+            failed,
+            progress_now() - start);
+    if (out != stdout)
+        fclose(out);
+    return failed != 0;
+}
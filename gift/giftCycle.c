@@ -24,10 +24,719 @@
 #include <stdint.h>
 #include <stdio.h> //Standard C headers...
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
-#include "comline.h" // Command Line
-#include "crypto.h"  // Crypto functions
-#include "verbose.h" // For verbose output
+#include "bidir.h"     // Bidirectional cycle walks
+#include "bitslice.h"  // Bitsliced GIFT-64
+#include "bscycle.h"   // Bitsliced cycle walks
+#include "comline.h"   // Command Line
+#include "crypto.h"    // Crypto functions
+#include "cycle.h"     // Parallel cycle search
+#include "cycle128.h"  // GIFT-128 cycle walks
+#include "decompose.h" // Cycles of scaled-down GIFT
+#include "fixslice.h"  // Fast single-block GIFT-64
+#include "hunt.h"      // Short cycles in a subspace
+#include "progress.h"  // Progress reports
+#include "verbose.h"   // For verbose output
+#include "walk.h"      // Multi-step walks
+
+//----------------------------------
+// Parallel cycle search
+//----------------------------------
+// Walks the orbits of text, text + 1, ... on all threads and prints every
+// cycle found with its length, representative and how many of the starting
+// texts lie on it. With a checkpoint file the search survives being killed:
+// run it again with --resume. With a store, orbits on cycles an earlier run
+// completed stop at their first distinguished point, and the cycles this run
+// completes are added to it.
+static int
+cycle_explore(const struct Options* Opt,
+              struct UnrolledKey*   uk,
+              const struct WalkKey* wk)
+{
+    struct CycleConfig cfg;
+    struct CycleSearch cs;
+    struct CycleInfo*  cycles;
+    struct DpStore     store;
+    struct DpStoreId   id;
+    uint64_t           count, added, i;
+    int                loaded = CHECKPOINT_NONE, stored = STORE_NONE;
+
+    cfg.Cipher     = Opt->Mode == Encrypt_Mode
+                       ? unrolled_encrypt_for(Opt->Rounds)
+                       : unrolled_decrypt_for(Opt->Rounds);
+    cfg.Key        = uk;
+    cfg.Walk       = Opt->Mode == Encrypt_Mode ? walk_encrypt_for(Opt->Rounds)
+                                               : walk_decrypt_for(Opt->Rounds);
+    cfg.WalkKey    = wk;
+    cfg.FirstStart = Opt->Text;
+    cfg.Orbits     = Opt->Orbits;
+    cfg.MaxSteps   = Opt->MaxSteps;
+    cfg.Threads    = Opt->Threads;
+    cfg.DpBits     = Opt->DpBits;
+    cfg.TableBits  = Opt->TableBits;
+
+    cfg.Checkpoint      = Opt->Checkpoint;
+    cfg.CheckpointEvery = Opt->CheckpointEvery;
+    cfg.KeyHigh         = Opt->KeyHigh;
+    cfg.KeyLow          = Opt->KeyLow;
+    cfg.Rounds          = Opt->Rounds;
+    cfg.Decrypt         = Opt->Mode == Decrypt_Mode;
+    cfg.ProgressEvery   = Opt->ProgressEvery;
+    cfg.Store           = NULL;
+
+    if (Opt->Store != NULL) {
+        id.KeyHigh = Opt->KeyHigh;
+        id.KeyLow  = Opt->KeyLow;
+        id.Rounds  = Opt->Rounds;
+        id.Decrypt = Opt->Mode == Decrypt_Mode;
+        id.DpBits  = Opt->DpBits;
+        stored     = dp_store_open(&store, Opt->Store, &id);
+        if (stored == STORE_CORRUPT || stored == STORE_MISMATCH) {
+            fprintf(stderr,
+                    "Cannot use the store %s: %s\n",
+                    Opt->Store,
+                    stored == STORE_CORRUPT
+                      ? "the file is damaged or cut short"
+                      : "it was kept for another key, cipher or --dp-bits");
+            return 1;
+        }
+        cfg.Store = &store;
+    }
+
+    if (cycle_search_init(&cs, &cfg) != 0) {
+        fprintf(stderr,
+                "Not enough memory for the distinguished point table\n");
+        if (cfg.Store != NULL)
+            dp_store_close(&store);
+        return 1;
+    }
+    if (Opt->Resume) {
+        loaded = cycle_checkpoint_load(&cs);
+        if (loaded == CHECKPOINT_CORRUPT || loaded == CHECKPOINT_MISMATCH) {
+            fprintf(stderr,
+                    "Cannot resume from %s: %s\n",
+                    cfg.Checkpoint,
+                    loaded == CHECKPOINT_CORRUPT
+                      ? "the file is damaged or cut short"
+                      : "it was saved for another key, cipher or search");
+            cycle_search_free(&cs);
+            if (cfg.Store != NULL)
+                dp_store_close(&store);
+            return 1;
+        }
+    }
+    if (Opt->Verbose != 0)
+        printf("Walking %" PRIu64 " orbits on %u threads, distinguished "
+               "points with %u leading zero bits\n",
+               cfg.Orbits,
+               cs.Config.Threads,
+               cfg.DpBits);
+    if (Opt->Verbose != 0 && loaded == CHECKPOINT_RESUMED)
+        printf("Resumed from %s: %" PRIu64 " orbits started, %" PRIu64
+               " steps done\n",
+               cfg.Checkpoint,
+               cs.NextOrbit,
+               cs.Steps);
+    if (Opt->Verbose != 0 && stored == STORE_OPENED)
+        printf("%" PRIu64 " cycles known from %s\n", store.Cycles, Opt->Store);
+
+    cycle_search_run(&cs);
+    cycles = cycle_census(&cs, &count);
+
+    for (i = 0; i < count; i++) {
+        printf("%s length %" PRIu64 " representative %016" PRIx64
+               " starts %" PRIu64 "\n",
+               cycles[i].Complete ? "Cycle" : "Open",
+               cycles[i].Length,
+               cycles[i].Representative,
+               cycles[i].Starts);
+    }
+    if (cs.TableFull)
+        printf("Distinguished point table full, open orbits were cut short "
+               "(raise --table-bits or --dp-bits)\n");
+    if (Opt->Verbose != 0)
+        printf("%" PRIu64 " cycles, %" PRIu64 " steps, %" PRIu64
+               " distinguished points\n",
+               count,
+               cs.Steps,
+               cs.Points);
+    if (cs.CheckpointErrors != 0)
+        fprintf(stderr,
+                "%u checkpoints could not be written to %s\n",
+                cs.CheckpointErrors,
+                cfg.Checkpoint);
+
+    if (cfg.Store != NULL) {
+        if (dp_store_add(&store, &cs, &added) != 0)
+            fprintf(
+              stderr, "The cycles could not be added to %s\n", Opt->Store);
+        else if (Opt->Verbose != 0)
+            printf("%" PRIu64 " cycles added to %s\n", added, Opt->Store);
+        dp_store_close(&store);
+    }
+
+    free(cycles);
+    cycle_search_free(&cs);
+    return 0;
+}
+
+// Walks the same orbits as cycle_explore(), 64 at a time on every thread, and
+// prints each with its exact cycle length, or as open after --max-steps.
+static int
+bitslice_explore(const struct Options* Opt, const struct BsWalkKey* bk)
+{
+    struct BsCycleConfig cfg;
+    struct BsCycleSearch bs;
+    uint64_t             closed = 0, steps = 0, i;
+
+    cfg.Key           = bk;
+    cfg.Keys          = 1;
+    cfg.FirstStart    = Opt->Text;
+    cfg.Orbits        = Opt->Orbits;
+    cfg.MaxSteps      = Opt->MaxSteps;
+    cfg.Threads       = Opt->Threads;
+    cfg.ProgressEvery = Opt->ProgressEvery;
+
+    if (bscycle_init(&bs, &cfg) != 0) {
+        fprintf(stderr, "Not enough memory for the orbit results\n");
+        return 1;
+    }
+    if (Opt->Verbose != 0)
+        printf("Walking %" PRIu64 " orbits on %u threads, %d per thread at "
+               "once\n",
+               cfg.Orbits,
+               bs.Config.Threads,
+               BS_LANES);
+
+    bscycle_run(&bs);
+
+    for (i = 0; i < cfg.Orbits; i++) {
+        if (bs.Orbit[i].Closed)
+            printf("Orbit %016" PRIx64 " cycle length %" PRIu64 "\n",
+                   cfg.FirstStart + i,
+                   bs.Orbit[i].Steps);
+        else
+            printf("Orbit %016" PRIx64 " open after %" PRIu64 " steps\n",
+                   cfg.FirstStart + i,
+                   bs.Orbit[i].Steps);
+        closed += bs.Orbit[i].Closed;
+        steps += bs.Orbit[i].Steps;
+    }
+    if (Opt->Verbose != 0)
+        printf("%" PRIu64 " orbits closed, %" PRIu64 " open, %" PRIu64
+               " steps\n",
+               closed,
+               cfg.Orbits - closed,
+               steps);
+
+    bscycle_free(&bs);
+    return 0;
+}
+
+//----------------------------------
+// Bidirectional walk
+//----------------------------------
+// The cycle through text, walked forward and backward at once until the walks
+// meet, on two threads.
+static int
+bidir_explore(const struct Options* Opt, const uint64_t* subkey)
+{
+    struct BidirCipher bc;
+    struct BidirConfig cfg;
+    struct BidirResult result;
+
+    bidir_cipher(&bc, subkey, Opt->Rounds, Opt->Mode == Decrypt_Mode);
+    cfg.Forward       = bidir_forward;
+    cfg.Backward      = bidir_backward;
+    cfg.Cipher        = &bc;
+    cfg.Start         = Opt->Text;
+    cfg.MaxSteps      = Opt->MaxSteps;
+    cfg.DpBits        = Opt->DpBits;
+    cfg.TableBits     = Opt->TableBits;
+    cfg.ProgressEvery = Opt->ProgressEvery;
+
+    if (bidir_walk(&cfg, &result) != 0) {
+        fprintf(stderr, "Not enough memory for the distinguished points\n");
+        return 1;
+    }
+    if (result.State == BIDIR_OPEN) {
+        printf("Orbit %016" PRIx64 " open after %" PRIu64 " steps forward "
+               "and %" PRIu64 " backward\n",
+               cfg.Start,
+               result.Forward,
+               result.Backward);
+        if (result.TableFull)
+            fprintf(stderr,
+                    "The distinguished point tables filled up, raise "
+                    "--dp-bits or --table-bits\n");
+        return 0;
+    }
+    printf("Cycle length %" PRIu64 "\n", result.Length);
+    if (Opt->Verbose != 0) {
+        if (result.State == BIDIR_MET)
+            printf("The walks met at %016" PRIx64 " after %" PRIu64
+                   " steps forward and %" PRIu64 " backward\n",
+                   result.Meet,
+                   result.Forward,
+                   result.Backward);
+        else
+            printf("One walk closed the cycle alone, after %" PRIu64
+                   " steps forward and %" PRIu64 " backward\n",
+                   result.Forward,
+                   result.Backward);
+    }
+    return 0;
+}
+
+//----------------------------------
+// GIFT-128
+//----------------------------------
+// Walks the orbits of text, text + 1, ... of the 128-bit permutation,
+// CYCLE128_LANES at a time on every thread, and prints each with its exact
+// cycle length, or as open after --max-steps.
+static int
+cycle128_explore(const struct Options* Opt, const uint64_t* subkey)
+{
+    struct Cycle128Key    key;
+    struct Cycle128Config cfg;
+    struct Cycle128Search cs;
+    struct Block128       start;
+    uint64_t              closed = 0, steps = 0, i;
+
+    cycle128_key(&key, subkey, Opt->Rounds, Opt->Mode == Decrypt_Mode);
+    cfg.Key             = &key;
+    cfg.FirstStart.High = Opt->TextHigh;
+    cfg.FirstStart.Low  = Opt->Text;
+    cfg.Orbits          = Opt->Orbits;
+    cfg.MaxSteps        = Opt->MaxSteps;
+    cfg.Threads         = Opt->Threads;
+    cfg.ProgressEvery   = Opt->ProgressEvery;
+
+    if (cycle128_init(&cs, &cfg) != 0) {
+        fprintf(stderr, "Not enough memory for the orbit results\n");
+        return 1;
+    }
+    if (Opt->Verbose != 0)
+        printf("Walking %" PRIu64 " orbits of GIFT-128 (%u rounds) on %u "
+               "threads, %d per thread at once\n",
+               cfg.Orbits,
+               key.Rounds,
+               cs.Config.Threads,
+               CYCLE128_LANES);
+
+    cycle128_run(&cs);
+
+    for (i = 0; i < cfg.Orbits; i++) {
+        start.Low  = cfg.FirstStart.Low + i;
+        start.High = cfg.FirstStart.High + (start.Low < cfg.FirstStart.Low);
+        if (cs.Orbit[i].Closed)
+            printf("Orbit %016" PRIx64 " %016" PRIx64 " cycle length %" PRIu64
+                   "\n",
+                   start.High,
+                   start.Low,
+                   cs.Orbit[i].Steps);
+        else
+            printf("Orbit %016" PRIx64 " %016" PRIx64 " open after %" PRIu64
+                   " steps\n",
+                   start.High,
+                   start.Low,
+                   cs.Orbit[i].Steps);
+        closed += cs.Orbit[i].Closed;
+        steps += cs.Orbit[i].Steps;
+    }
+    if (Opt->Verbose != 0)
+        printf("%" PRIu64 " orbits closed, %" PRIu64 " open, %" PRIu64
+               " steps\n",
+               closed,
+               cfg.Orbits - closed,
+               steps);
+
+    cycle128_free(&cs);
+    return 0;
+}
+
+//----------------------------------
+// Round sweep
+//----------------------------------
+// The orbits of bitslice_explore() under every round count of --sweep-rounds,
+// from one key schedule, in one search. Prints a table with one row per round
+// count: how many orbits closed, the shortest and longest cycle among them and
+// the steps walked.
+static int
+sweep_explore(const struct Options* Opt, const uint64_t* subkey)
+{
+    struct BsWalkKey*    bk;
+    struct BsCycleConfig cfg;
+    struct BsCycleSearch bs;
+    struct BsSummary     sum;
+    uint16_t             rounds[MAX_ROUNDS];
+    unsigned             keys = 0, k;
+
+    for (k = 1; k <= MAX_ROUNDS; k++) {
+        if (Opt->SweepRounds >> (k - 1) & 1)
+            rounds[keys++] = k;
+    }
+    bk = malloc(keys * sizeof(struct BsWalkKey));
+    if (bk == NULL) {
+        fprintf(stderr, "Not enough memory for the walk keys\n");
+        return 1;
+    }
+    for (k = 0; k < keys; k++) {
+        bs_walk_key(&bk[k], subkey, rounds[k], Opt->Mode == Decrypt_Mode);
+    }
+
+    cfg.Key           = bk;
+    cfg.Keys          = keys;
+    cfg.FirstStart    = Opt->Text;
+    cfg.Orbits        = Opt->Orbits;
+    cfg.MaxSteps      = Opt->MaxSteps;
+    cfg.Threads       = Opt->Threads;
+    cfg.ProgressEvery = Opt->ProgressEvery;
+
+    if (bscycle_init(&bs, &cfg) != 0) {
+        fprintf(stderr, "Not enough memory for the orbit results\n");
+        free(bk);
+        return 1;
+    }
+    if (Opt->Verbose != 0)
+        printf("Walking %" PRIu64 " orbits under each of %u round counts on "
+               "%u threads\n",
+               cfg.Orbits,
+               keys,
+               bs.Config.Threads);
+
+    bscycle_run(&bs);
+
+    printf("%6s %10s %10s %20s %20s %20s\n",
+           "rounds",
+           "closed",
+           "open",
+           "shortest",
+           "longest",
+           "steps");
+    for (k = 0; k < keys; k++) {
+        bscycle_summary(&bs, k, &sum);
+        if (sum.Closed == 0)
+            printf("%6u %10" PRIu64 " %10" PRIu64 " %20s %20s %20" PRIu64 "\n",
+                   rounds[k],
+                   sum.Closed,
+                   cfg.Orbits,
+                   "-",
+                   "-",
+                   sum.Steps);
+        else
+            printf("%6u %10" PRIu64 " %10" PRIu64 " %20" PRIu64 " %20" PRIu64
+                   " %20" PRIu64 "\n",
+                   rounds[k],
+                   sum.Closed,
+                   cfg.Orbits - sum.Closed,
+                   sum.Shortest,
+                   sum.Longest,
+                   sum.Steps);
+    }
+
+    bscycle_free(&bs);
+    free(bk);
+    return 0;
+}
+
+//----------------------------------
+// Key-sliced walks
+//----------------------------------
+// The cycle through text under --keys keys, the key given and the ones after
+// it (counting up in the low word), 64 of them at a time in the lanes of the
+// key-sliced cipher. Prints every key with its cycle length, or as open after
+// --max-steps.
+static int
+keys_explore(const struct Options* Opt)
+{
+    struct KeySlice ks;
+    struct Progress progress;
+    uint64_t        high[BS_LANES], low[BS_LANES], length[BS_LANES];
+    uint64_t        s[BS_LANES], start[BS_LANES];
+    uint64_t        first, open, back, diff, steps, total = 0;
+    uint64_t        closed = 0, done = 0;
+    double          nextReport;
+    unsigned        n, i;
+
+    if (Opt->Verbose != 0)
+        printf("Walking the text under %" PRIu64 " keys, %d at once\n",
+               Opt->Keys,
+               BS_LANES);
+
+    progress_start(&progress, 0, 0);
+    nextReport = progress.Start + Opt->ProgressEvery;
+    for (first = 0; first < Opt->Keys; first += n) {
+        n = Opt->Keys - first < BS_LANES ? Opt->Keys - first : BS_LANES;
+        for (i = 0; i < n; i++) {
+            low[i]  = Opt->KeyLow + first + i;
+            high[i] = Opt->KeyHigh + (low[i] < Opt->KeyLow);
+        }
+        keyslice_init(&ks, high, low, n, Opt->Rounds);
+
+        // Every lane starts at the text, the lanes past n are never looked at
+        for (i = 0; i < BS_LANES; i++) {
+            s[i] = Opt->Text;
+        }
+        bs_transpose(s);
+        memcpy(start, s, sizeof(s));
+
+        open  = n == BS_LANES ? UINT64_MAX : ((uint64_t)1 << n) - 1;
+        steps = 0;
+        while (open != 0 && (Opt->MaxSteps == 0 || steps < Opt->MaxSteps)) {
+            if (Opt->Mode == Encrypt_Mode)
+                bs_encrypt_keysliced(s, &ks);
+            else
+                bs_decrypt_keysliced(s, &ks);
+            steps++;
+
+            // A lane is back where every slice agrees with the start
+            diff = 0;
+            for (i = 0; i < BS_LANES; i++) {
+                diff |= s[i] ^ start[i];
+            }
+            for (back = open & ~diff; back != 0; back &= back - 1) {
+                length[__builtin_ctzll(back)] = steps;
+            }
+            open &= diff;
+
+            if (Opt->ProgressEvery != 0 && (steps & 0xFFF) == 0 &&
+                progress_now() >= nextReport) {
+                progress_report(&progress,
+                                total + steps * n,
+                                0,
+                                done,
+                                Opt->Keys,
+                                bs_lane_get(s, __builtin_ctzll(open)));
+                nextReport = progress_now() + Opt->ProgressEvery;
+            }
+        }
+
+        for (i = 0; i < n; i++) {
+            if (open >> i & 1)
+                printf("Key %016" PRIx64 "%016" PRIx64 " open after %" PRIu64
+                       " steps\n",
+                       high[i],
+                       low[i],
+                       steps);
+            else
+                printf("Key %016" PRIx64 "%016" PRIx64 " cycle length %" PRIu64
+                       "\n",
+                       high[i],
+                       low[i],
+                       length[i]);
+        }
+        closed += n - __builtin_popcountll(open);
+        total += steps * n;
+        done += n;
+    }
+    if (Opt->Verbose != 0)
+        printf("%" PRIu64 " keys closed, %" PRIu64 " open\n",
+               closed,
+               Opt->Keys - closed);
+    return 0;
+}
+
+//----------------------------------
+// Short-cycle hunt
+//----------------------------------
+// Every text that agrees with -t outside the bits of --subspace and lies on a
+// cycle of at most --hunt steps, with its cycle length.
+static int
+hunt_explore(const struct Options* Opt, const struct BsWalkKey* bk)
+{
+    struct HuntConfig cfg;
+    struct HuntResult result;
+    uint64_t          i;
+
+    cfg.Key           = bk;
+    cfg.Base          = Opt->Text;
+    cfg.Free          = Opt->Subspace;
+    cfg.MaxLength     = Opt->Hunt;
+    cfg.Threads       = Opt->Threads;
+    cfg.ProgressEvery = Opt->ProgressEvery;
+
+    if (Opt->Verbose != 0)
+        printf("Hunting cycles of up to %" PRIu64 " steps through 2^%d texts "
+               "of %016" PRIx64 " with bits %016" PRIx64 " free\n",
+               cfg.MaxLength,
+               __builtin_popcountll(cfg.Free),
+               cfg.Base & ~cfg.Free,
+               cfg.Free);
+
+    if (hunt(&cfg, &result) != 0) {
+        fprintf(stderr, "Not enough memory for the hunt\n");
+        return 1;
+    }
+
+    for (i = 0; i < result.Hits; i++) {
+        printf("Hit %016" PRIx64 " cycle length %" PRIu64 "\n",
+               result.Hit[i].X,
+               result.Hit[i].Length);
+    }
+    if (Opt->Verbose != 0)
+        printf("%" PRIu64 " hits in %" PRIu64 " texts on %u threads\n",
+               result.Hits,
+               result.Candidates,
+               result.Threads);
+
+    hunt_free(&result);
+    return 0;
+}
+
+//----------------------------------
+// Exact decomposition
+//----------------------------------
+// Every cycle of GIFT cut down to --width bits, as a histogram of the cycle
+// lengths. The text plays no part.
+static int
+decompose_explore(const struct Options* Opt, const uint64_t* subkey)
+{
+    struct SmallGift*      sg;
+    struct DecomposeConfig cfg;
+    struct Decomposition   result;
+    uint64_t               i;
+
+    if (Opt->Width % 16 != 0 || Opt->Width > DECOMPOSE_MAX_WIDTH) {
+        fprintf(stderr,
+                "Cannot decompose at width %u: the GIFT bit permutation "
+                "needs a multiple of 16 bits, and the bitmap at most %d\n",
+                Opt->Width,
+                DECOMPOSE_MAX_WIDTH);
+        return 1;
+    }
+    sg = malloc(sizeof(struct SmallGift));
+    if (sg == NULL) {
+        fprintf(stderr, "Not enough memory for the cipher tables\n");
+        return 1;
+    }
+    small_gift_init(
+      sg, Opt->Width, subkey, Opt->Rounds, Opt->Mode == Decrypt_Mode);
+    cfg.Cipher        = sg;
+    cfg.Threads       = Opt->Threads;
+    cfg.ProgressEvery = Opt->ProgressEvery;
+
+    if (decompose(&cfg, &result) != 0) {
+        fprintf(stderr, "Not enough memory for the visited bitmap\n");
+        free(sg);
+        return 1;
+    }
+    if (Opt->Verbose != 0)
+        printf("Decomposed the %u-bit permutation on %u threads\n",
+               Opt->Width,
+               result.Threads);
+    for (i = 0; i < result.Lengths; i++) {
+        printf("Cycle length %" PRIu64 " count %" PRIu64 "\n",
+               result.Histogram[i].Length,
+               result.Histogram[i].Count);
+    }
+    if (Opt->Verbose != 0)
+        printf("%" PRIu64 " cycles of %" PRIu64 " distinct lengths\n",
+               result.Cycles,
+               result.Lengths);
+
+    decomposition_free(&result);
+    free(sg);
+    return 0;
+}
+
+//----------------------------------
+// Benchmark
+//----------------------------------
+// The round functions of crypto.c a bench step can go through
+typedef uint64_t (*RoundCipher)(uint64_t, uint64_t*, uint16_t, _Bool);
+
+// Steps per second of one thread walking from text, one block per call as the
+// plain cycle loop did before, through the bit loops and the tables of
+// crypto.c, through the walk kernel with one and with WALK_LANES orbits, and
+// bitsliced with BS_LANES orbits. Each is timed for about a second.
+static void
+walk_bench(const struct Options*   Opt,
+           uint64_t*               subkey,
+           struct UnrolledKey*     uk,
+           const struct WalkKey*   wk,
+           const struct BsWalkKey* bk)
+{
+    UnrolledCipher cipher = Opt->Mode == Encrypt_Mode
+                              ? unrolled_encrypt_for(Opt->Rounds)
+                              : unrolled_decrypt_for(Opt->Rounds);
+    WalkKernel     kernel = Opt->Mode == Encrypt_Mode
+                              ? walk_encrypt_for(Opt->Rounds)
+                              : walk_decrypt_for(Opt->Rounds);
+    uint64_t       lanes[WALK_LANES], stop[WALK_LANES] = { 0 };
+    uint64_t       s[BS_LANES] = { 0 }, home[BS_LANES] = { 0 }, back;
+    uint64_t       x, steps, i;
+    clock_t        start, ticks;
+    int            used, l;
+
+    x     = Opt->Text;
+    steps = 0;
+    start = clock();
+    do {
+        for (i = 0; i < (1 << 16); i++) {
+            x = cipher(x, uk);
+        }
+        steps += i;
+        ticks = clock() - start;
+    } while (ticks < CLOCKS_PER_SEC);
+    printf("bench per-call orbits 1 steps/s %.0f\n",
+           (double)steps * CLOCKS_PER_SEC / ticks);
+
+    // The bit loops are slow, so they are timed in smaller chunks
+    table_init();
+    for (l = 0; l < 2; l++) {
+        RoundCipher round =
+          Opt->Mode == Encrypt_Mode ? (l ? encrypt_table : encrypt)
+                                    : (l ? decrypt_table : decrypt);
+
+        x     = Opt->Text;
+        steps = 0;
+        start = clock();
+        do {
+            for (i = 0; i < (1 << 10); i++) {
+                x = round(x, subkey, Opt->Rounds, 0);
+            }
+            steps += i;
+            ticks = clock() - start;
+        } while (ticks < CLOCKS_PER_SEC);
+        printf("bench %s orbits 1 steps/s %.0f\n",
+               l ? "table" : "bit-serial",
+               (double)steps * CLOCKS_PER_SEC / ticks);
+    }
+
+    // A full mask only stops at 0, a value no walk here is likely to meet
+    for (used = 1; used <= WALK_LANES; used += WALK_LANES - 1) {
+        for (l = 0; l < WALK_LANES; l++) {
+            lanes[l] = Opt->Text + (l < used ? l : 0);
+        }
+        steps = 0;
+        start = clock();
+        do {
+            steps += kernel(lanes, stop, 1 << 16, UINT64_MAX, wk);
+            ticks = clock() - start;
+        } while (ticks < CLOCKS_PER_SEC);
+        printf("bench kernel orbits %d steps/s %.0f\n",
+               used,
+               (double)steps * used * CLOCKS_PER_SEC / ticks);
+    }
+
+    // No lane is watched, so only the step count ends a walk
+    for (l = 0; l < BS_LANES; l++) {
+        bs_lane_set(s, l, Opt->Text + l);
+        bs_lane_set(home, l, Opt->Text + l);
+    }
+    steps = 0;
+    start = clock();
+    do {
+        steps += bs_walk(s, home, 1 << 12, 0, bk, &back);
+        ticks = clock() - start;
+    } while (ticks < CLOCKS_PER_SEC);
+    printf("bench bitslice orbits %d steps/s %.0f\n",
+           BS_LANES,
+           (double)steps * BS_LANES * CLOCKS_PER_SEC / ticks);
+}
 
 //----------------------------------
 // Start of code
@@ -36,9 +745,9 @@ int
 main(int argc, char** const argv)
 {
     // Initialize variables
-    uint64_t       result;
-    uint64_t*      result128 = NULL;
-    struct Options Opt;
+    uint64_t        result;
+    struct Block128 result128;
+    struct Options  Opt;
 
     // Get Commandline Options
     comline_fetch_options(&Opt, argc, argv);
@@ -54,7 +763,47 @@ main(int argc, char** const argv)
     }
 
     if (!Opt.Error) {
-        uint64_t* subkey = NULL;
+        struct KeySchedule ks;
+        struct UnrolledKey uk;
+        struct Block128Key key128;
+        struct WalkKey     wk;
+        struct BsWalkKey   bk;
+        if (Opt.BlockSize64 && Opt.Width != 0) {
+            key_schedule_init(
+              &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+            return decompose_explore(&Opt, ks.Subkey);
+        }
+        if (Opt.BlockSize64 && Opt.SweepRounds != 0) {
+            key_schedule_init(
+              &ks, Opt.KeyHigh, Opt.KeyLow, MAX_ROUNDS, Opt.KeySize80);
+            return sweep_explore(&Opt, ks.Subkey);
+        }
+        if (Opt.BlockSize64 && Opt.Keys != 0)
+            return keys_explore(&Opt);
+        if (Opt.BlockSize64 && Opt.Bidirectional) {
+            key_schedule_init(
+              &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+            return bidir_explore(&Opt, ks.Subkey);
+        }
+        if (Opt.BlockSize64 &&
+            (Opt.Orbits != 0 || Opt.Hunt != 0 || Opt.Bench)) {
+            key_schedule_init(
+              &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+            unrolled_key(&uk, ks.Subkey, Opt.Rounds);
+            walk_key(&wk, ks.Subkey, Opt.Rounds);
+            bs_walk_key(
+              &bk, ks.Subkey, Opt.Rounds, Opt.Mode == Decrypt_Mode);
+            if (Opt.Bench) {
+                walk_bench(&Opt, ks.Subkey, &uk, &wk, &bk);
+                return 0;
+            }
+            if (Opt.Bitslice)
+                return bitslice_explore(&Opt, &bk);
+            if (Opt.Hunt != 0)
+                return hunt_explore(&Opt, &bk);
+            return cycle_explore(&Opt, &uk, &wk);
+        }
+
         if (Opt.BlockSize64) {
 
             if (Opt.Mode == Encrypt_Mode) {
@@ -75,34 +824,40 @@ main(int argc, char** const argv)
                 }
 
                 // Generate Subkeys
-                subkey = key_schedule(Opt.KeyHigh,
-                                      Opt.KeyLow,
-                                      Opt.Rounds,
-                                      Opt.KeySize80,
-                                      (Opt.Verbose > 1));
+                key_schedule_init(
+                  &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+
+                unrolled_key(&uk, ks.Subkey, Opt.Rounds);
+
+                // Kernel specialized for the round count
+                UnrolledCipher cipher = unrolled_encrypt_for(Opt.Rounds);
 
                 // Start Encryption
                 if (Opt.Verbose != 0)
                     printf("Starting encryption...\n");
-                result =
-                  encrypt(Opt.Text, subkey, Opt.Rounds, (Opt.Verbose > 1));
-
-                long     counter   = 1;
-                int      found     = 0;
-                uint64_t cycleComp = result;
-                uint64_t newCycle  = result;
-                while (found == 0) {
+                result = cipher(Opt.Text, &uk);
+
+                // A single orbit would leave all lanes of the walk kernel but
+                // one idle, so it goes through the table cipher. Progress is
+                // only looked at every 2^20 steps.
+                struct Progress progress;
+                double          nextReport;
+                uint64_t        counter  = 0;
+                uint64_t        newCycle = result;
+                table_init();
+                progress_start(&progress, 0, 0);
+                nextReport = progress.Start + Opt.ProgressEvery;
+                do {
                     newCycle =
-                      encrypt(newCycle, subkey, Opt.Rounds, (Opt.Verbose > 1));
-                    if (newCycle == cycleComp) {
-                        printf("Cycle length %ld\n", counter);
-                        found = 1;
-                    }
-                    if (counter % 5000000 == 0) {
-                        printf("Index at: %ld\n", counter);
-                    }
+                      encrypt_table(newCycle, ks.Subkey, Opt.Rounds, 0);
                     counter++;
-                }
+                    if ((counter & 0xFFFFF) == 0 && Opt.ProgressEvery != 0 &&
+                        progress_now() >= nextReport) {
+                        progress_report(&progress, counter, 0, 0, 1, newCycle);
+                        nextReport = progress_now() + Opt.ProgressEvery;
+                    }
+                } while (newCycle != result);
+                printf("Cycle length %" PRIu64 "\n", counter);
                 return 0;
 
                 if (Opt.Verbose != 0)
@@ -129,30 +884,29 @@ main(int argc, char** const argv)
                 }
 
                 // Generate Subkeys
-                subkey = key_schedule(Opt.KeyHigh,
-                                      Opt.KeyLow,
-                                      Opt.Rounds,
-                                      Opt.KeySize80,
-                                      (Opt.Verbose > 1));
+                key_schedule_init(
+                  &ks, Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, Opt.KeySize80);
+
+                unrolled_key(&uk, ks.Subkey, Opt.Rounds);
 
                 // Start Decryption
                 if (Opt.Verbose != 0)
                     printf("Starting decryption...\n");
-                result =
-                  decrypt(Opt.Text, subkey, Opt.Rounds, (Opt.Verbose > 1));
+                result = unrolled_decrypt_for(Opt.Rounds)(Opt.Text, &uk);
                 if (Opt.Verbose != 0)
                     printf("Resulting Plaintext: %016" PRIx64 " \n", result);
                 else
                     printf("%016" PRIx64 "\n", result);
             }
-
-            free(subkey);
         }
 
         else {
 
-            subkey = key_schedule128(
-              Opt.KeyHigh, Opt.KeyLow, Opt.Rounds, (Opt.Verbose > 1));
+            // encrypt128() always runs 40 rounds, expand them all
+            key_schedule128_init(&ks, Opt.KeyHigh, Opt.KeyLow, MAX_ROUNDS);
+            if (Opt.Orbits != 0)
+                return cycle128_explore(&Opt, ks.Subkey);
+            block128_key(&key128, ks.Subkey, Opt.Rounds);
 
             // printf("128-bit option reached\n");
 
@@ -178,20 +932,18 @@ main(int argc, char** const argv)
 
                 if (Opt.Verbose != 0)
                     printf("Starting encryption...\n");
-                result128 = encrypt128(Opt.TextHigh,
-                                       Opt.Text,
-                                       subkey,
-                                       Opt.Rounds,
-                                       (Opt.Verbose > 1));
+                result128.High = Opt.TextHigh;
+                result128.Low  = Opt.Text;
+                encrypt128_block(&result128, &key128);
                 if (Opt.Verbose != 0)
                     printf("Resulting Cipher: %016" PRIx64 " %016" PRIx64
                            " \n\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
                 else
                     printf("%016" PRIx64 " %016" PRIx64 "\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
             } else if (Opt.Mode == Decrypt_Mode) {
 
                 if (Opt.Verbose != 0) {
@@ -213,24 +965,19 @@ main(int argc, char** const argv)
 
                 if (Opt.Verbose != 0)
                     printf("Starting decryption...\n");
-                result128 = decrypt128(Opt.TextHigh,
-                                       Opt.Text,
-                                       subkey,
-                                       Opt.Rounds,
-                                       (Opt.Verbose > 1));
+                result128.High = Opt.TextHigh;
+                result128.Low  = Opt.Text;
+                decrypt128_block(&result128, &key128);
                 if (Opt.Verbose != 0)
                     printf("Resulting Plaintext: %016" PRIx64 " %016" PRIx64
                            " \n\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
                 else
                     printf("%016" PRIx64 " %016" PRIx64 "\n",
-                           result128[1],
-                           result128[0]);
+                           result128.High,
+                           result128.Low);
             }
-
-            free(subkey);
-            free(result128);
         }
 
     }
@@ -250,6 +997,59 @@ main(int argc, char** const argv)
         printf("-k key: Key in hexadecimal (length: *EXACTLY* 20 "
                "chars(80bit)/32 chars(128bit))\n");
         printf("-t text: Text in hexadecimal (length: *EXACTLY* 16 chars)\n");
+        printf("--orbits n (optional): Walk the orbits of text, text + 1, ... "
+               "(n of them)\n");
+        printf("   in parallel and print every cycle they lie on; with a "
+               "128-bit text print\n");
+        printf("   every orbit with its cycle length, or as open after "
+               "--max-steps\n");
+        printf("--threads n (optional): Threads to walk on (standard is one "
+               "per core)\n");
+        printf("--dp-bits k (optional): Leading zero bits of distinguished "
+               "points (standard 24)\n");
+        printf("--table-bits b (optional): Room for 2^b distinguished points "
+               "(standard 20)\n");
+        printf("--max-steps n (optional): Stop every orbit after n steps\n");
+        printf("--bitslice (optional): Walk 64 orbits per thread at once and "
+               "print the exact\n");
+        printf("   cycle length of each (standard --orbits 64, no "
+               "checkpoints)\n");
+        printf("--width w (optional): Print the cycle length histogram of GIFT "
+               "cut down to\n");
+        printf("   w bits (16 or 32), the text is not used\n");
+        printf("--sweep-rounds list (optional): Walk the --bitslice orbits "
+               "for every round count\n");
+        printf("   in list, such as 1-8,12,16, and print a table by round "
+               "count (-r is not used)\n");
+        printf("--bidirectional (optional): Walk the cycle of text forward "
+               "and backward at once\n");
+        printf("   on two threads, until they meet at a distinguished point\n");
+        printf("--hunt k (optional): Print every text of the --subspace of "
+               "text on a cycle of\n");
+        printf("   at most k steps, fixed points included, with its cycle "
+               "length\n");
+        printf("--subspace mask (optional): Bits of text the --hunt tries "
+               "all values of, in\n");
+        printf("   hexadecimal as 0x..., 1 to 63 of them (standard "
+               "0xffffffff)\n");
+        printf("--keys n (optional): Walk the cycle of text under n keys, the "
+               "key given and the\n");
+        printf("   next ones in the low word, 64 at once, and print the "
+               "cycle length of each\n");
+        printf("--bench (optional): Print the steps per second of one thread "
+               "and quit\n");
+        printf("--progress s (optional): Seconds between progress lines on "
+               "stderr (standard 60,\n");
+        printf("   0 for none)\n");
+        printf("--checkpoint file (optional): Save the cycle search to file "
+               "(implies --orbits 1)\n");
+        printf("--checkpoint-every s (optional): Seconds between checkpoints "
+               "(standard 600)\n");
+        printf("--resume (optional): Go on from the checkpoint file if there "
+               "is one\n");
+        printf("--store file (optional): Stop orbits on cycles kept in file "
+               "by earlier runs, and\n");
+        printf("   add the cycles this run completes (implies --orbits 1)\n");
         printf("If -f is set, key and text represent files containing the "
                "values,\n");
         printf("otherwise they must be passed directly via commandline.\n\n");
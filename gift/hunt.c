@@ -0,0 +1,277 @@
+/**
+ * Fixed points and short cycles of GIFT-64 in a subspace of plaintexts
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hunt.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CHUNK_BATCHES 1024 // batches of BS_LANES candidates a thread takes
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct Hunter;
+
+struct HuntWorker
+{
+    struct Hunter*  Shared;
+    struct HuntHit* Hit;
+    uint64_t        Hits;
+    uint64_t        HitSize;
+    uint64_t        Steps; // for progress reports
+    uint64_t        Found; // Hits, for progress reports
+    _Bool           NoMemory;
+};
+
+struct Hunter
+{
+    struct HuntConfig  Config;
+    uint64_t           Fixed;         // Base outside of Free
+    uint64_t           High;          // Free without the bits of Low
+    uint64_t           Low[BS_LANES]; // lane i of a batch, within Free
+    uint64_t           Lanes;         // the lanes that hold candidates
+    uint64_t           Batches;
+    uint64_t           NextChunk;
+    uint64_t           Chunks;
+    struct HuntWorker* Worker;
+    struct WorkerPool  Pool;
+    struct Progress    Progress;
+};
+
+//----------------------------------
+// Scanning
+//----------------------------------
+// The low bits of n into the set bits of mask, lowest first
+static uint64_t
+deposit(uint64_t n, uint64_t mask)
+{
+    uint64_t x = 0, bit;
+
+    for (; mask != 0 && n != 0; mask &= mask - 1, n >>= 1) {
+        bit = mask & -mask;
+        if (n & 1)
+            x |= bit;
+    }
+    return x;
+}
+
+static int
+push_hit(struct HuntWorker* w, uint64_t x, uint64_t length)
+{
+    struct HuntHit* grown;
+
+    if (w->Hits == w->HitSize) {
+        w->HitSize = w->HitSize ? 2 * w->HitSize : 64;
+        grown      = realloc(w->Hit, w->HitSize * sizeof(struct HuntHit));
+        if (grown == NULL)
+            return -1;
+        w->Hit = grown;
+    }
+    w->Hit[w->Hits].X      = x;
+    w->Hit[w->Hits].Length = length;
+    w->Hits++;
+    return 0;
+}
+
+// One batch: the lanes that come back within MaxLength steps are hits, and
+// stop being looked at
+static void
+hunt_batch(struct HuntWorker* w, uint64_t batch)
+{
+    const struct Hunter* h = w->Shared;
+    uint64_t             x[BS_LANES], s[BS_LANES];
+    uint64_t             high, mask = h->Lanes, back, done = 0;
+    unsigned             l;
+
+    high = h->Fixed | deposit(batch, h->High);
+    for (l = 0; l < BS_LANES; l++) {
+        x[l] = high | h->Low[l];
+    }
+    memcpy(s, x, sizeof(s));
+    bs_transpose(s);
+    memcpy(x, s, sizeof(s)); // the sliced starts
+
+    while (done < h->Config.MaxLength && mask != 0) {
+        done += bs_walk(
+          s, x, h->Config.MaxLength - done, mask, h->Config.Key, &back);
+        for (mask &= ~back; back != 0; back &= back - 1) {
+            l = __builtin_ctzll(back);
+            if (push_hit(w, high | h->Low[l], done) != 0)
+                w->NoMemory = 1;
+        }
+    }
+    __atomic_fetch_add(&w->Steps,
+                       done * (uint64_t)__builtin_popcountll(h->Lanes),
+                       __ATOMIC_RELAXED);
+    __atomic_store_n(&w->Found, w->Hits, __ATOMIC_RELAXED);
+}
+
+static void*
+worker(void* arg)
+{
+    struct HuntWorker* w = arg;
+    struct Hunter*     h = w->Shared;
+    uint64_t           chunk, batch, end;
+
+    for (;;) {
+        chunk = __atomic_fetch_add(&h->NextChunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= h->Chunks)
+            break;
+        batch = chunk * CHUNK_BATCHES;
+        end   = batch + CHUNK_BATCHES;
+        if (end > h->Batches)
+            end = h->Batches;
+        for (; batch < end; batch++) {
+            hunt_batch(w, batch);
+        }
+    }
+
+    pool_done(&h->Pool);
+    return NULL;
+}
+
+//----------------------------------
+// Search
+//----------------------------------
+static int
+compare_hits(const void* a, const void* b)
+{
+    uint64_t x = ((const struct HuntHit*)a)->X;
+    uint64_t y = ((const struct HuntHit*)b)->X;
+
+    return (x > y) - (x < y);
+}
+
+static void
+report_progress(void* arg)
+{
+    struct Hunter* h     = arg;
+    uint64_t       steps = 0, hits = 0, taken;
+    unsigned       i;
+
+    for (i = 0; i < h->Config.Threads; i++) {
+        steps += __atomic_load_n(&h->Worker[i].Steps, __ATOMIC_RELAXED);
+        hits += __atomic_load_n(&h->Worker[i].Found, __ATOMIC_RELAXED);
+    }
+    taken = __atomic_load_n(&h->NextChunk, __ATOMIC_RELAXED);
+    if (taken > h->Chunks)
+        taken = h->Chunks;
+    progress_report(&h->Progress, steps, hits, taken, h->Chunks, 0);
+}
+
+static void
+run(struct Hunter* h)
+{
+    unsigned i;
+
+    for (i = 0; i < h->Config.Threads; i++) {
+        h->Worker[i].Shared = h;
+    }
+    pool_run(&h->Pool,
+             worker,
+             h->Worker,
+             sizeof(struct HuntWorker),
+             h->Config.Threads,
+             h->Config.ProgressEvery,
+             report_progress,
+             h);
+}
+
+int
+hunt(const struct HuntConfig* config, struct HuntResult* result)
+{
+    struct Hunter* h;
+    uint64_t       low, i, limit = 0;
+    unsigned       bits = __builtin_popcountll(config->Free), t;
+    int            ret  = -1;
+
+    memset(result, 0, sizeof(*result));
+    if (bits == 0 || bits == 64 || config->MaxLength == 0)
+        return -1;
+
+    h = calloc(1, sizeof(struct Hunter));
+    if (h == NULL)
+        return -1;
+    h->Config = *config;
+    if (h->Config.Threads == 0) {
+        long cores        = sysconf(_SC_NPROCESSORS_ONLN);
+        h->Config.Threads = cores > 0 ? (unsigned)cores : 1;
+    }
+
+    // Up to six bits of Free go to the lanes, the rest number the batches
+    low = 0;
+    for (i = 0; i < 6 && i < bits; i++) {
+        low |= (config->Free & ~low) & -(config->Free & ~low);
+    }
+    h->Fixed   = config->Base & ~config->Free;
+    h->High    = config->Free & ~low;
+    h->Batches = (uint64_t)1 << (bits - i);
+    h->Lanes   = i == 6 ? UINT64_MAX : ((uint64_t)1 << (1 << i)) - 1;
+    for (t = 0; t < BS_LANES; t++) {
+        h->Low[t] = deposit(t, low);
+    }
+    h->Chunks = (h->Batches + CHUNK_BATCHES - 1) / CHUNK_BATCHES;
+
+    h->Worker = calloc(h->Config.Threads, sizeof(struct HuntWorker));
+    if (h->Worker == NULL) {
+        free(h);
+        return -1;
+    }
+    pool_init(&h->Pool);
+    if (((uint64_t)1 << bits) <= UINT64_MAX / config->MaxLength)
+        limit = ((uint64_t)1 << bits) * config->MaxLength;
+    progress_start(&h->Progress, 0, limit);
+
+    run(h);
+
+    // The hits of all workers, in one sorted array
+    for (t = 0; t < h->Config.Threads; t++) {
+        if (h->Worker[t].NoMemory)
+            goto done;
+        result->Hits += h->Worker[t].Hits;
+    }
+    result->Hit = malloc((result->Hits ? result->Hits : 1) *
+                         sizeof(struct HuntHit));
+    if (result->Hit == NULL)
+        goto done;
+    result->Hits = 0;
+    for (t = 0; t < h->Config.Threads; t++) {
+        if (h->Worker[t].Hits != 0)
+            memcpy(result->Hit + result->Hits,
+                   h->Worker[t].Hit,
+                   h->Worker[t].Hits * sizeof(struct HuntHit));
+        result->Hits += h->Worker[t].Hits;
+    }
+    qsort(result->Hit, result->Hits, sizeof(struct HuntHit), compare_hits);
+    result->Candidates = (uint64_t)1 << bits;
+    result->Threads    = h->Config.Threads;
+    ret                = 0;
+
+done:
+    if (ret != 0) {
+        hunt_free(result);
+        result->Hits = 0;
+    }
+    for (t = 0; t < h->Config.Threads; t++) {
+        free(h->Worker[t].Hit);
+    }
+    free(h->Worker);
+    pool_free(&h->Pool);
+    free(h);
+    return ret;
+}
+
+void
+hunt_free(struct HuntResult* result)
+{
+    free(result->Hit);
+    result->Hit = NULL;
+}
@@ -0,0 +1,63 @@
+/**
+ * Fixed points and short cycles of GIFT-64 in a subspace of plaintexts
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * hunt() tries every x of a subspace, the values that agree with Base outside
+ * the bits of Free, and reports those with E^k(x) = x for some k up to
+ * MaxLength, each with the smallest such k (its cycle length; 1 for a fixed
+ * point). All 2^32 plaintexts with a fixed half take 2^32 times MaxLength
+ * steps, so the candidates go through bs_walk() 64 at a time: a batch is
+ * transposed into a bitsliced state, walked MaxLength steps, and every lane
+ * that comes back to its start on the way is a hit.
+ *
+ * The candidates are numbered by the bits of Free they set, and the threads
+ * take chunks of consecutive numbers. The lowest six bits of Free vary
+ * within a batch and the others from batch to batch, so filling a batch is
+ * one deposit of the upper bits and a table lookup per lane.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#include "bitslice.h"
+#include "progress.h"
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct HuntConfig
+{
+    const struct BsWalkKey* Key;
+    uint64_t                Base;
+    uint64_t                Free;          // 1 to 63 bits
+    uint64_t                MaxLength;     // longest cycle looked for
+    unsigned                Threads;       // 0 for one per core
+    unsigned                ProgressEvery; // seconds, 0 for none
+};
+
+struct HuntHit
+{
+    uint64_t X;
+    uint64_t Length;
+};
+
+struct HuntResult
+{
+    struct HuntHit* Hit;  // by increasing X, malloc'd
+    uint64_t        Hits; // entries of Hit
+    uint64_t        Candidates;
+    unsigned        Threads;
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+// Returns 0, or -1 if Free has no bits or all 64, MaxLength is 0, or memory
+// ran out
+int
+hunt(const struct HuntConfig* config, struct HuntResult* result);
+
+void
+hunt_free(struct HuntResult* result);
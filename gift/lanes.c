@@ -0,0 +1,77 @@
+/**
+ * Orbits in lanes, for the walkers of bscycle.h and cycle128.h
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include "lanes.h"
+
+#include <string.h>
+
+//----------------------------------
+// Functions
+//----------------------------------
+void
+lanes_init(struct Lanes* ls, uint64_t MaxSteps)
+{
+    memset(ls, 0, sizeof(*ls));
+    ls->MaxSteps = MaxSteps;
+}
+
+_Bool
+lanes_take(struct Lanes* ls, unsigned lane, uint64_t* next, uint64_t orbits)
+{
+    uint64_t i = __atomic_fetch_add(next, 1, __ATOMIC_RELAXED);
+
+    if (i >= orbits) {
+        ls->Active &= ~((uint64_t)1 << lane);
+        return 0;
+    }
+    ls->Orbit[lane] = i;
+    ls->Began[lane] = ls->Clock;
+    ls->Active |= (uint64_t)1 << lane;
+    return 1;
+}
+
+uint64_t
+lanes_budget(const struct Lanes* ls, uint64_t steps)
+{
+    uint64_t lanes = ls->Active, left;
+    unsigned l;
+
+    if (ls->MaxSteps == 0)
+        return steps;
+    for (; lanes != 0; lanes &= lanes - 1) {
+        l    = __builtin_ctzll(lanes);
+        left = ls->Began[l] + ls->MaxSteps - ls->Clock;
+        if (left < steps)
+            steps = left;
+    }
+    return steps;
+}
+
+uint64_t
+lanes_finish(struct Lanes*     ls,
+             uint64_t          n,
+             uint64_t          back,
+             struct LaneOrbit* orbit,
+             uint64_t*         finished)
+{
+    uint64_t lanes = ls->Active, freed = 0, walked;
+    unsigned l;
+
+    ls->Clock += n;
+    for (; lanes != 0; lanes &= lanes - 1) {
+        l      = __builtin_ctzll(lanes);
+        walked = ls->Clock - ls->Began[l];
+        if (!(back >> l & 1) && (ls->MaxSteps == 0 || walked < ls->MaxSteps))
+            continue;
+
+        orbit[ls->Orbit[l]].Steps  = walked;
+        orbit[ls->Orbit[l]].Closed = back >> l & 1;
+        __atomic_fetch_add(finished, 1, __ATOMIC_RELAXED);
+        freed |= (uint64_t)1 << l;
+    }
+    return freed;
+}
@@ -0,0 +1,62 @@
+/**
+ * Orbits in lanes, for the walkers of bscycle.h and cycle128.h
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * A walker steps all lanes of its state together, each lane on an orbit of
+ * its own. The lanes share one clock, the steps of the state: an orbit
+ * started at Began has walked Clock - Began. Between walks lanes_budget()
+ * cuts the next walk short for the first orbit that would pass MaxSteps,
+ * lanes_finish() records the orbits that closed or ran out of steps, and
+ * lanes_take() hands each freed lane the next orbit of a counter the threads
+ * share. The walker only packs the start values into its own kind of state.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#define LANES_MAX 64
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct LaneOrbit
+{
+    uint64_t Steps; // the cycle length if Closed
+    _Bool    Closed;
+};
+
+struct Lanes
+{
+    uint64_t Active; // lanes that hold an orbit
+    uint64_t Clock;
+    uint64_t Began[LANES_MAX];
+    uint64_t Orbit[LANES_MAX]; // index of the orbit in each lane
+    uint64_t MaxSteps;         // per orbit, 0 for no limit
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+void
+lanes_init(struct Lanes* ls, uint64_t MaxSteps);
+
+// Puts orbit *next of orbits into lane and counts *next up, or takes the lane
+// out of Active if there is none left. Returns whether the lane got an orbit.
+_Bool
+lanes_take(struct Lanes* ls, unsigned lane, uint64_t* next, uint64_t orbits);
+
+// steps, or fewer if an active orbit reaches MaxSteps first
+uint64_t
+lanes_budget(const struct Lanes* ls, uint64_t steps);
+
+// After a walk of n steps that brought the lanes of back to their start:
+// records the orbits that closed or ran out of steps in orbit[] and counts
+// them in *finished. Returns their lanes, which are free for lanes_take().
+uint64_t
+lanes_finish(struct Lanes*     ls,
+             uint64_t          n,
+             uint64_t          back,
+             struct LaneOrbit* orbit,
+             uint64_t*         finished);
@@ -0,0 +1,182 @@
+/**
+ * ECB, CBC and CTR modes over GIFT-64 and GIFT-128
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include "modes.h"
+#include "simd.h"
+
+#include <string.h>
+
+#define GIFT128_ROUNDS 40
+#define CHUNK 256 // blocks per kernel call for CBC decryption and CTR
+
+// Words per block
+#define WORDS(mk) ((mk)->BlockSize64 ? 1 : 2)
+
+//----------------------------------
+// Key Scheduling
+//----------------------------------
+void
+mode_key_init(struct ModeKey* mk,
+              uint64_t        key_high,
+              uint64_t        key_low,
+              uint16_t        Rounds,
+              _Bool           BlockSize64)
+{
+    uint16_t i;
+
+    mk->BlockSize64 = BlockSize64;
+    if (BlockSize64) {
+        if (Rounds > MAX_ROUNDS)
+            Rounds = MAX_ROUNDS;
+        key_schedule_init(&mk->Encrypt, key_high, key_low, Rounds, 0);
+        fixslice_key(&mk->Single, mk->Encrypt.Subkey, Rounds);
+
+        // decrypt() with these keys and the same round count undoes
+        // encrypt(): Rounds - 1 inverse rounds and a zero key at the end
+        mk->Inverse.Subkey[0] = 0;
+        for (i = 1; i < Rounds; i++) {
+            mk->Inverse.Subkey[i] = mk->Encrypt.Subkey[i - 1];
+        }
+        mk->Inverse.Rounds = Rounds;
+    } else {
+        Rounds = GIFT128_ROUNDS;
+        key_schedule128_init(&mk->Encrypt, key_high, key_low, Rounds);
+
+        // The same for decrypt128(), which needs one round more than the
+        // 40 of encrypt128()
+        mk->Inverse.Subkey[0] = 0;
+        mk->Inverse.Subkey[1] = 0;
+        for (i = 2; i < 2 * (Rounds + 1); i++) {
+            mk->Inverse.Subkey[i] = mk->Encrypt.Subkey[i - 2];
+        }
+        mk->Inverse.Rounds = Rounds + 1;
+    }
+    mk->Rounds = Rounds;
+}
+
+//----------------------------------
+// Multi-block kernels
+//----------------------------------
+static void
+encrypt_blocks(struct ModeKey* mk, uint64_t* buf, size_t n)
+{
+    if (mk->BlockSize64)
+        simd_encrypt(buf, n, mk->Encrypt.Subkey, mk->Rounds);
+    else
+        simd_encrypt128(buf, n, mk->Encrypt.Subkey, mk->Rounds);
+}
+
+static void
+decrypt_blocks(struct ModeKey* mk, uint64_t* buf, size_t n)
+{
+    if (mk->BlockSize64)
+        simd_decrypt(buf, n, mk->Inverse.Subkey, mk->Inverse.Rounds);
+    else
+        simd_decrypt128(buf, n, mk->Inverse.Subkey, mk->Inverse.Rounds);
+}
+
+//----------------------------------
+// ECB
+//----------------------------------
+void
+ecb_encrypt(struct ModeKey* mk, uint64_t* buf, size_t n)
+{
+    encrypt_blocks(mk, buf, n);
+}
+
+void
+ecb_decrypt(struct ModeKey* mk, uint64_t* buf, size_t n)
+{
+    decrypt_blocks(mk, buf, n);
+}
+
+//----------------------------------
+// CBC
+//----------------------------------
+// Every block depends on the one before, so encryption runs one block at a
+// time: the fixsliced code for GIFT-64, a one-block kernel call for GIFT-128
+void
+cbc_encrypt(struct ModeKey* mk, uint64_t* iv, uint64_t* buf, size_t n)
+{
+    size_t i;
+
+    if (mk->BlockSize64) {
+        uint64_t chain = iv[0];
+
+        for (i = 0; i < n; i++) {
+            chain  = encrypt_fixslice(buf[i] ^ chain, &mk->Single);
+            buf[i] = chain;
+        }
+        iv[0] = chain;
+    } else {
+        for (i = 0; i < n; i++) {
+            buf[2 * i] ^= iv[0];
+            buf[2 * i + 1] ^= iv[1];
+            encrypt_blocks(mk, buf + 2 * i, 1);
+            iv[0] = buf[2 * i];
+            iv[1] = buf[2 * i + 1];
+        }
+    }
+}
+
+// Decryption of all blocks is independent, only the xor with the previous
+// ciphertext is chained
+void
+cbc_decrypt(struct ModeKey* mk, uint64_t* iv, uint64_t* buf, size_t n)
+{
+    uint64_t tmp[2 * CHUNK];
+    uint64_t next[2];
+    size_t   words = WORDS(mk);
+    size_t   start, len, i, w;
+
+    for (start = 0; start < n; start += len) {
+        uint64_t* c = buf + words * start;
+
+        len = (n - start < CHUNK) ? n - start : CHUNK;
+        memcpy(tmp, c, words * len * sizeof(uint64_t));
+        memcpy(next, c + words * (len - 1), words * sizeof(uint64_t));
+        decrypt_blocks(mk, tmp, len);
+
+        // Backwards, so the ciphertext before each block is still there
+        for (i = len; i-- > 0;) {
+            const uint64_t* prev = i ? c + words * (i - 1) : iv;
+            for (w = 0; w < words; w++) {
+                c[words * i + w] = tmp[words * i + w] ^ prev[w];
+            }
+        }
+        memcpy(iv, next, words * sizeof(uint64_t));
+    }
+}
+
+//----------------------------------
+// CTR
+//----------------------------------
+void
+ctr_crypt(struct ModeKey* mk, uint64_t* counter, uint64_t* buf, size_t n)
+{
+    uint64_t tmp[2 * CHUNK];
+    size_t   words = WORDS(mk);
+    size_t   start, len, i;
+
+    for (start = 0; start < n; start += len) {
+        len = (n - start < CHUNK) ? n - start : CHUNK;
+
+        // Key stream: the encrypted counter blocks
+        for (i = 0; i < len; i++) {
+            tmp[words * i] = counter[0];
+            if (words == 2)
+                tmp[2 * i + 1] = counter[1];
+            if (++counter[0] == 0 && words == 2)
+                counter[1]++;
+        }
+        encrypt_blocks(mk, tmp, len);
+
+        for (i = 0; i < words * len; i++) {
+            buf[words * start + i] ^= tmp[i];
+        }
+    }
+}
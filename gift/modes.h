@@ -0,0 +1,66 @@
+/**
+ * ECB, CBC and CTR modes over GIFT-64 and GIFT-128
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * All functions work in place on a caller buffer of n blocks: one word per
+ * block for GIFT-64, two words (low word first, as returned by encrypt128)
+ * for GIFT-128. Independent blocks (ECB, CTR and CBC decryption) go through
+ * the multi-block kernels of simd.c in chunks on the stack, so there is no
+ * allocation per block or per call.
+ *
+ * Encryption is encrypt() or encrypt128(). decrypt() and decrypt128() are
+ * not their inverse (they stop one round late), so decryption here runs
+ * them on the round keys shifted by one round, with a zero key in front,
+ * which undoes encrypt() exactly. GIFT-128 always uses 40 rounds, like
+ * encrypt128().
+ *
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crypto.h"
+#include "fixslice.h"
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct ModeKey
+{
+    struct KeySchedule Encrypt; // round keys of encrypt()/encrypt128()
+    struct KeySchedule Inverse; // the same shifted by one, for decryption
+    struct FixsliceKey Single;  // GIFT-64 keys for CBC encryption
+    uint16_t           Rounds;
+    _Bool              BlockSize64;
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+void
+mode_key_init(struct ModeKey* mk,
+              uint64_t        key_high,
+              uint64_t        key_low,
+              uint16_t        Rounds,
+              _Bool           BlockSize64);
+
+void
+ecb_encrypt(struct ModeKey* mk, uint64_t* buf, size_t n);
+
+void
+ecb_decrypt(struct ModeKey* mk, uint64_t* buf, size_t n);
+
+// iv is one or two words and is left holding the last ciphertext block, so
+// a stream can be processed in several calls
+void
+cbc_encrypt(struct ModeKey* mk, uint64_t* iv, uint64_t* buf, size_t n);
+
+void
+cbc_decrypt(struct ModeKey* mk, uint64_t* iv, uint64_t* buf, size_t n);
+
+// Encryption and decryption are the same. The counter block (one or two
+// words, incremented as an integer) is advanced past the blocks used.
+void
+ctr_crypt(struct ModeKey* mk, uint64_t* counter, uint64_t* buf, size_t n);
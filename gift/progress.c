@@ -0,0 +1,194 @@
+/**
+ * Progress reports of long walks
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "progress.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//----------------------------------
+// Functions
+//----------------------------------
+double
+progress_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void
+progress_start(struct Progress* p, uint64_t steps, uint64_t limit)
+{
+    p->Start     = progress_now();
+    p->Last      = p->Start;
+    p->LastSteps = steps;
+    p->Limit     = limit;
+}
+
+void
+progress_report(struct Progress* p,
+                uint64_t         steps,
+                uint64_t         points,
+                uint64_t         finished,
+                uint64_t         orbits,
+                uint64_t         value)
+{
+    double now  = progress_now();
+    double rate = 0;
+
+    if (now > p->Last && steps >= p->LastSteps)
+        rate = (steps - p->LastSteps) / (now - p->Last);
+
+    fprintf(stderr,
+            "progress elapsed=%.1f steps=%" PRIu64 " rate=%.0f points=%" PRIu64
+            " orbits=%" PRIu64 "/%" PRIu64 " value=%016" PRIx64,
+            now - p->Start,
+            steps,
+            rate,
+            points,
+            finished,
+            orbits,
+            value);
+    if (p->Limit != 0 && rate > 0)
+        fprintf(stderr,
+                " eta=%.0f\n",
+                steps < p->Limit ? (p->Limit - steps) / rate : 0.0);
+    else
+        fprintf(stderr, " eta=-\n");
+    fflush(stderr);
+
+    p->Last      = now;
+    p->LastSteps = steps;
+}
+
+//----------------------------------
+// Worker threads
+//----------------------------------
+void
+pool_init(struct WorkerPool* p)
+{
+    p->Thread  = NULL;
+    p->Started = 0;
+    p->Running = 0;
+    pthread_mutex_init(&p->Lock, NULL);
+    pthread_cond_init(&p->Changed, NULL);
+}
+
+void
+pool_free(struct WorkerPool* p)
+{
+    pthread_mutex_destroy(&p->Lock);
+    pthread_cond_destroy(&p->Changed);
+}
+
+time_t
+pool_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec;
+}
+
+// Running counts every worker from the start, the threads cannot call
+// pool_done() before the lock is dropped
+void
+pool_start(struct WorkerPool* p,
+           void* (*work)(void*),
+           void*    arg,
+           size_t   size,
+           unsigned n)
+{
+    unsigned i;
+
+    p->Thread = malloc(n * sizeof(pthread_t));
+    pthread_mutex_lock(&p->Lock);
+    p->Running = n;
+    for (i = 0; p->Thread != NULL && i < n; i++) {
+        if (pthread_create(&p->Thread[i], NULL, work, (char*)arg + i * size) !=
+            0)
+            break;
+    }
+    p->Started = i;
+
+    if (i < n) {
+        pthread_mutex_unlock(&p->Lock);
+        for (; i < n; i++) {
+            work((char*)arg + i * size);
+        }
+        pthread_mutex_lock(&p->Lock);
+    }
+}
+
+int
+pool_wait(struct WorkerPool* p, time_t until)
+{
+    struct timespec wake = { until, 0 };
+
+    while (p->Running > 0) {
+        if (until == 0)
+            pthread_cond_wait(&p->Changed, &p->Lock);
+        else if (pthread_cond_timedwait(&p->Changed, &p->Lock, &wake) ==
+                 ETIMEDOUT)
+            return 1;
+    }
+    return 0;
+}
+
+void
+pool_join(struct WorkerPool* p)
+{
+    unsigned i;
+
+    pthread_mutex_unlock(&p->Lock);
+    for (i = 0; i < p->Started; i++) {
+        pthread_join(p->Thread[i], NULL);
+    }
+    free(p->Thread);
+    p->Thread  = NULL;
+    p->Started = 0;
+}
+
+void
+pool_done(struct WorkerPool* p)
+{
+    pthread_mutex_lock(&p->Lock);
+    p->Running--;
+    pthread_cond_broadcast(&p->Changed);
+    pthread_mutex_unlock(&p->Lock);
+}
+
+void
+pool_run(struct WorkerPool* p,
+         void* (*work)(void*),
+         void*    arg,
+         size_t   size,
+         unsigned n,
+         unsigned every,
+         void (*report)(void*),
+         void* ctx)
+{
+    time_t nextReport;
+
+    pool_start(p, work, arg, size, n);
+    nextReport = pool_now() + every;
+    while (pool_wait(p, every != 0 ? nextReport : 0)) {
+        report(ctx);
+        nextReport = pool_now() + every;
+    }
+    pool_join(p);
+
+    if (every != 0)
+        report(ctx);
+}
@@ -0,0 +1,113 @@
+/**
+ * Progress reports of long walks
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The walkers only count their steps. Whoever owns the clock (the controller
+ * thread of the cycle search, or the plain cycle loop between chunks of
+ * steps) calls progress_report() when a report is due, which prints one line
+ * of key=value pairs to stderr:
+ *
+ *   progress elapsed=60.0 steps=1073741824 rate=17895697 points=64
+ *            orbits=3/16 value=0123456789abcdef eta=3540
+ *
+ * (on one line). rate is the steps per second since the last report, eta the
+ * seconds until the step limit at that rate, or - without a limit.
+ *
+ * The searches run their walkers on a WorkerPool. pool_run() starts them,
+ * reports every so many seconds until they are done and joins them; a search
+ * that has more to do on the clock, such as checkpoints, calls pool_start(),
+ * pool_wait() and pool_join() itself.
+ *
+ */
+
+#pragma once
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+struct Progress
+{
+    double   Start; // seconds on the monotonic clock
+    double   Last;
+    uint64_t LastSteps;
+    uint64_t Limit; // bound on the steps, 0 for none
+};
+
+// Worker i runs work(arg + i * size) and calls pool_done() when it returns.
+// A search can wait on Changed under Lock for changes of its own as well.
+struct WorkerPool
+{
+    pthread_t*      Thread;
+    unsigned        Started; // threads to join
+    unsigned        Running; // workers that have not called pool_done()
+    pthread_mutex_t Lock;
+    pthread_cond_t  Changed; // a worker finished
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+double
+progress_now(void);
+
+// steps are the steps already done, say by a resumed search
+void
+progress_start(struct Progress* p, uint64_t steps, uint64_t limit);
+
+void
+progress_report(struct Progress* p,
+                uint64_t         steps,
+                uint64_t         points,
+                uint64_t         finished,
+                uint64_t         orbits,
+                uint64_t         value);
+
+void
+pool_init(struct WorkerPool* p);
+
+void
+pool_free(struct WorkerPool* p);
+
+// Seconds on the clock of pthread_cond_timedwait()
+time_t
+pool_now(void);
+
+// Starts n workers and returns with the lock held. The workers no thread
+// could be started for run on the calling thread before it returns.
+void
+pool_start(struct WorkerPool* p,
+           void* (*work)(void*),
+           void*    arg,
+           size_t   size,
+           unsigned n);
+
+// With the lock held: 0 once all workers are done, 1 if the pool_now() clock
+// reaches until first. until 0 waits for the workers alone.
+int
+pool_wait(struct WorkerPool* p, time_t until);
+
+// Drops the lock and joins the threads
+void
+pool_join(struct WorkerPool* p);
+
+// The last call of a worker
+void
+pool_done(struct WorkerPool* p);
+
+// pool_start() to pool_join(), with report(ctx) every `every` seconds while
+// the workers run and once at the end, never if every is 0. report is called
+// with the lock held.
+void
+pool_run(struct WorkerPool* p,
+         void* (*work)(void*),
+         void*    arg,
+         size_t   size,
+         unsigned n,
+         unsigned every,
+         void (*report)(void*),
+         void* ctx);
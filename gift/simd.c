@@ -0,0 +1,1022 @@
+/**
+ * SSSE3/AVX2 kernels for GIFT-64 and GIFT-128 on many blocks
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include "simd.h"
+#include "bitslice.h"
+#include "crypto.h"
+#include "fixslice.h"
+#include "modes.h"
+#include "slice128.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+#define GIFT128_ROUNDS 40
+#define LANE_CHUNK 64 // GIFT-128 blocks per call of slice128_encrypt_lanes()
+
+//----------------------------------
+// Shuffle tables
+//----------------------------------
+// Perm[b][n] is the nibble that bit b of nibble n is taken from. For GIFT-128
+// the table is split by destination and source half of the state, where
+// 0x80 makes the shuffle write a zero.
+static struct
+{
+    uint8_t Sbox[16];
+    uint8_t SboxInv[16];
+    uint8_t Perm[4][16];
+    uint8_t PermInv[4][16];
+    uint8_t Perm128Inv[2][2][4][16];
+} Tab;
+
+// Built by the first call from any thread, the cycle walkers call in from many
+static pthread_once_t SimdOnce = PTHREAD_ONCE_INIT;
+
+// Takes a table of destination bits (out bit box[i] = in bit i)
+static void
+perm128_init(uint8_t perm[2][2][4][16], const uint8_t box[128])
+{
+    uint8_t srcOf[128];
+    int     i, h;
+
+    for (i = 0; i < 128; i++) {
+        srcOf[box[i]] = i;
+    }
+    for (i = 0; i < 128; i++) {
+        uint8_t src = srcOf[i] / 4;
+        for (h = 0; h < 2; h++) {
+            perm[i / 64][h][i % 4][(i / 4) % 16] =
+              (src / 16 == h) ? src % 16 : 0x80;
+        }
+    }
+}
+
+static void
+simd_init(void)
+{
+    int i;
+
+    memcpy(Tab.Sbox, Sbox, 16);
+    memcpy(Tab.SboxInv, SboxInv, 16);
+    // Same bit order as the P-Box loops of encrypt() and decrypt()
+    for (i = 0; i < 64; i++) {
+        Tab.Perm[i % 4][i / 4]    = (63 - Pbox[63 - i]) / 4;
+        Tab.PermInv[i % 4][i / 4] = (63 - PboxInv[63 - i]) / 4;
+    }
+    perm128_init(Tab.Perm128Inv, Pbox128Inv);
+}
+
+// Round keys with one nibble per byte, in the layout of the kernels
+static void
+key_nibbles(uint8_t* out, uint64_t key)
+{
+    int n;
+
+    for (n = 0; n < 16; n++) {
+        out[n] = (key >> (4 * n)) & 0x0F;
+    }
+}
+
+//----------------------------------
+// SSSE3 kernels
+//----------------------------------
+#ifdef SIMD_X86
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+// 8 packed bytes in each 64-bit half -> one nibble per byte, and back
+#define UNPACK_SSE(in, lo, hi)                                                 \
+    do {                                                                       \
+        lo = _mm_and_si128(in, _mm_set1_epi8(0x0F));                           \
+        hi = _mm_and_si128(_mm_srli_epi16(in, 4), _mm_set1_epi8(0x0F));        \
+    } while (0)
+
+TARGET_SSSE3 static inline __m128i
+pack_ssse3(__m128i x)
+{
+    x = _mm_maddubs_epi16(x, _mm_set1_epi16(0x1001));
+    return _mm_packus_epi16(x, x);
+}
+
+// Gathers bit b of every nibble from nibble perm[b]
+TARGET_SSSE3 static inline __m128i
+player_ssse3(__m128i x, const __m128i perm[4])
+{
+    __m128i p0 = _mm_and_si128(_mm_shuffle_epi8(x, perm[0]), _mm_set1_epi8(1));
+    __m128i p1 = _mm_and_si128(_mm_shuffle_epi8(x, perm[1]), _mm_set1_epi8(2));
+    __m128i p2 = _mm_and_si128(_mm_shuffle_epi8(x, perm[2]), _mm_set1_epi8(4));
+    __m128i p3 = _mm_and_si128(_mm_shuffle_epi8(x, perm[3]), _mm_set1_epi8(8));
+    return _mm_or_si128(_mm_or_si128(p0, p1), _mm_or_si128(p2, p3));
+}
+
+// One half of the GIFT-128 state, gathered from both halves
+TARGET_SSSE3 static inline __m128i
+player128_ssse3(__m128i lo, __m128i hi, __m128i perm[2][4])
+{
+    __m128i out = _mm_setzero_si128();
+    int     b;
+
+    for (b = 0; b < 4; b++) {
+        __m128i p = _mm_or_si128(_mm_shuffle_epi8(lo, perm[0][b]),
+                                 _mm_shuffle_epi8(hi, perm[1][b]));
+        out = _mm_or_si128(out, _mm_and_si128(p, _mm_set1_epi8(1 << b)));
+    }
+    return out;
+}
+
+// Two blocks per iteration, one in each register
+TARGET_SSSE3 static void
+encrypt_ssse3(uint64_t* blocks, uint8_t rk[][16], uint16_t Rounds)
+{
+    __m128i  sbox = _mm_loadu_si128((const __m128i*)Tab.Sbox);
+    __m128i  perm[4];
+    __m128i  in, lo, hi, a, b;
+    uint16_t RoundNr;
+    int      i;
+
+    for (i = 0; i < 4; i++) {
+        perm[i] = _mm_loadu_si128((const __m128i*)Tab.Perm[i]);
+    }
+
+    in = _mm_loadu_si128((const __m128i*)blocks);
+    UNPACK_SSE(in, lo, hi);
+    a = _mm_unpacklo_epi8(lo, hi);
+    b = _mm_unpackhi_epi8(lo, hi);
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        __m128i key = _mm_loadu_si128((const __m128i*)rk[RoundNr - 1]);
+
+        a = _mm_shuffle_epi8(sbox, a);
+        b = _mm_shuffle_epi8(sbox, b);
+        a = _mm_xor_si128(player_ssse3(a, perm), key);
+        b = _mm_xor_si128(player_ssse3(b, perm), key);
+    }
+
+    in = _mm_unpacklo_epi64(pack_ssse3(a), pack_ssse3(b));
+    _mm_storeu_si128((__m128i*)blocks, in);
+}
+
+TARGET_SSSE3 static void
+decrypt_ssse3(uint64_t* blocks, uint8_t rk[][16], uint16_t Rounds)
+{
+    __m128i  sbox = _mm_loadu_si128((const __m128i*)Tab.SboxInv);
+    __m128i  perm[4];
+    __m128i  in, lo, hi, a, b, key;
+    uint16_t RoundNr;
+    int      i;
+
+    for (i = 0; i < 4; i++) {
+        perm[i] = _mm_loadu_si128((const __m128i*)Tab.PermInv[i]);
+    }
+
+    in = _mm_loadu_si128((const __m128i*)blocks);
+    UNPACK_SSE(in, lo, hi);
+    a = _mm_unpacklo_epi8(lo, hi);
+    b = _mm_unpackhi_epi8(lo, hi);
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        key = _mm_loadu_si128((const __m128i*)rk[Rounds - RoundNr]);
+        a   = player_ssse3(_mm_xor_si128(a, key), perm);
+        b   = player_ssse3(_mm_xor_si128(b, key), perm);
+        a   = _mm_shuffle_epi8(sbox, a);
+        b   = _mm_shuffle_epi8(sbox, b);
+    }
+    key = _mm_loadu_si128((const __m128i*)rk[0]);
+    a   = _mm_xor_si128(a, key);
+    b   = _mm_xor_si128(b, key);
+
+    in = _mm_unpacklo_epi64(pack_ssse3(a), pack_ssse3(b));
+    _mm_storeu_si128((__m128i*)blocks, in);
+}
+
+// One GIFT-128 block, nibbles 0-15 in lo and 16-31 in hi
+TARGET_SSSE3 static void
+decrypt128_ssse3(uint64_t* block, uint8_t rk[][32], uint16_t Rounds)
+{
+    __m128i  sbox = _mm_loadu_si128((const __m128i*)Tab.SboxInv);
+    __m128i  perm[2][2][4];
+    __m128i  in, lo, hi, l, h;
+    uint16_t RoundNr;
+    int      i;
+
+    for (i = 0; i < 16; i++) {
+        perm[i / 8][(i / 4) % 2][i % 4] = _mm_loadu_si128(
+          (const __m128i*)Tab.Perm128Inv[i / 8][(i / 4) % 2][i % 4]);
+    }
+
+    in = _mm_loadu_si128((const __m128i*)block);
+    UNPACK_SSE(in, l, h);
+    lo = _mm_unpacklo_epi8(l, h);
+    hi = _mm_unpackhi_epi8(l, h);
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        const uint8_t* key = rk[Rounds - RoundNr];
+
+        lo = _mm_xor_si128(lo, _mm_loadu_si128((const __m128i*)key));
+        hi = _mm_xor_si128(hi, _mm_loadu_si128((const __m128i*)(key + 16)));
+        l  = player128_ssse3(lo, hi, perm[0]);
+        h  = player128_ssse3(lo, hi, perm[1]);
+        lo = _mm_shuffle_epi8(sbox, l);
+        hi = _mm_shuffle_epi8(sbox, h);
+    }
+    lo = _mm_xor_si128(lo, _mm_loadu_si128((const __m128i*)rk[0]));
+    hi = _mm_xor_si128(hi, _mm_loadu_si128((const __m128i*)(rk[0] + 16)));
+
+    in = _mm_unpacklo_epi64(pack_ssse3(lo), pack_ssse3(hi));
+    _mm_storeu_si128((__m128i*)block, in);
+}
+
+//----------------------------------
+// AVX2 kernels
+//----------------------------------
+// The same layout with a block in each 128-bit lane for GIFT-64, and one
+// GIFT-128 block spread over both lanes
+#define UNPACK_AVX2(in, lo, hi)                                                \
+    do {                                                                       \
+        lo = _mm256_and_si256(in, _mm256_set1_epi8(0x0F));                     \
+        hi = _mm256_and_si256(_mm256_srli_epi16(in, 4),                        \
+                              _mm256_set1_epi8(0x0F));                         \
+    } while (0)
+
+TARGET_AVX2 static inline __m256i
+pack_avx2(__m256i x)
+{
+    x = _mm256_maddubs_epi16(x, _mm256_set1_epi16(0x1001));
+    return _mm256_packus_epi16(x, x);
+}
+
+TARGET_AVX2 static inline __m256i
+player_avx2(__m256i x, const __m256i perm[4])
+{
+    __m256i p0 =
+      _mm256_and_si256(_mm256_shuffle_epi8(x, perm[0]), _mm256_set1_epi8(1));
+    __m256i p1 =
+      _mm256_and_si256(_mm256_shuffle_epi8(x, perm[1]), _mm256_set1_epi8(2));
+    __m256i p2 =
+      _mm256_and_si256(_mm256_shuffle_epi8(x, perm[2]), _mm256_set1_epi8(4));
+    __m256i p3 =
+      _mm256_and_si256(_mm256_shuffle_epi8(x, perm[3]), _mm256_set1_epi8(8));
+    return _mm256_or_si256(_mm256_or_si256(p0, p1), _mm256_or_si256(p2, p3));
+}
+
+// Shuffles only stay within a lane, so the state is also shuffled with its
+// lanes swapped to reach the other half
+TARGET_AVX2 static inline __m256i
+player128_avx2(__m256i x, const __m256i same[4], const __m256i cross[4])
+{
+    __m256i swapped = _mm256_permute2x128_si256(x, x, 0x01);
+    __m256i out     = _mm256_setzero_si256();
+    int     b;
+
+    for (b = 0; b < 4; b++) {
+        __m256i p = _mm256_or_si256(_mm256_shuffle_epi8(x, same[b]),
+                                    _mm256_shuffle_epi8(swapped, cross[b]));
+        out = _mm256_or_si256(out,
+                              _mm256_and_si256(p, _mm256_set1_epi8(1 << b)));
+    }
+    return out;
+}
+
+TARGET_AVX2 static inline __m256i
+broadcast_avx2(const uint8_t* table)
+{
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table));
+}
+
+// Splits a GIFT-128 table into the shuffles within and across lanes
+TARGET_AVX2 static void
+perm128_avx2(uint8_t perm[2][2][4][16], __m256i same[4], __m256i cross[4])
+{
+    int b;
+
+    for (b = 0; b < 4; b++) {
+        same[b] = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+            _mm_loadu_si128((const __m128i*)perm[0][0][b])),
+          _mm_loadu_si128((const __m128i*)perm[1][1][b]),
+          1);
+        cross[b] = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+            _mm_loadu_si128((const __m128i*)perm[0][1][b])),
+          _mm_loadu_si128((const __m128i*)perm[1][0][b]),
+          1);
+    }
+}
+
+// Four blocks per iteration in two registers
+TARGET_AVX2 static void
+encrypt_avx2(uint64_t* blocks, uint8_t rk[][16], uint16_t Rounds)
+{
+    __m256i  sbox = broadcast_avx2(Tab.Sbox);
+    __m256i  perm[4];
+    __m256i  in, lo, hi, a, b;
+    uint16_t RoundNr;
+    int      i;
+
+    for (i = 0; i < 4; i++) {
+        perm[i] = broadcast_avx2(Tab.Perm[i]);
+    }
+
+    in = _mm256_loadu_si256((const __m256i*)blocks);
+    UNPACK_AVX2(in, lo, hi);
+    a = _mm256_unpacklo_epi8(lo, hi);
+    b = _mm256_unpackhi_epi8(lo, hi);
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        __m256i key = broadcast_avx2(rk[RoundNr - 1]);
+
+        a = _mm256_shuffle_epi8(sbox, a);
+        b = _mm256_shuffle_epi8(sbox, b);
+        a = _mm256_xor_si256(player_avx2(a, perm), key);
+        b = _mm256_xor_si256(player_avx2(b, perm), key);
+    }
+
+    in = _mm256_unpacklo_epi64(pack_avx2(a), pack_avx2(b));
+    _mm256_storeu_si256((__m256i*)blocks, in);
+}
+
+TARGET_AVX2 static void
+decrypt_avx2(uint64_t* blocks, uint8_t rk[][16], uint16_t Rounds)
+{
+    __m256i  sbox = broadcast_avx2(Tab.SboxInv);
+    __m256i  perm[4];
+    __m256i  in, lo, hi, a, b, key;
+    uint16_t RoundNr;
+    int      i;
+
+    for (i = 0; i < 4; i++) {
+        perm[i] = broadcast_avx2(Tab.PermInv[i]);
+    }
+
+    in = _mm256_loadu_si256((const __m256i*)blocks);
+    UNPACK_AVX2(in, lo, hi);
+    a = _mm256_unpacklo_epi8(lo, hi);
+    b = _mm256_unpackhi_epi8(lo, hi);
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        key = broadcast_avx2(rk[Rounds - RoundNr]);
+        a   = player_avx2(_mm256_xor_si256(a, key), perm);
+        b   = player_avx2(_mm256_xor_si256(b, key), perm);
+        a   = _mm256_shuffle_epi8(sbox, a);
+        b   = _mm256_shuffle_epi8(sbox, b);
+    }
+    key = broadcast_avx2(rk[0]);
+    a   = _mm256_xor_si256(a, key);
+    b   = _mm256_xor_si256(b, key);
+
+    in = _mm256_unpacklo_epi64(pack_avx2(a), pack_avx2(b));
+    _mm256_storeu_si256((__m256i*)blocks, in);
+}
+
+// Loads a GIFT-128 block as nibbles 0-15 in the low lane, 16-31 in the high
+TARGET_AVX2 static inline __m256i
+load128_avx2(const uint64_t* block)
+{
+    __m128i in = _mm_loadu_si128((const __m128i*)block);
+    __m128i lo, hi;
+
+    UNPACK_SSE(in, lo, hi);
+    return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_unpacklo_epi8(lo, hi)),
+      _mm_unpackhi_epi8(lo, hi),
+      1);
+}
+
+TARGET_AVX2 static inline void
+store128_avx2(uint64_t* block, __m256i x)
+{
+    x = _mm256_permute4x64_epi64(pack_avx2(x), 0x08);
+    _mm_storeu_si128((__m128i*)block, _mm256_castsi256_si128(x));
+}
+
+// Two blocks per iteration
+TARGET_AVX2 static void
+decrypt128_avx2(uint64_t* blocks, uint8_t rk[][32], uint16_t Rounds)
+{
+    __m256i  sbox = broadcast_avx2(Tab.SboxInv);
+    __m256i  same[4], cross[4];
+    __m256i  a = load128_avx2(blocks);
+    __m256i  b = load128_avx2(blocks + 2);
+    __m256i  key;
+    uint16_t RoundNr;
+
+    perm128_avx2(Tab.Perm128Inv, same, cross);
+
+    for (RoundNr = 1; RoundNr < Rounds; RoundNr++) {
+        key = _mm256_loadu_si256((const __m256i*)rk[Rounds - RoundNr]);
+        a   = player128_avx2(_mm256_xor_si256(a, key), same, cross);
+        b   = player128_avx2(_mm256_xor_si256(b, key), same, cross);
+        a   = _mm256_shuffle_epi8(sbox, a);
+        b   = _mm256_shuffle_epi8(sbox, b);
+    }
+    key = _mm256_loadu_si256((const __m256i*)rk[0]);
+    a   = _mm256_xor_si256(a, key);
+    b   = _mm256_xor_si256(b, key);
+
+    store128_avx2(blocks, a);
+    store128_avx2(blocks + 2, b);
+}
+#endif // SIMD_X86
+
+//----------------------------------
+// Dispatch
+//----------------------------------
+enum SimdLevel
+simd_detect(void)
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return SIMD_SSSE3;
+#endif
+    return SIMD_SCALAR;
+}
+
+// Kernels work on fixed groups of words. The tail is run through a zero
+// padded copy so callers can pass any number of blocks.
+typedef void (*Kernel64)(uint64_t*, uint8_t (*)[16], uint16_t);
+typedef void (*Kernel128)(uint64_t*, uint8_t (*)[32], uint16_t);
+
+static void
+run64(Kernel64        kernel,
+      size_t          group,
+      uint64_t*       blocks,
+      size_t          n,
+      uint8_t         rk[][16],
+      uint16_t        Rounds)
+{
+    uint64_t tail[4] = { 0 };
+    size_t   i;
+
+    for (i = 0; i + group <= n; i += group) {
+        kernel(blocks + i, rk, Rounds);
+    }
+    if (i < n) {
+        memcpy(tail, blocks + i, (n - i) * sizeof(uint64_t));
+        kernel(tail, rk, Rounds);
+        memcpy(blocks + i, tail, (n - i) * sizeof(uint64_t));
+    }
+}
+
+static void
+run128(Kernel128      kernel,
+       size_t         group,
+       uint64_t*      blocks,
+       size_t         n,
+       uint8_t        rk[][32],
+       uint16_t       Rounds)
+{
+    uint64_t tail[4] = { 0 };
+    size_t   i;
+
+    for (i = 0; i + group <= n; i += group) {
+        kernel(blocks + 2 * i, rk, Rounds);
+    }
+    if (i < n) {
+        memcpy(tail, blocks + 2 * i, 2 * (n - i) * sizeof(uint64_t));
+        kernel(tail, rk, Rounds);
+        memcpy(blocks + 2 * i, tail, 2 * (n - i) * sizeof(uint64_t));
+    }
+}
+
+static void
+crypt64(enum SimdLevel level,
+        _Bool          Decrypt,
+        uint64_t*      blocks,
+        size_t         n,
+        uint64_t*      subkey,
+        uint16_t       Rounds)
+{
+    uint8_t rk[MAX_ROUNDS][16];
+    size_t  i;
+
+    if (level == SIMD_SCALAR) {
+        struct FixsliceKey fk;
+
+        fixslice_key(&fk, subkey, Rounds);
+        for (i = 0; i < n; i++) {
+            blocks[i] = Decrypt ? decrypt_fixslice(blocks[i], &fk)
+                                : encrypt_fixslice(blocks[i], &fk);
+        }
+        return;
+    }
+    if (Decrypt && Rounds == 0)
+        return;
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+
+    pthread_once(&SimdOnce, simd_init);
+    for (i = 0; i < Rounds; i++) {
+        key_nibbles(rk[i], subkey[i]);
+    }
+
+#ifdef SIMD_X86
+    if (level >= SIMD_AVX2)
+        run64(Decrypt ? decrypt_avx2 : encrypt_avx2, 4, blocks, n, rk, Rounds);
+    else
+        run64(
+          Decrypt ? decrypt_ssse3 : encrypt_ssse3, 2, blocks, n, rk, Rounds);
+#endif
+}
+
+// GIFT-128 encryption runs on the bitsliced core of slice128.c instead, with
+// one block per 32-bit lane. Like encrypt128() it always takes 40 rounds.
+static void
+encrypt128_lanes(enum SimdLevel level,
+                 uint64_t*      blocks,
+                 size_t         n,
+                 uint64_t*      subkey)
+{
+    uint32_t rk[GIFT128_ROUNDS][4];
+    uint32_t S[LANE_CHUNK][4];
+    size_t   start, len, i;
+
+    for (i = 0; i < GIFT128_ROUNDS; i++) {
+        slice128_key(rk[i], subkey[2 * i + 1], subkey[2 * i]);
+    }
+
+    for (start = 0; start < n; start += len) {
+        uint64_t* b = blocks + 2 * start;
+
+        len = (n - start < LANE_CHUNK) ? n - start : LANE_CHUNK;
+        for (i = 0; i < len; i++) {
+            slice128_pack(S[i], b[2 * i + 1], b[2 * i]);
+        }
+        slice128_encrypt_lanes(level, S, len, rk, GIFT128_ROUNDS);
+        for (i = 0; i < len; i++) {
+            slice128_unpack(S[i], &b[2 * i + 1], &b[2 * i]);
+        }
+    }
+}
+
+static void
+crypt128(enum SimdLevel level,
+         _Bool          Decrypt,
+         uint64_t*      blocks,
+         size_t         n,
+         uint64_t*      subkey,
+         uint16_t       Rounds)
+{
+    uint8_t rk[MAX_ROUNDS][32];
+    size_t  i;
+
+    if (!Decrypt) {
+        encrypt128_lanes(level, blocks, n, subkey);
+        return;
+    }
+
+    if (level == SIMD_SCALAR) {
+        struct Block128Key bk;
+
+        block128_key(&bk, subkey, Rounds);
+        for (i = 0; i < n; i++) {
+            struct Block128 block = { blocks[2 * i], blocks[2 * i + 1] };
+
+            decrypt128_block(&block, &bk);
+            blocks[2 * i]     = block.Low;
+            blocks[2 * i + 1] = block.High;
+        }
+        return;
+    }
+    if (Rounds == 0)
+        return;
+    if (Rounds > MAX_ROUNDS)
+        Rounds = MAX_ROUNDS;
+
+    pthread_once(&SimdOnce, simd_init);
+    for (i = 0; i < Rounds; i++) {
+        key_nibbles(rk[i], subkey[2 * i]);
+        key_nibbles(rk[i] + 16, subkey[2 * i + 1]);
+    }
+
+#ifdef SIMD_X86
+    if (level >= SIMD_AVX2)
+        run128(decrypt128_avx2, 2, blocks, n, rk, Rounds);
+    else
+        run128(decrypt128_ssse3, 1, blocks, n, rk, Rounds);
+#endif
+}
+
+void
+simd_encrypt(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds)
+{
+    crypt64(simd_detect(), 0, blocks, n, subkey, Rounds);
+}
+
+void
+simd_decrypt(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds)
+{
+    crypt64(simd_detect(), 1, blocks, n, subkey, Rounds);
+}
+
+void
+simd_encrypt128(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds)
+{
+    crypt128(simd_detect(), 0, blocks, n, subkey, Rounds);
+}
+
+void
+simd_decrypt128(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds)
+{
+    crypt128(simd_detect(), 1, blocks, n, subkey, Rounds);
+}
+
+//----------------------------------
+// Self-test
+//----------------------------------
+#define TEST_BLOCKS 37 // odd, so the padded tail is exercised as well
+#define TEST_KEYS 5
+
+static uint64_t
+test_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// One block in place, encrypt() or encrypt128_block() as a mode uses it
+static void
+mode_block(uint64_t*                 x,
+           _Bool                     BlockSize64,
+           uint64_t*                 subkey,
+           const struct Block128Key* bk,
+           uint16_t                  Rounds)
+{
+    if (BlockSize64) {
+        x[0] = encrypt(x[0], subkey, Rounds, 0);
+    } else {
+        struct Block128 block = { x[0], x[1] };
+
+        encrypt128_block(&block, bk);
+        x[0] = block.Low;
+        x[1] = block.High;
+    }
+}
+
+int
+simd_selftest(_Bool Output)
+{
+    static const char* const Names[] = { "scalar", "SSSE3", "AVX2", "AVX-512" };
+    static const uint16_t    Rounds64[]  = { 1, 2, 3, 4, 28, 29, 47 };
+    static const uint16_t    Rounds128[] = { 1, 2, 3, 39, 40 };
+
+    uint64_t rng    = 0x0123456789abcdef;
+    int      errors = 0;
+    int      level, r;
+    size_t   i;
+
+    for (level = SIMD_SCALAR; level <= (int)simd_detect(); level++) {
+        int failed = 0;
+
+        for (r = 0; r < (int)(sizeof(Rounds64) / sizeof(*Rounds64)); r++) {
+            uint16_t           Rounds = Rounds64[r];
+            struct KeySchedule ks;
+            uint64_t*          subkey = ks.Subkey;
+            uint64_t           blocks[TEST_BLOCKS], plain[TEST_BLOCKS];
+
+            key_schedule_init(
+              &ks, test_random(&rng), test_random(&rng), Rounds, 0);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                plain[i] = blocks[i] = test_random(&rng);
+            }
+            crypt64(level, 0, blocks, TEST_BLOCKS, subkey, Rounds);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                failed += blocks[i] != encrypt(plain[i], subkey, Rounds, 0);
+            }
+            memcpy(blocks, plain, sizeof(blocks));
+            crypt64(level, 1, blocks, TEST_BLOCKS, subkey, Rounds);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                failed += blocks[i] != decrypt(plain[i], subkey, Rounds, 0);
+            }
+        }
+
+        for (r = 0; r < (int)(sizeof(Rounds128) / sizeof(*Rounds128)); r++) {
+            uint16_t           Rounds = Rounds128[r];
+            struct KeySchedule ks;
+            struct Block128Key bk;
+            uint64_t*          subkey = ks.Subkey;
+            uint64_t           blocks[2 * TEST_BLOCKS], plain[2 * TEST_BLOCKS];
+
+            // encrypt128() always uses 40 rounds of keys
+            key_schedule128_init(
+              &ks, test_random(&rng), test_random(&rng), GIFT128_ROUNDS);
+            block128_key(&bk, subkey, Rounds);
+            for (i = 0; i < 2 * TEST_BLOCKS; i++) {
+                plain[i] = blocks[i] = test_random(&rng);
+            }
+            crypt128(level, 0, blocks, TEST_BLOCKS, subkey, Rounds);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                struct Block128 ref = { plain[2 * i], plain[2 * i + 1] };
+
+                encrypt128_block(&ref, &bk);
+                failed +=
+                  blocks[2 * i] != ref.Low || blocks[2 * i + 1] != ref.High;
+            }
+            memcpy(blocks, plain, sizeof(blocks));
+            crypt128(level, 1, blocks, TEST_BLOCKS, subkey, Rounds);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                struct Block128 ref = { plain[2 * i], plain[2 * i + 1] };
+
+                decrypt128_block(&ref, &bk);
+                failed +=
+                  blocks[2 * i] != ref.Low || blocks[2 * i + 1] != ref.High;
+            }
+        }
+
+        // The multi-block core of slice128.c against its one-block version
+        for (r = 0; r < (int)(sizeof(Rounds128) / sizeof(*Rounds128)); r++) {
+            uint16_t Rounds = Rounds128[r];
+            uint32_t rk[GIFT128_ROUNDS][4];
+            uint32_t S[TEST_BLOCKS][4], plain[TEST_BLOCKS][4];
+
+            for (i = 0; i < 4 * GIFT128_ROUNDS; i++) {
+                rk[i / 4][i % 4] = (uint32_t)test_random(&rng);
+            }
+            for (i = 0; i < 4 * TEST_BLOCKS; i++) {
+                plain[i / 4][i % 4] = S[i / 4][i % 4] =
+                  (uint32_t)test_random(&rng);
+            }
+            slice128_encrypt_lanes(level, S, TEST_BLOCKS, rk, Rounds);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                slice128_encrypt(plain[i], rk, Rounds);
+                failed += memcmp(S[i], plain[i], sizeof(*S)) != 0;
+            }
+        }
+
+        if (Output)
+            printf("%-8s %s (%d mismatches)\n",
+                   Names[level],
+                   failed ? "FAILED" : "passed",
+                   failed);
+        errors += failed;
+    }
+
+    // The table-driven code of crypto.c against the bit loops
+    {
+        int failed = 0;
+
+        table_init();
+        for (r = 0; r < (int)(sizeof(Rounds64) / sizeof(*Rounds64)); r++) {
+            uint16_t           Rounds = Rounds64[r];
+            struct KeySchedule ks;
+            uint64_t           x;
+
+            key_schedule_init(
+              &ks, test_random(&rng), test_random(&rng), Rounds, 0);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                x = test_random(&rng);
+                failed += encrypt_table(x, ks.Subkey, Rounds, 0) !=
+                          encrypt(x, ks.Subkey, Rounds, 0);
+                failed += decrypt_table(x, ks.Subkey, Rounds, 0) !=
+                          decrypt(x, ks.Subkey, Rounds, 0);
+            }
+        }
+        if (Output)
+            printf("%-8s %s (%d mismatches)\n",
+                   "table",
+                   failed ? "FAILED" : "passed",
+                   failed);
+        errors += failed;
+    }
+
+    // The batch key schedule against one key at a time
+    {
+        int failed = 0;
+
+        for (r = 0; r < (int)(sizeof(Rounds64) / sizeof(*Rounds64)); r++) {
+            uint16_t           Rounds = Rounds64[r];
+            struct KeySchedule batch[TEST_KEYS], one;
+            uint64_t           high[TEST_KEYS], low[TEST_KEYS];
+            int                b64;
+
+            for (i = 0; i < TEST_KEYS; i++) {
+                high[i] = test_random(&rng);
+                low[i]  = test_random(&rng);
+            }
+            for (b64 = 0; b64 < 2; b64++) {
+                key_schedule_batch(batch, high, low, TEST_KEYS, Rounds, b64);
+                for (i = 0; i < TEST_KEYS; i++) {
+                    if (b64)
+                        key_schedule_init(&one, high[i], low[i], Rounds, 0);
+                    else
+                        key_schedule128_init(&one, high[i], low[i], Rounds);
+                    failed += batch[i].Rounds != one.Rounds ||
+                              memcmp(batch[i].Subkey,
+                                     one.Subkey,
+                                     (b64 ? 1 : 2) * Rounds * sizeof(uint64_t));
+                }
+            }
+        }
+        if (Output)
+            printf("%-8s %s (%d mismatches)\n",
+                   "schedule",
+                   failed ? "FAILED" : "passed",
+                   failed);
+        errors += failed;
+    }
+
+    // The 64-block bitsliced code of bitslice.c against the bit loops
+    {
+        int failed = 0;
+
+        for (r = 0; r < (int)(sizeof(Rounds64) / sizeof(*Rounds64)); r++) {
+            uint16_t           Rounds = Rounds64[r];
+            struct KeySchedule ks;
+            uint64_t           blocks[BS_LANES], plain[BS_LANES];
+
+            key_schedule_init(
+              &ks, test_random(&rng), test_random(&rng), Rounds, 0);
+            for (i = 0; i < BS_LANES; i++) {
+                plain[i] = blocks[i] = test_random(&rng);
+            }
+            encrypt_bitslice(blocks, ks.Subkey, Rounds);
+            for (i = 0; i < BS_LANES; i++) {
+                failed += blocks[i] != encrypt(plain[i], ks.Subkey, Rounds, 0);
+            }
+            memcpy(blocks, plain, sizeof(blocks));
+            decrypt_bitslice(blocks, ks.Subkey, Rounds);
+            for (i = 0; i < BS_LANES; i++) {
+                failed += blocks[i] != decrypt(plain[i], ks.Subkey, Rounds, 0);
+            }
+        }
+        if (Output)
+            printf("%-8s %s (%d mismatches)\n",
+                   "bitslice",
+                   failed ? "FAILED" : "passed",
+                   failed);
+        errors += failed;
+    }
+
+    // The key-sliced code against one key at a time, for 1 to 64 keys
+    {
+        int    failed = 0;
+        size_t n;
+
+        for (n = 1; n <= BS_LANES; n++) {
+            struct KeySchedule each[BS_LANES];
+            struct KeySlice    ks;
+            uint16_t           Rounds;
+            uint64_t           high[BS_LANES], low[BS_LANES];
+            uint64_t           blocks[BS_LANES], plain[BS_LANES];
+
+            Rounds = Rounds64[n % (sizeof(Rounds64) / sizeof(*Rounds64))];
+            for (i = 0; i < BS_LANES; i++) {
+                high[i]  = test_random(&rng);
+                low[i]   = test_random(&rng);
+                plain[i] = blocks[i] = test_random(&rng);
+            }
+            keyslice_init(&ks, high, low, n, Rounds);
+            key_schedule_batch(each, high, low, n, Rounds, 1);
+            encrypt_keysliced(blocks, &ks);
+            for (i = 0; i < n; i++) {
+                failed +=
+                  blocks[i] != encrypt(plain[i], each[i].Subkey, Rounds, 0);
+            }
+            memcpy(blocks, plain, sizeof(blocks));
+            decrypt_keysliced(blocks, &ks);
+            for (i = 0; i < n; i++) {
+                failed +=
+                  blocks[i] != decrypt(plain[i], each[i].Subkey, Rounds, 0);
+            }
+        }
+        if (Output)
+            printf("%-8s %s (%d mismatches)\n",
+                   "keyslice",
+                   failed ? "FAILED" : "passed",
+                   failed);
+        errors += failed;
+    }
+
+    // The modes of modes.c: known answers of ECB and CTR under the key
+    // 000102030405060708090a0b0c0d0e0f, then every mode against the chaining
+    // done by hand on the block functions, and back
+    {
+        static const uint64_t Ecb64[2]  = { 0x0123456789abcdef,
+                                            0x445ab945cdb74f2a };
+        static const uint64_t Ctr64[2]  = { 0x6902b7db1044f2dd,
+                                            0xfee2f1db04e6121f };
+        static const uint64_t Ctr128[4] = { 0xbbb309e2c6edffd3,
+                                            0xbdaffff4a3e7ae64,
+                                            0x9eea956bc9989ae3,
+                                            0x429f992a002886b0 };
+        struct ModeKey        mk;
+        uint64_t              buf[2 * TEST_BLOCKS], plain[2 * TEST_BLOCKS];
+        uint64_t              ref[2 * TEST_BLOCKS], iv[2], chain[2];
+        int                   failed = 0, b64, w;
+        size_t                words, bytes, half;
+
+        mode_key_init(&mk, 0x0001020304050607, 0x08090a0b0c0d0e0f, 29, 1);
+        buf[0] = Ecb64[0];
+        ecb_encrypt(&mk, buf, 1);
+        failed += buf[0] != Ecb64[1];
+        buf[0] = buf[1] = iv[0] = 0;
+        ctr_crypt(&mk, iv, buf, 2);
+        failed += buf[0] != Ctr64[0] || buf[1] != Ctr64[1] || iv[0] != 2;
+
+        mode_key_init(&mk, 0x0001020304050607, 0x08090a0b0c0d0e0f, 40, 0);
+        memset(buf, 0, 4 * sizeof(uint64_t));
+        iv[0] = iv[1] = 0;
+        ctr_crypt(&mk, iv, buf, 2);
+        failed += memcmp(buf, Ctr128, sizeof(Ctr128)) != 0 || iv[0] != 2;
+
+        for (b64 = 0; b64 < 2; b64++) {
+            struct KeySchedule ks;
+            struct Block128Key bk;
+            uint16_t           Rounds = b64 ? 29 : GIFT128_ROUNDS;
+            uint64_t           high   = test_random(&rng);
+            uint64_t           low    = test_random(&rng);
+
+            words = b64 ? 1 : 2;
+            bytes = words * TEST_BLOCKS * sizeof(uint64_t);
+            half  = TEST_BLOCKS / 2;
+            mode_key_init(&mk, high, low, Rounds, b64);
+            if (b64) {
+                key_schedule_init(&ks, high, low, Rounds, 0);
+            } else {
+                key_schedule128_init(&ks, high, low, Rounds);
+                block128_key(&bk, ks.Subkey, Rounds);
+            }
+            for (i = 0; i < words * TEST_BLOCKS; i++) {
+                plain[i] = test_random(&rng);
+            }
+
+            // ECB
+            memcpy(buf, plain, sizeof(buf));
+            memcpy(ref, plain, sizeof(ref));
+            ecb_encrypt(&mk, buf, TEST_BLOCKS);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                mode_block(ref + words * i, b64, ks.Subkey, &bk, Rounds);
+            }
+            failed += memcmp(buf, ref, bytes) != 0;
+            ecb_decrypt(&mk, buf, TEST_BLOCKS);
+            failed += memcmp(buf, plain, bytes) != 0;
+
+            // CBC, decrypted in two calls that carry the chain in iv
+            chain[0] = iv[0] = test_random(&rng);
+            chain[1] = iv[1] = test_random(&rng);
+            memcpy(buf, plain, sizeof(buf));
+            memcpy(ref, plain, sizeof(ref));
+            cbc_encrypt(&mk, iv, buf, TEST_BLOCKS);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                for (w = 0; w < (int)words; w++) {
+                    ref[words * i + w] ^= i ? ref[words * (i - 1) + w]
+                                            : chain[w];
+                }
+                mode_block(ref + words * i, b64, ks.Subkey, &bk, Rounds);
+            }
+            failed += memcmp(buf, ref, bytes) != 0;
+            for (w = 0; w < (int)words; w++) {
+                failed += iv[w] != ref[words * (TEST_BLOCKS - 1) + w];
+            }
+            memcpy(iv, chain, sizeof(chain));
+            cbc_decrypt(&mk, iv, buf, half);
+            cbc_decrypt(&mk, iv, buf + words * half, TEST_BLOCKS - half);
+            failed += memcmp(buf, plain, bytes) != 0;
+
+            // CTR, with a counter about to carry into the high word
+            chain[0] = iv[0] = UINT64_MAX - 3;
+            chain[1] = iv[1] = test_random(&rng);
+            memcpy(buf, plain, sizeof(buf));
+            ctr_crypt(&mk, iv, buf, TEST_BLOCKS);
+            for (i = 0; i < TEST_BLOCKS; i++) {
+                ref[words * i] = chain[0] + i;
+                if (!b64)
+                    ref[2 * i + 1] = chain[1] + (chain[0] + i < chain[0]);
+                mode_block(ref + words * i, b64, ks.Subkey, &bk, Rounds);
+                for (w = 0; w < (int)words; w++) {
+                    failed += buf[words * i + w] !=
+                              (plain[words * i + w] ^ ref[words * i + w]);
+                }
+            }
+            memcpy(iv, chain, sizeof(chain));
+            ctr_crypt(&mk, iv, buf, half);
+            ctr_crypt(&mk, iv, buf + words * half, TEST_BLOCKS - half);
+            failed += memcmp(buf, plain, bytes) != 0;
+        }
+        if (Output)
+            printf("%-8s %s (%d mismatches)\n",
+                   "modes",
+                   failed ? "FAILED" : "passed",
+                   failed);
+        errors += failed;
+    }
+    return errors;
+}
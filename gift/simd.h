@@ -0,0 +1,57 @@
+/**
+ * SSSE3/AVX2 kernels for GIFT-64 and GIFT-128 on many blocks
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * Inside the kernels each nibble of a block sits in its own byte, so the
+ * S-Layer is a single byte shuffle with Sbox (or SboxInv) as the table. The
+ * P-Layer keeps bit b of every nibble at bit b, which makes it one byte
+ * shuffle per bit position followed by a mask. Blocks are converted to and
+ * from that layout on load and store. GIFT-128 encryption is the exception:
+ * it goes through the multi-block bitsliced core of slice128.c, which is
+ * several times faster and also has an AVX-512 kernel.
+ *
+ * The kernel is picked at runtime from what the CPU supports, with a scalar
+ * fallback on top of fixslice.c and crypto.c. All functions return the same
+ * results as encrypt(), decrypt(), encrypt128() and decrypt128() for the same
+ * subkeys; like encrypt128(), the GIFT-128 encryption always runs 40 rounds.
+ *
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+enum SimdLevel
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSSE3  = 1,
+    SIMD_AVX2   = 2,
+    SIMD_AVX512 = 3 // AVX-512F and BW, only used by slice128.c
+};
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+enum SimdLevel
+simd_detect(void);
+
+// GIFT-64: one word per block, encrypted in place
+void
+simd_encrypt(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds);
+
+void
+simd_decrypt(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds);
+
+// GIFT-128: two words per block, low word first (as returned by encrypt128)
+void
+simd_encrypt128(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds);
+
+void
+simd_decrypt128(uint64_t* blocks, size_t n, uint64_t* subkey, uint16_t Rounds);
+
+// Compares every kernel the CPU supports, the table-driven functions and the
+// batch key schedule of crypto.h and the bitsliced functions of bitslice.h
+// against the reference functions. Returns the number of mismatches.
+int
+simd_selftest(_Bool Output);
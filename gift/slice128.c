@@ -0,0 +1,364 @@
+/**
+ * Bitsliced GIFT-128 core shared by giftb128() and encrypt128()
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include "slice128.h"
+#include "bitslice.h"
+#include "fixslice.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SLICE128_X86
+#endif
+
+#define MAX_LANES 16
+
+//----------------------------------
+// Macros for slice manipulation
+//----------------------------------
+#define DELTA_SWAP(x, mask, shift)                                             \
+    do {                                                                       \
+        uint32_t t_ = ((x) ^ ((x) >> (shift))) & (mask);                       \
+        (x) ^= t_ ^ (t_ << (shift));                                           \
+    } while (0)
+
+#define ROL32(x, n) ((n) ? ((x) << (n)) | ((x) >> (32 - (n))) : (x))
+#define ROR32(x, n) ((n) ? ((x) >> (n)) | ((x) << (32 - (n))) : (x))
+
+// Bit 4 * b + j of a slice moves to bit 8 * j + b: the five bits of the bit
+// index rotate left by three, done as four swaps of index bits
+static uint32_t
+transpose8x4(uint32_t x)
+{
+    DELTA_SWAP(x, 0x22222222, 1);
+    DELTA_SWAP(x, 0x0A0A0A0A, 3);
+    DELTA_SWAP(x, 0x00CC00CC, 6);
+    DELTA_SWAP(x, 0x0000F0F0, 12);
+    return x;
+}
+
+static uint32_t
+transpose8x4_inv(uint32_t x)
+{
+    DELTA_SWAP(x, 0x0000F0F0, 12);
+    DELTA_SWAP(x, 0x00CC00CC, 6);
+    DELTA_SWAP(x, 0x0A0A0A0A, 3);
+    DELTA_SWAP(x, 0x22222222, 1);
+    return x;
+}
+
+// rowperm() of gift128.c for slice c sends row j of the transposed slice to
+// row (c - j) mod 4, which is a byte swap followed by a rotation
+#define PERM_SLICE(x, c)                                                       \
+    ROL32(__builtin_bswap32(transpose8x4(x)), 8 * (((c) + 1) % 4))
+#define PERM_SLICE_INV(x, c)                                                   \
+    transpose8x4_inv(__builtin_bswap32(ROR32((x), 8 * (((c) + 1) % 4))))
+
+//----------------------------------
+// Layout conversion
+//----------------------------------
+#ifdef SLICE128_X86
+#define NIBBLE_BITS 0x1111111111111111
+
+// pext/pdep move bit b of every nibble in one instruction. They are
+// microcoded and much slower than the shifts on AMD before Zen 3. The cycle128
+// workers pack from many threads, so the check runs once under pthread_once().
+static pthread_once_t Bmi2Once = PTHREAD_ONCE_INIT;
+static _Bool          Bmi2;
+
+static void
+bmi2_init(void)
+{
+    __builtin_cpu_init();
+    Bmi2 = __builtin_cpu_supports("bmi2") && !__builtin_cpu_is("znver1") &&
+           !__builtin_cpu_is("znver2");
+}
+
+static _Bool
+use_bmi2(void)
+{
+    pthread_once(&Bmi2Once, bmi2_init);
+    return Bmi2;
+}
+
+__attribute__((target("bmi2"))) static void
+pack_bmi2(uint32_t S[4], uint64_t high, uint64_t low)
+{
+    int b;
+
+    for (b = 0; b < 4; b++) {
+        S[b] = ((uint32_t)_pext_u64(high, NIBBLE_BITS << b) << 16) |
+               (uint32_t)_pext_u64(low, NIBBLE_BITS << b);
+    }
+}
+
+__attribute__((target("bmi2"))) static void
+unpack_bmi2(const uint32_t S[4], uint64_t* high, uint64_t* low)
+{
+    uint64_t h = 0, l = 0;
+    int      b;
+
+    for (b = 0; b < 4; b++) {
+        h |= _pdep_u64(S[b] >> 16, NIBBLE_BITS << b);
+        l |= _pdep_u64(S[b] & 0xFFFF, NIBBLE_BITS << b);
+    }
+    *high = h;
+    *low  = l;
+}
+#endif // SLICE128_X86
+
+// Otherwise fixslice_pack() gathers bit b of the 16 nibbles of a word into
+// bits 16 * b to 16 * b + 15
+void
+slice128_pack(uint32_t S[4], uint64_t high, uint64_t low)
+{
+    uint64_t h, l;
+    int      b;
+
+#ifdef SLICE128_X86
+    if (use_bmi2()) {
+        pack_bmi2(S, high, low);
+        return;
+    }
+#endif
+    h = fixslice_pack(high);
+    l = fixslice_pack(low);
+    for (b = 0; b < 4; b++) {
+        S[b] = ((uint32_t)(h >> (16 * b)) << 16) | ((l >> (16 * b)) & 0xFFFF);
+    }
+}
+
+void
+slice128_unpack(const uint32_t S[4], uint64_t* high, uint64_t* low)
+{
+    uint64_t h = 0, l = 0;
+    int      b;
+
+#ifdef SLICE128_X86
+    if (use_bmi2()) {
+        unpack_bmi2(S, high, low);
+        return;
+    }
+#endif
+    for (b = 0; b < 4; b++) {
+        h |= (uint64_t)(S[b] >> 16) << (16 * b);
+        l |= (uint64_t)(S[b] & 0xFFFF) << (16 * b);
+    }
+    *high = fixslice_unpack(h);
+    *low  = fixslice_unpack(l);
+}
+
+// Big endian words, as giftb128() reads its bytes
+void
+slice128_load(uint32_t S[4], const uint8_t bytes[16])
+{
+    int b;
+
+    for (b = 0; b < 4; b++) {
+        S[b] = ((uint32_t)bytes[4 * b] << 24) |
+               ((uint32_t)bytes[4 * b + 1] << 16) |
+               ((uint32_t)bytes[4 * b + 2] << 8) | (uint32_t)bytes[4 * b + 3];
+    }
+}
+
+void
+slice128_store(uint8_t bytes[16], const uint32_t S[4])
+{
+    int b;
+
+    for (b = 0; b < 4; b++) {
+        bytes[4 * b]     = S[b] >> 24;
+        bytes[4 * b + 1] = S[b] >> 16;
+        bytes[4 * b + 2] = S[b] >> 8;
+        bytes[4 * b + 3] = S[b];
+    }
+}
+
+void
+slice128_key(uint32_t rk[4], uint64_t keyHigh, uint64_t keyLow)
+{
+    slice128_pack(rk, keyHigh, keyLow);
+}
+
+//----------------------------------
+// Encryption
+//----------------------------------
+void
+slice128_encrypt(uint32_t S[4], uint32_t rk[][4], uint16_t Rounds)
+{
+    uint16_t RoundNr;
+    uint32_t s0 = S[0], s1 = S[1], s2 = S[2], s3 = S[3];
+
+    for (RoundNr = 0; RoundNr < Rounds; RoundNr++) {
+        BS_SBOX(s0, s1, s2, s3);
+
+        // The S-Box leaves slice 0 in s3 and slice 3 in s0
+        s3 = PERM_SLICE(s3, 0);
+        s1 = PERM_SLICE(s1, 1);
+        s2 = PERM_SLICE(s2, 2);
+        s0 = PERM_SLICE(s0, 3);
+
+        s3 ^= rk[RoundNr][0];
+        s1 ^= rk[RoundNr][1];
+        s2 ^= rk[RoundNr][2];
+        s0 ^= rk[RoundNr][3];
+
+        // Back to slice order, by renaming: s3 becomes s0 and s0 s3
+        {
+            uint32_t t = s0;
+            s0         = s3;
+            s3         = t;
+        }
+    }
+
+    S[0] = s0;
+    S[1] = s1;
+    S[2] = s2;
+    S[3] = s3;
+}
+
+//----------------------------------
+// Decryption
+//----------------------------------
+void
+slice128_decrypt(uint32_t S[4], uint32_t rk[][4], uint16_t Rounds)
+{
+    uint16_t RoundNr;
+    uint32_t s0 = S[0], s1 = S[1], s2 = S[2], s3 = S[3];
+
+    for (RoundNr = Rounds; RoundNr-- > 0;) {
+        s0 = PERM_SLICE_INV(s0 ^ rk[RoundNr][0], 0);
+        s1 = PERM_SLICE_INV(s1 ^ rk[RoundNr][1], 1);
+        s2 = PERM_SLICE_INV(s2 ^ rk[RoundNr][2], 2);
+        s3 = PERM_SLICE_INV(s3 ^ rk[RoundNr][3], 3);
+
+        // BS_SBOX_INV also leaves slice 0 in s3 and slice 3 in s0
+        BS_SBOX_INV(s0, s1, s2, s3);
+        {
+            uint32_t t = s0;
+            s0         = s3;
+            s3         = t;
+        }
+    }
+
+    S[0] = s0;
+    S[1] = s1;
+    S[2] = s2;
+    S[3] = s3;
+}
+
+//----------------------------------
+// Multi-block encryption
+//----------------------------------
+#ifdef SLICE128_X86
+// Byte shuffles of PERM_SLICE() for slices 0 to 3, for four words
+#define BYTE_ROW(a, b, c, d)                                                   \
+    a, b, c, d, a + 4, b + 4, c + 4, d + 4, a + 8, b + 8, c + 8, d + 8,        \
+      a + 12, b + 12, c + 12, d + 12
+static const uint8_t PermBytes[4][16] __attribute__((aligned(16))) = {
+    { BYTE_ROW(0, 3, 2, 1) },
+    { BYTE_ROW(1, 0, 3, 2) },
+    { BYTE_ROW(2, 1, 0, 3) },
+    { BYTE_ROW(3, 2, 1, 0) },
+};
+
+#define LANES 4
+#define VEC __m128i
+#define TARGET __attribute__((target("ssse3")))
+#define KERNEL encrypt_lanes_ssse3
+#define VSHL(x, n) _mm_slli_epi32((x), (n))
+#define VSHR(x, n) _mm_srli_epi32((x), (n))
+#define VSHUF(x, t) _mm_shuffle_epi8((x), (t))
+#define VSET1(w) _mm_set1_epi32((int)(w))
+#define VLOAD(p) _mm_load_si128((const __m128i*)(p))
+#define VSTORE(p, x) _mm_store_si128((__m128i*)(p), (x))
+#define VTABLE(p) _mm_load_si128((const __m128i*)(p))
+#include "slice128_lanes.inc"
+
+#define LANES 8
+#define VEC __m256i
+#define TARGET __attribute__((target("avx2")))
+#define KERNEL encrypt_lanes_avx2
+#define VSHL(x, n) _mm256_slli_epi32((x), (n))
+#define VSHR(x, n) _mm256_srli_epi32((x), (n))
+#define VSHUF(x, t) _mm256_shuffle_epi8((x), (t))
+#define VSET1(w) _mm256_set1_epi32((int)(w))
+#define VLOAD(p) _mm256_load_si256((const __m256i*)(p))
+#define VSTORE(p, x) _mm256_store_si256((__m256i*)(p), (x))
+#define VTABLE(p)                                                              \
+    _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)(p)))
+#include "slice128_lanes.inc"
+
+#define LANES 16
+#define VEC __m512i
+#define TARGET __attribute__((target("avx512f,avx512bw")))
+#define KERNEL encrypt_lanes_avx512
+#define VSHL(x, n) _mm512_slli_epi32((x), (n))
+#define VSHR(x, n) _mm512_srli_epi32((x), (n))
+#define VSHUF(x, t) _mm512_shuffle_epi8((x), (t))
+#define VSET1(w) _mm512_set1_epi32((int)(w))
+#define VLOAD(p) _mm512_load_si512((const void*)(p))
+#define VSTORE(p, x) _mm512_store_si512((void*)(p), (x))
+#define VTABLE(p) _mm512_broadcast_i32x4(_mm_load_si128((const __m128i*)(p)))
+#include "slice128_lanes.inc"
+#endif // SLICE128_X86
+
+typedef void (*LaneKernel)(uint32_t (*)[4], uint32_t (*)[4], uint16_t);
+
+void
+slice128_encrypt_lanes(enum SimdLevel level,
+                       uint32_t       S[][4],
+                       size_t         n,
+                       uint32_t       rk[][4],
+                       uint16_t       Rounds)
+{
+    LaneKernel kernel = NULL;
+    size_t     lanes  = 1;
+    size_t     i;
+
+#ifdef SLICE128_X86
+    if (level >= SIMD_AVX512) {
+        kernel = encrypt_lanes_avx512;
+        lanes  = 16;
+    } else if (level == SIMD_AVX2) {
+        kernel = encrypt_lanes_avx2;
+        lanes  = 8;
+    } else if (level == SIMD_SSSE3) {
+        kernel = encrypt_lanes_ssse3;
+        lanes  = 4;
+    }
+#endif
+    if (kernel == NULL) {
+        for (i = 0; i < n; i++) {
+            slice128_encrypt(S[i], rk, Rounds);
+        }
+        return;
+    }
+
+    for (i = 0; i + lanes <= n; i += lanes) {
+        kernel(S + i, rk, Rounds);
+    }
+    // The tail goes through a zero padded copy
+    if (i < n) {
+        uint32_t tail[MAX_LANES][4] = { { 0 } };
+
+        memcpy(tail, S + i, (n - i) * sizeof(*S));
+        kernel(tail, rk, Rounds);
+        memcpy(S + i, tail, (n - i) * sizeof(*S));
+    }
+}
+
+void
+slice128_encrypt_blocks(uint32_t S[][4],
+                        size_t   n,
+                        uint32_t rk[][4],
+                        uint16_t Rounds)
+{
+    slice128_encrypt_lanes(simd_detect(), S, n, rk, Rounds);
+}
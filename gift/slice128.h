@@ -0,0 +1,70 @@
+/**
+ * Bitsliced GIFT-128 core shared by giftb128() and encrypt128()
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * The state is four 32-bit slices as in giftb128(): bit N of S[b] is bit b
+ * of nibble N, where nibbles 0-15 are the low word and 16-31 the high word
+ * of encrypt128(). The S-Box is a handful of boolean operations on the
+ * slices. On each slice the P-Box is a transpose of the 8x4 bit matrix
+ * followed by a byte permutation, so neither direction needs a per-bit loop.
+ * Packing and unpacking use pext/pdep on CPUs with fast BMI2, and a network
+ * of shifts and masks otherwise.
+ *
+ * Round keys are given as four slices per round, with the round constants
+ * already included.
+ *
+ * slice128_encrypt_blocks() runs the same rounds on many blocks at once, one
+ * block per 32-bit lane of SSSE3, AVX2 or AVX-512 vectors (4, 8 or 16 blocks
+ * per pass) as picked at runtime, or one block at a time without them.
+ *
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include "simd.h"
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+void
+slice128_pack(uint32_t S[4], uint64_t high, uint64_t low);
+
+void
+slice128_unpack(const uint32_t S[4], uint64_t* high, uint64_t* low);
+
+// The byte order of giftb128(): slice b is bytes 4 * b to 4 * b + 3
+void
+slice128_load(uint32_t S[4], const uint8_t bytes[16]);
+
+void
+slice128_store(uint8_t bytes[16], const uint32_t S[4]);
+
+// A subkey pair of key_schedule128() as slices
+void
+slice128_key(uint32_t rk[4], uint64_t keyHigh, uint64_t keyLow);
+
+// Rounds times S-Box, P-Box and round key rk[r]
+void
+slice128_encrypt(uint32_t S[4], uint32_t rk[][4], uint16_t Rounds);
+
+// The exact inverse of slice128_encrypt() with the same keys
+void
+slice128_decrypt(uint32_t S[4], uint32_t rk[][4], uint16_t Rounds);
+
+// slice128_encrypt() on n blocks S[i] with the same round keys
+void
+slice128_encrypt_blocks(uint32_t S[][4],
+                        size_t   n,
+                        uint32_t rk[][4],
+                        uint16_t Rounds);
+
+// The same with a given kernel, which has to be supported by the CPU
+void
+slice128_encrypt_lanes(enum SimdLevel level,
+                       uint32_t       S[][4],
+                       size_t         n,
+                       uint32_t       rk[][4],
+                       uint16_t       Rounds);
@@ -16,18 +16,718 @@
  * Tested with gcc (with Option -std=c99)
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 //----------------------------------
 // Includes
 //----------------------------------
 #include <getopt.h>
 #include <inttypes.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h> //Standard C headers...
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bidir.h"     // Bidirectional cycle walks
+#include "bscycle.h"   // Bitsliced cycle walks
+#include "comline.h"   // Command Line
+#include "crypto.h"    // GIFT-64 and GIFT-128 reference code
+#include "cycle.h"     // Parallel cycle search
+#include "cycle128.h"  // GIFT-128 cycle walks
+#include "decompose.h" // Cycles of scaled-down GIFT
+#include "dpstore.h"   // Store of known cycles
+#include "fixslice.h"  // Unrolled GIFT-64
+#include "gift128.h"   // Crypto functions
+#include "hunt.h"      // Short cycles in a subspace
+#include "verbose.h"   // For verbose output
+#include "walk.h"      // Walk kernels
+
+//----------------------------------
+// Self-test of the cycle tools
+//----------------------------------
+// Run with -s. Every check compares a module of giftCycle with a plain loop
+// at parameters small enough to finish in seconds, and prints one line.
+
+// xorshift, as in the self-test of simd.c
+static uint64_t
+test_random(uint64_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int
+test_report(const char* name, int failed)
+{
+    printf("%-10s %s (%d mismatches)\n",
+           name,
+           failed ? "FAILED" : "passed",
+           failed);
+    return failed;
+}
+
+// The cycle length histogram of GIFT cut to 16 bits, against walking every
+// value once
+static int
+check_decompose(void)
+{
+    static const uint16_t  Rounds[] = { 1, 2, 5, 29 };
+    static uint8_t         seen[1 << 16];
+    static uint64_t        count[(1 << 16) + 1];
+    struct KeySchedule     ks;
+    struct SmallGift       sg;
+    struct DecomposeConfig cfg;
+    struct Decomposition   result;
+    uint64_t               rng = 0x0123456789abcdef, x, y, n, i;
+    int                    failed = 0, r, d;
+
+    for (r = 0; r < (int)(sizeof(Rounds) / sizeof(*Rounds)); r++) {
+        for (d = 0; d < 2; d++) {
+            key_schedule_init(
+              &ks, test_random(&rng), test_random(&rng), Rounds[r], 0);
+            small_gift_init(&sg, 16, ks.Subkey, Rounds[r], d);
+
+            memset(seen, 0, sizeof(seen));
+            memset(count, 0, sizeof(count));
+            for (x = 0; x < (1 << 16); x++) {
+                if (seen[x])
+                    continue;
+                n = 0;
+                y = x;
+                do {
+                    seen[y] = 1;
+                    y       = small_gift(&sg, y);
+                    n++;
+                } while (y != x);
+                count[n]++;
+            }
+
+            cfg.Cipher        = &sg;
+            cfg.Threads       = 2;
+            cfg.ProgressEvery = 0;
+            if (decompose(&cfg, &result) != 0) {
+                failed++;
+                continue;
+            }
+            for (i = 0; i < result.Lengths; i++) {
+                n = result.Histogram[i].Length;
+                failed +=
+                  n > (1 << 16) || count[n] != result.Histogram[i].Count;
+                if (n <= (1 << 16))
+                    count[n] = 0;
+            }
+            for (n = 0; n <= (1 << 16); n++) {
+                failed += count[n] != 0;
+            }
+            decomposition_free(&result);
+        }
+    }
+    return test_report("decompose", failed);
+}
+
+// The hits of hunt() against iterating encrypt() from every candidate
+static int
+check_hunt(void)
+{
+    static const uint64_t Free[] = { 0xFFF, 0x0F0F, 0x8000000000000007, 0x1 };
+    struct KeySchedule    ks;
+    struct BsWalkKey      wk;
+    struct HuntConfig     cfg;
+    struct HuntResult     result;
+    uint64_t              rng = 0xfedcba9876543210, x, y, n, k, hit;
+    int                   failed = 0, f;
+    uint16_t              Rounds;
+
+    for (Rounds = 1; Rounds <= 3; Rounds++) {
+        for (f = 0; f < (int)(sizeof(Free) / sizeof(*Free)); f++) {
+            key_schedule_init(
+              &ks, test_random(&rng), test_random(&rng), Rounds, 0);
+            bs_walk_key(&wk, ks.Subkey, Rounds, 0);
+            cfg.Key           = &wk;
+            cfg.Base          = test_random(&rng);
+            cfg.Free          = Free[f];
+            cfg.MaxLength     = 32;
+            cfg.Threads       = 2;
+            cfg.ProgressEvery = 0;
+            if (hunt(&cfg, &result) != 0) {
+                failed++;
+                continue;
+            }
+
+            // Candidates in the order of their free bits, as the hits are
+            hit = 0;
+            n   = 0;
+            do {
+                x = (cfg.Base & ~cfg.Free) | n;
+                y = x;
+                for (k = 1; k <= cfg.MaxLength; k++) {
+                    y = encrypt(y, ks.Subkey, Rounds, 0);
+                    if (y == x)
+                        break;
+                }
+                if (k <= cfg.MaxLength) {
+                    failed += hit >= result.Hits || result.Hit[hit].X != x ||
+                              result.Hit[hit].Length != k;
+                    hit++;
+                }
+                n = (n - cfg.Free) & cfg.Free;
+            } while (n != 0);
+            failed += hit != result.Hits;
+            hunt_free(&result);
+        }
+    }
+    return test_report("hunt", failed);
+}
+
+// The walk kernels of every round count, both ways, against stepping each
+// lane on its own with the unrolled ciphers. First single steps under the
+// empty mask, which makes every value distinguished, then walks to the first
+// distinguished point or stop value of any lane, or to the step limit. The
+// stops of all lanes but the last lie on their walks, the last one is 0, a
+// distinguished point itself. Half of the walks start on neighbouring values,
+// as the orbits of the cycle search do.
+static int
+check_walk(void)
+{
+    struct KeySchedule ks;
+    struct UnrolledKey uk;
+    struct WalkKey     wk;
+    WalkKernel         kernel;
+    UnrolledCipher     cipher;
+    uint64_t           x[WALK_LANES], y[WALK_LANES], stop[WALK_LANES];
+    uint64_t           rng = 0x0f1e2d3c4b5a6978, dpMask, limit, n, m;
+    int                failed = 0, hit, d, r, t, l;
+
+    key_schedule_init(
+      &ks, test_random(&rng), test_random(&rng), MAX_ROUNDS, 0);
+    for (r = 0; r <= MAX_ROUNDS; r++) {
+        unrolled_key(&uk, ks.Subkey, r);
+        walk_key(&wk, ks.Subkey, r);
+        for (d = 0; d < 2; d++) {
+            kernel = d ? walk_decrypt_for(r) : walk_encrypt_for(r);
+            cipher = d ? unrolled_decrypt_for(r) : unrolled_encrypt_for(r);
+
+            for (l = 0; l < WALK_LANES; l++) {
+                x[l]    = test_random(&rng);
+                stop[l] = 0;
+            }
+            for (t = 0; t < 8; t++) {
+                for (l = 0; l < WALK_LANES; l++) {
+                    y[l] = cipher(x[l], &uk);
+                }
+                failed += kernel(x, stop, 100, 0, &wk) != 1;
+                for (l = 0; l < WALK_LANES; l++) {
+                    failed += x[l] != y[l];
+                }
+            }
+
+            dpMask = ~(uint64_t)0 << 56;
+            for (t = 0; t < 16; t++) {
+                limit = t < 4 ? t + 1 : 1000;
+                for (l = 0; l < WALK_LANES; l++) {
+                    x[l]    = t & 1 ? x[0] + l : test_random(&rng);
+                    y[l]    = x[l];
+                    stop[l] = x[l];
+                    m       = test_random(&rng) % 256 + 1;
+                    for (n = 0; l < WALK_LANES - 1 && n < m; n++) {
+                        stop[l] = cipher(stop[l], &uk);
+                    }
+                }
+                stop[WALK_LANES - 1] = 0;
+
+                for (n = 0, hit = 0; !hit && n < limit; n++) {
+                    for (l = 0; l < WALK_LANES; l++) {
+                        y[l] = cipher(y[l], &uk);
+                        hit |= (y[l] & dpMask) == 0 || y[l] == stop[l];
+                    }
+                }
+                failed += kernel(x, stop, limit, dpMask, &wk) != n;
+                for (l = 0; l < WALK_LANES; l++) {
+                    failed += x[l] != y[l];
+                }
+            }
+        }
+    }
+    return test_report("walk", failed);
+}
+
+// bscycle_run() under three keys, with more orbits than lanes and a step
+// limit, against iterating encrypt() and decrypt(), and the summary of each
+// key as --sweep-rounds prints it. encrypt() makes no round of one, so there
+// every orbit of the first key closes after one step.
+static int
+check_bscycle(void)
+{
+    struct KeySchedule      ks;
+    struct BsWalkKey        wk[3];
+    struct BsCycleConfig    cfg;
+    struct BsCycleSearch    bs;
+    const struct LaneOrbit* orbit;
+    struct BsSummary        sum, want;
+    uint64_t                rng = 0x5a5a5a5aa5a5a5a5, x, y, n, i;
+    int                     failed = 0, d;
+    unsigned                k;
+
+    for (d = 0; d < 2; d++) {
+        key_schedule_init(&ks, test_random(&rng), test_random(&rng), 3, 0);
+        for (k = 0; k < 3; k++) {
+            bs_walk_key(&wk[k], ks.Subkey, k + 1, d);
+        }
+        cfg.Key           = wk;
+        cfg.Keys          = 3;
+        cfg.FirstStart    = test_random(&rng);
+        cfg.Orbits        = 200;
+        cfg.MaxSteps      = 2000;
+        cfg.Threads       = 2;
+        cfg.ProgressEvery = 0;
+        if (bscycle_init(&bs, &cfg) != 0) {
+            failed++;
+            continue;
+        }
+        bscycle_run(&bs);
+
+        for (k = 0; k < cfg.Keys; k++) {
+            memset(&want, 0, sizeof(want));
+            want.Shortest = UINT64_MAX;
+            for (i = 0; i < cfg.Orbits; i++) {
+                x = cfg.FirstStart + i;
+                y = x;
+                for (n = 1; n <= cfg.MaxSteps; n++) {
+                    y = d ? decrypt(y, ks.Subkey, k + 1, 0)
+                          : encrypt(y, ks.Subkey, k + 1, 0);
+                    if (y == x)
+                        break;
+                }
+                orbit = &bs.Orbit[k * cfg.Orbits + i];
+                failed += orbit->Closed != (n <= cfg.MaxSteps) ||
+                          orbit->Steps != (n <= cfg.MaxSteps ? n : n - 1);
+                if (d == 0 && k == 0)
+                    failed += !orbit->Closed || orbit->Steps != 1;
+
+                if (n > cfg.MaxSteps) {
+                    want.Steps += cfg.MaxSteps;
+                    continue;
+                }
+                want.Steps += n;
+                want.Closed++;
+                if (n < want.Shortest)
+                    want.Shortest = n;
+                if (n > want.Longest)
+                    want.Longest = n;
+            }
+            bscycle_summary(&bs, k, &sum);
+            failed += sum.Closed != want.Closed ||
+                      sum.Shortest != want.Shortest ||
+                      sum.Longest != want.Longest || sum.Steps != want.Steps;
+        }
+        bscycle_free(&bs);
+    }
+    return test_report("bscycle", failed);
+}
+
+// bidir_backward() undoes bidir_forward() at every round count
+static int
+check_bidir(void)
+{
+    struct KeySchedule ks;
+    struct BidirCipher bc;
+    uint64_t           rng = 0x0f1e2d3c4b5a6978, x;
+    int                failed = 0, d, i;
+    uint16_t           Rounds;
+
+    key_schedule_init(&ks, test_random(&rng), test_random(&rng), MAX_ROUNDS, 0);
+    for (Rounds = 0; Rounds <= MAX_ROUNDS; Rounds++) {
+        for (d = 0; d < 2; d++) {
+            bidir_cipher(&bc, ks.Subkey, Rounds, d);
+            for (i = 0; i < 64; i++) {
+                x = test_random(&rng);
+                failed += bidir_backward(&bc, bidir_forward(&bc, x)) != x;
+                failed += bidir_forward(&bc, x) !=
+                          (d ? decrypt(x, ks.Subkey, Rounds, 0)
+                             : encrypt(x, ks.Subkey, Rounds, 0));
+            }
+        }
+    }
+    return test_report("bidir", failed);
+}
+
+// cycle128_step() against encrypt128_block() and decrypt128_block()
+static int
+check_cycle128(void)
+{
+    static const uint16_t Rounds[] = { 1, 2, 3, 29, 40, 41 };
+    struct KeySchedule    ks;
+    struct Block128Key    bk;
+    struct Cycle128Key    key;
+    struct Block128       a, b;
+    uint64_t              rng = 0x1122334455667788;
+    int                   failed = 0, r, d, i;
+
+    for (r = 0; r < (int)(sizeof(Rounds) / sizeof(*Rounds)); r++) {
+        for (d = 0; d < 2; d++) {
+            key_schedule128_init(
+              &ks, test_random(&rng), test_random(&rng), MAX_ROUNDS);
+            cycle128_key(&key, ks.Subkey, Rounds[r], d);
+            block128_key(&bk, ks.Subkey, Rounds[r]);
+            for (i = 0; i < 16; i++) {
+                a.High = b.High = test_random(&rng);
+                a.Low = b.Low = test_random(&rng);
+                cycle128_step(&key, &a);
+                if (d)
+                    decrypt128_block(&b, &bk);
+                else
+                    encrypt128_block(&b, &bk);
+                failed += a.High != b.High || a.Low != b.Low;
+            }
+        }
+    }
+    return test_report("cycle128", failed);
+}
+
+// cycle128_run() with more orbits than lanes, starts that carry into the high
+// word and a step limit, against iterating cycle128_step(). Decryption of no
+// rounds is the identity and of one round adds the first round key, so those
+// orbits close after one and two steps. The last entry encrypts, which always
+// runs 40 rounds and takes the lanes kernel.
+static int
+check_run128(void)
+{
+    static const uint16_t   Rounds[] = { 0, 1, 2, 3, 40 };
+    struct KeySchedule      ks;
+    struct Cycle128Key      key;
+    struct Cycle128Config   cfg;
+    struct Cycle128Search   cs;
+    const struct LaneOrbit* orbit;
+    struct Block128         x, y;
+    uint64_t                rng = 0x8877665544332211, n, i;
+    int                     failed = 0, r, d;
+
+    key_schedule128_init(&ks, test_random(&rng), test_random(&rng), MAX_ROUNDS);
+    for (r = 0; r < (int)(sizeof(Rounds) / sizeof(*Rounds)); r++) {
+        d = Rounds[r] != 40;
+        cycle128_key(&key, ks.Subkey, Rounds[r], d);
+        cfg.Key             = &key;
+        cfg.FirstStart.High = test_random(&rng);
+        cfg.FirstStart.Low  = UINT64_MAX - 20;
+        cfg.Orbits          = 50;
+        cfg.MaxSteps        = d ? 500 : 50;
+        cfg.Threads         = 2;
+        cfg.ProgressEvery   = 0;
+        if (cycle128_init(&cs, &cfg) != 0) {
+            failed++;
+            continue;
+        }
+        cycle128_run(&cs);
+
+        for (i = 0; i < cfg.Orbits; i++) {
+            x.Low  = cfg.FirstStart.Low + i;
+            x.High = cfg.FirstStart.High + (x.Low < cfg.FirstStart.Low);
+            y      = x;
+            for (n = 1; n <= cfg.MaxSteps; n++) {
+                cycle128_step(&key, &y);
+                if (y.High == x.High && y.Low == x.Low)
+                    break;
+            }
+            orbit = &cs.Orbit[i];
+            failed += orbit->Closed != (n <= cfg.MaxSteps) ||
+                      orbit->Steps != (n <= cfg.MaxSteps ? n : n - 1);
+            if (d && Rounds[r] <= 1)
+                failed += !orbit->Closed || orbit->Steps != Rounds[r] + 1u;
+        }
+        failed += cs.Finished != cfg.Orbits;
+        cycle128_free(&cs);
+    }
+    return test_report("run128", failed);
+}
+
+// A permutation with known cycles for the table search: mixed, every value
+// lies on a cycle of 2^TOY_BITS that counts up the low bits and keeps the
+// others. The cycles through neighbouring starts are far apart.
+#define TOY_BITS 16
+#define TOY_MASK (((uint64_t)1 << TOY_BITS) - 1)
+
+// The process that gets killed sets ToySlow, and steps slowly once it has
+// made that many steps, so that a checkpoint finds its walks between points
+static uint64_t ToySlow = 0;
+static uint64_t ToySteps;
+
+static uint64_t
+toy_step(uint64_t x, const struct UnrolledKey* uk)
+{
+    struct timespec pause = { 0, 20000 };
+
+    (void)uk;
+    if (ToySlow != 0 &&
+        __atomic_add_fetch(&ToySteps, 1, __ATOMIC_RELAXED) > ToySlow)
+        nanosleep(&pause, NULL);
+    x *= 0x9E3779B97F4A7C15;
+    x ^= x >> 32;
+    x *= 0xBF58476D1CE4E5B9;
+    x = (x & ~TOY_MASK) | ((x + 1) & TOY_MASK);
+    x *= 0x96DE1B173F119089;
+    x ^= x >> 32;
+    x *= 0xF1DE83E19937733D;
+    return x;
+}
+
+static void
+toy_config(struct CycleConfig* cfg, uint64_t first, uint8_t TableBits)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->Cipher     = toy_step;
+    cfg->FirstStart = first;
+    cfg->Orbits     = 4;
+    cfg->Threads    = 2;
+    cfg->DpBits     = 10;
+    cfg->TableBits  = TableBits;
+}
+
+// Every orbit of cs on a cycle of its own, walked all the way round
+static int
+toy_census(struct CycleSearch* cs)
+{
+    struct CycleInfo* cycles;
+    uint64_t          count, i;
+    int               failed;
+
+    cycles = cycle_census(cs, &count);
+    failed = cycles == NULL || count != cs->Config.Orbits;
+    for (i = 0; cycles != NULL && i < count; i++) {
+        failed += !cycles[i].Complete || cycles[i].Starts != 1 ||
+                  cycles[i].Length != (uint64_t)1 << TOY_BITS;
+    }
+    free(cycles);
+    return failed;
+}
+
+// A search is killed after its second checkpoint and resumed with a smaller
+// table, so the walks under way have to find their points in new slots
+static int
+check_checkpoint(void)
+{
+    char               path[] = "/tmp/giftTestXXXXXX";
+    struct CycleConfig cfg;
+    struct CycleSearch cs;
+    struct timespec    wait = { 0, 10000000 };
+    struct stat        first, now;
+    pid_t              pid;
+    uint64_t           i, moved = 0;
+    int                fd, failed = 0, tries, status;
+
+    fd = mkstemp(path);
+    if (fd < 0)
+        return test_report("checkpoint", 1);
+    close(fd);
+    remove(path);
+
+    toy_config(&cfg, 0x0123456789abcdef, 14);
+    cfg.Checkpoint      = path;
+    cfg.CheckpointEvery = 1;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        ToySlow = 1 << 15;
+        if (cycle_search_init(&cs, &cfg) == 0)
+            cycle_search_run(&cs);
+        _exit(0);
+    }
+    // Checkpoints replace the file, so the second has another inode
+    for (tries = 0; pid > 0 && tries < 1000 && stat(path, &first) != 0;
+         tries++) {
+        nanosleep(&wait, NULL);
+    }
+    for (; pid > 0 && tries < 1000; tries++) {
+        if (stat(path, &now) == 0 && now.st_ino != first.st_ino)
+            break;
+        nanosleep(&wait, NULL);
+    }
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    }
+
+    cfg.TableBits = 12;
+    if (pid < 0 || cycle_search_init(&cs, &cfg) != 0) {
+        remove(path);
+        return test_report("checkpoint", 1);
+    }
+    failed += cycle_checkpoint_load(&cs) != CHECKPOINT_RESUMED;
+    for (i = 0; i < cs.PendingCount; i++) {
+        moved += cs.Pending[i].Slot >= 0;
+    }
+    failed += moved == 0; // nothing to follow, the check would prove nothing
+    cycle_search_run(&cs);
+    failed += cs.CheckpointErrors != 0;
+    failed += toy_census(&cs);
+    cycle_search_free(&cs);
+    remove(path);
+    return test_report("checkpoint", failed);
+}
+
+// Two searches share a store: the second finds the cycles of the first in it,
+// and adds its new ones to the file
+static int
+check_store(void)
+{
+    char               path[] = "/tmp/giftTestXXXXXX";
+    char*              lock;
+    struct DpStoreId   id;
+    struct DpStore     ds;
+    struct CycleConfig cfg;
+    struct CycleSearch cs;
+    uint64_t           added, i, known = 0;
+    int                fd, failed = 0, run;
+
+    fd = mkstemp(path);
+    if (fd < 0)
+        return test_report("store", 1);
+    close(fd);
+    remove(path);
+    memset(&id, 0, sizeof(id));
+    id.DpBits = 10;
+
+    for (run = 0; run < 2; run++) {
+        failed += dp_store_open(&ds, path, &id) !=
+                  (run ? STORE_OPENED : STORE_NONE);
+        toy_config(&cfg, 0x0123456789abcdef + 2 * run, 16);
+        cfg.Store = &ds;
+        if (cycle_search_init(&cs, &cfg) != 0) {
+            dp_store_close(&ds);
+            failed++;
+            break;
+        }
+        cycle_search_run(&cs);
+        for (i = 0; i < cfg.Orbits; i++) {
+            known += cs.Orbit[i].State == ORBIT_KNOWN;
+        }
+        failed += toy_census(&cs);
+        failed += dp_store_add(&ds, &cs, &added) != 0 || added != (run ? 2 : 4);
+        cycle_search_free(&cs);
+        dp_store_close(&ds);
+    }
+    failed += known != 2;
 
-#include "comline.h" // Command Line
-#include "gift128.h" // Crypto functions
-#include "verbose.h" // For verbose output
+    failed += dp_store_open(&ds, path, &id) != STORE_OPENED || ds.Cycles != 6;
+    for (i = 0; i < ds.Cycles; i++) {
+        failed += ds.Cycle[i].Length != (uint64_t)1 << TOY_BITS;
+    }
+    dp_store_close(&ds);
+
+    remove(path);
+    lock = malloc(strlen(path) + 6);
+    if (lock != NULL) {
+        sprintf(lock, "%s.lock", path);
+        remove(lock);
+        free(lock);
+    }
+    return test_report("store", failed);
+}
+
+// The inverse of toy_step(). Its multipliers are inverse in pairs, the first
+// of the last and the second of the third, so they come in the same order.
+static uint64_t
+toy_back(uint64_t x)
+{
+    x *= 0x9E3779B97F4A7C15;
+    x ^= x >> 32;
+    x *= 0xBF58476D1CE4E5B9;
+    x = (x & ~TOY_MASK) | ((x - 1) & TOY_MASK);
+    x *= 0x96DE1B173F119089;
+    x ^= x >> 32;
+    x *= 0xF1DE83E19937733D;
+    return x;
+}
+
+// A pause every 256 values or so, so that neither bidir_walk() walk goes all
+// the way round before the other has started
+static uint64_t
+toy_pace(uint64_t x)
+{
+    struct timespec pause = { 0, 20000 };
+
+    if ((x & 0xFF) == 0)
+        nanosleep(&pause, NULL);
+    return x;
+}
+
+static uint64_t
+toy_forward(const struct BidirCipher* bc, uint64_t x)
+{
+    (void)bc;
+    return toy_pace(toy_step(x, NULL));
+}
+
+static uint64_t
+toy_backward(const struct BidirCipher* bc, uint64_t x)
+{
+    (void)bc;
+    return toy_pace(toy_back(x));
+}
+
+// bidir_walk() on the toy permutation: the walks meet at a distinguished
+// point and add up to the cycle length, or run out of steps well short of it
+static int
+check_bidir_toy(void)
+{
+    struct BidirConfig cfg;
+    struct BidirResult result;
+    uint64_t           rng = 0x6f6f6f6f01234567, x;
+    int                failed = 0, i;
+
+    for (i = 0; i < 64; i++) {
+        x = test_random(&rng);
+        failed += toy_back(toy_step(x, NULL)) != x;
+    }
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.Forward   = toy_forward;
+    cfg.Backward  = toy_backward;
+    cfg.DpBits    = 10;
+    cfg.TableBits = 10;
+    for (i = 0; i < 4; i++) {
+        cfg.Start    = test_random(&rng);
+        cfg.MaxSteps = i < 3 ? 0 : 1000;
+        if (bidir_walk(&cfg, &result) != 0) {
+            failed++;
+            continue;
+        }
+        if (cfg.MaxSteps != 0) {
+            failed += result.State != BIDIR_OPEN || result.Forward != 1000 ||
+                      result.Backward != 1000;
+            continue;
+        }
+        failed += result.State != BIDIR_MET ||
+                  result.Length != (uint64_t)1 << TOY_BITS ||
+                  result.Meet >> (64 - cfg.DpBits) != 0 || result.TableFull;
+    }
+    return test_report("bidir toy", failed);
+}
+
+static int
+self_test(void)
+{
+    int failed = 0;
+
+    failed += check_decompose();
+    failed += check_hunt();
+    failed += check_walk();
+    failed += check_bscycle();
+    failed += check_bidir();
+    failed += check_cycle128();
+    failed += check_run128();
+    failed += check_checkpoint();
+    failed += check_store();
+    failed += check_bidir_toy();
+    return failed;
+}
 
 //----------------------------------
 // Start of code
@@ -41,6 +741,9 @@ main(int argc, char** const argv)
     // Get Commandline Options
     comline_fetch_options(&Opt, argc, argv);
 
+    if (Opt.SelfTest && !Opt.Error)
+        return self_test() != 0;
+
     uint8_t txt[16]    = { 0 };
     uint8_t key[16]    = { 0 };
     uint8_t result[16] = { 0 };
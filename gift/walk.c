@@ -0,0 +1,377 @@
+/**
+ * Multi-step GIFT-64 walks, four orbits at a time
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ */
+
+#include <string.h>
+
+#include "walk.h"
+#include "bitslice.h"
+#include "fixslice.h"
+
+//----------------------------------
+// Macros for slice manipulation
+//----------------------------------
+// A 16-bit constant in every lane
+#define REP(c) ((uint64_t)(c)*0x0001000100010001)
+
+// Lanes that are zero show up in the top bit of the lane. Other lanes can be
+// flagged too, but only above a zero lane, so the test for any is exact.
+#define HAS_ZERO_LANE(x) ((((x)-REP(0x0001)) & ~(x)&REP(0x8000)) != 0)
+
+#define DELTA_SWAP(x, mask, shift)                                             \
+    do {                                                                       \
+        uint64_t t_ = ((x) ^ ((x) >> (shift))) & (mask);                       \
+        (x) ^= t_ ^ (t_ << (shift));                                           \
+    } while (0)
+
+// The row and column swaps of fixslice.c on all lanes
+#define SWAP_NIBBLES(x) ((((x)&REP(0x0F0F)) << 4) | (((x) >> 4) & REP(0x0F0F)))
+#define SWAP_BYTES(x) ((((x)&REP(0x00FF)) << 8) | (((x) >> 8) & REP(0x00FF)))
+#define SWAP_BITS(x) ((((x)&REP(0x5555)) << 1) | (((x) >> 1) & REP(0x5555)))
+#define SWAP_PAIRS(x) ((((x)&REP(0x3333)) << 2) | (((x) >> 2) & REP(0x3333)))
+
+#define ROWS_0(x) (x = SWAP_NIBBLES(x), x = SWAP_BYTES(x))
+#define ROWS_1(x) DELTA_SWAP(x, REP(0x00F0), 8)
+#define ROWS_2(x) (x = SWAP_NIBBLES(x))
+#define ROWS_3(x) DELTA_SWAP(x, REP(0x000F), 8)
+
+#define COLS_0(x) (x = SWAP_BITS(x), x = SWAP_PAIRS(x))
+#define COLS_1(x) DELTA_SWAP(x, REP(0x2222), 2)
+#define COLS_2(x) (x = SWAP_BITS(x))
+#define COLS_3(x) DELTA_SWAP(x, REP(0x1111), 2)
+
+#define TRANSPOSE(x)                                                           \
+    do {                                                                       \
+        DELTA_SWAP(x, REP(0x0A0A), 3);                                         \
+        DELTA_SWAP(x, REP(0x00CC), 6);                                         \
+    } while (0)
+
+#define SBOX_LAYER(s0, s1, s2, s3)                                             \
+    do {                                                                       \
+        uint64_t t_;                                                           \
+        BS_SBOX(s0, s1, s2, s3);                                               \
+        t_ = s0;                                                               \
+        s0 = s3;                                                               \
+        s3 = t_;                                                               \
+    } while (0)
+
+#define SBOX_INV_LAYER(s0, s1, s2, s3)                                         \
+    do {                                                                       \
+        uint64_t t_;                                                           \
+        BS_SBOX_INV(s0, s1, s2, s3);                                           \
+        t_ = s0;                                                               \
+        s0 = s3;                                                               \
+        s3 = t_;                                                               \
+    } while (0)
+
+#define ADD_KEY(s0, s1, s2, s3, key)                                           \
+    do {                                                                       \
+        s0 ^= (key)[0];                                                        \
+        s1 ^= (key)[1];                                                        \
+        s2 ^= (key)[2];                                                        \
+        s3 ^= (key)[3];                                                        \
+    } while (0)
+
+//----------------------------------
+// Lane layout
+//----------------------------------
+// Between one packed block per word (slice j at bit 16 * j) and one slice per
+// word (lane i at bit 16 * i): a 4x4 transpose of 16-bit elements, which is
+// its own inverse
+static void
+transpose_lanes(uint64_t m[4])
+{
+    uint64_t t[4] = { 0, 0, 0, 0 };
+    int      i, j;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            t[j] |= ((m[i] >> (16 * j)) & 0xFFFF) << (16 * i);
+        }
+    }
+    memcpy(m, t, sizeof(t));
+}
+
+//----------------------------------
+// Key Scheduling
+//----------------------------------
+void
+walk_key(struct WalkKey* wk, const uint64_t* subkey, uint16_t Rounds)
+{
+    struct FixsliceKey fk;
+    uint16_t           i;
+    int                b;
+
+    // fixslice_key() clamps Rounds to MAX_ROUNDS
+    fixslice_key(&fk, subkey, Rounds);
+    for (i = 0; i < fk.Rounds; i++) {
+        for (b = 0; b < 4; b++) {
+            wk->Normal[i][b]     = REP((fk.Normal[i] >> (16 * b)) & 0xFFFF);
+            wk->Transposed[i][b] = REP((fk.Transposed[i] >> (16 * b)) & 0xFFFF);
+        }
+    }
+    wk->Rounds = fk.Rounds;
+}
+
+//----------------------------------
+// Round-specialized kernels
+//----------------------------------
+// Same structure as the unrolled kernels of fixslice.c, see there
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+#define ENCRYPT_ROUND(k)                                                       \
+    if ((k) + 1 < Rounds) {                                                    \
+        SBOX_LAYER(s0, s1, s2, s3);                                            \
+        if ((k) % 2 == 0) {                                                    \
+            ROWS_0(s0);                                                        \
+            ROWS_1(s1);                                                        \
+            ROWS_2(s2);                                                        \
+            ROWS_3(s3);                                                        \
+            ADD_KEY(s0, s1, s2, s3, wk->Transposed[k]);                        \
+        } else {                                                               \
+            COLS_0(s0);                                                        \
+            COLS_1(s1);                                                        \
+            COLS_2(s2);                                                        \
+            COLS_3(s3);                                                        \
+            ADD_KEY(s0, s1, s2, s3, wk->Normal[k]);                            \
+        }                                                                      \
+    }
+
+#define DECRYPT_ROUND(r)                                                       \
+    if ((r) < Rounds) {                                                        \
+        if ((r) % 2 == 1) {                                                    \
+            ADD_KEY(s0, s1, s2, s3, wk->Normal[Rounds - (r)]);                 \
+            COLS_0(s0);                                                        \
+            COLS_1(s1);                                                        \
+            COLS_2(s2);                                                        \
+            COLS_3(s3);                                                        \
+        } else {                                                               \
+            ADD_KEY(s0, s1, s2, s3, wk->Transposed[Rounds - (r)]);             \
+            ROWS_0(s0);                                                        \
+            ROWS_1(s1);                                                        \
+            ROWS_2(s2);                                                        \
+            ROWS_3(s3);                                                        \
+        }                                                                      \
+        SBOX_INV_LAYER(s0, s1, s2, s3);                                        \
+    }
+
+// One block of every lane through the cipher, from the normal layout back to
+// it
+#define ENCRYPT_STEP()                                                         \
+    do {                                                                       \
+        ENCRYPT_ROUND(0);                                                      \
+        ENCRYPT_ROUND(1);                                                      \
+        ENCRYPT_ROUND(2);                                                      \
+        ENCRYPT_ROUND(3);                                                      \
+        ENCRYPT_ROUND(4);                                                      \
+        ENCRYPT_ROUND(5);                                                      \
+        ENCRYPT_ROUND(6);                                                      \
+        ENCRYPT_ROUND(7);                                                      \
+        ENCRYPT_ROUND(8);                                                      \
+        ENCRYPT_ROUND(9);                                                      \
+        ENCRYPT_ROUND(10);                                                     \
+        ENCRYPT_ROUND(11);                                                     \
+        ENCRYPT_ROUND(12);                                                     \
+        ENCRYPT_ROUND(13);                                                     \
+        ENCRYPT_ROUND(14);                                                     \
+        ENCRYPT_ROUND(15);                                                     \
+        ENCRYPT_ROUND(16);                                                     \
+        ENCRYPT_ROUND(17);                                                     \
+        ENCRYPT_ROUND(18);                                                     \
+        ENCRYPT_ROUND(19);                                                     \
+        ENCRYPT_ROUND(20);                                                     \
+        ENCRYPT_ROUND(21);                                                     \
+        ENCRYPT_ROUND(22);                                                     \
+        ENCRYPT_ROUND(23);                                                     \
+        ENCRYPT_ROUND(24);                                                     \
+        ENCRYPT_ROUND(25);                                                     \
+        ENCRYPT_ROUND(26);                                                     \
+        ENCRYPT_ROUND(27);                                                     \
+        ENCRYPT_ROUND(28);                                                     \
+        ENCRYPT_ROUND(29);                                                     \
+        ENCRYPT_ROUND(30);                                                     \
+        ENCRYPT_ROUND(31);                                                     \
+        ENCRYPT_ROUND(32);                                                     \
+        ENCRYPT_ROUND(33);                                                     \
+        ENCRYPT_ROUND(34);                                                     \
+        ENCRYPT_ROUND(35);                                                     \
+        ENCRYPT_ROUND(36);                                                     \
+        ENCRYPT_ROUND(37);                                                     \
+        ENCRYPT_ROUND(38);                                                     \
+        ENCRYPT_ROUND(39);                                                     \
+        ENCRYPT_ROUND(40);                                                     \
+        ENCRYPT_ROUND(41);                                                     \
+        ENCRYPT_ROUND(42);                                                     \
+        ENCRYPT_ROUND(43);                                                     \
+        ENCRYPT_ROUND(44);                                                     \
+        ENCRYPT_ROUND(45);                                                     \
+        if (Rounds > 1 && !(Rounds & 1)) {                                     \
+            TRANSPOSE(s0);                                                     \
+            TRANSPOSE(s1);                                                     \
+            TRANSPOSE(s2);                                                     \
+            TRANSPOSE(s3);                                                     \
+        }                                                                      \
+    } while (0)
+
+#define DECRYPT_STEP()                                                         \
+    do {                                                                       \
+        DECRYPT_ROUND(1);                                                      \
+        DECRYPT_ROUND(2);                                                      \
+        DECRYPT_ROUND(3);                                                      \
+        DECRYPT_ROUND(4);                                                      \
+        DECRYPT_ROUND(5);                                                      \
+        DECRYPT_ROUND(6);                                                      \
+        DECRYPT_ROUND(7);                                                      \
+        DECRYPT_ROUND(8);                                                      \
+        DECRYPT_ROUND(9);                                                      \
+        DECRYPT_ROUND(10);                                                     \
+        DECRYPT_ROUND(11);                                                     \
+        DECRYPT_ROUND(12);                                                     \
+        DECRYPT_ROUND(13);                                                     \
+        DECRYPT_ROUND(14);                                                     \
+        DECRYPT_ROUND(15);                                                     \
+        DECRYPT_ROUND(16);                                                     \
+        DECRYPT_ROUND(17);                                                     \
+        DECRYPT_ROUND(18);                                                     \
+        DECRYPT_ROUND(19);                                                     \
+        DECRYPT_ROUND(20);                                                     \
+        DECRYPT_ROUND(21);                                                     \
+        DECRYPT_ROUND(22);                                                     \
+        DECRYPT_ROUND(23);                                                     \
+        DECRYPT_ROUND(24);                                                     \
+        DECRYPT_ROUND(25);                                                     \
+        DECRYPT_ROUND(26);                                                     \
+        DECRYPT_ROUND(27);                                                     \
+        DECRYPT_ROUND(28);                                                     \
+        DECRYPT_ROUND(29);                                                     \
+        DECRYPT_ROUND(30);                                                     \
+        DECRYPT_ROUND(31);                                                     \
+        DECRYPT_ROUND(32);                                                     \
+        DECRYPT_ROUND(33);                                                     \
+        DECRYPT_ROUND(34);                                                     \
+        DECRYPT_ROUND(35);                                                     \
+        DECRYPT_ROUND(36);                                                     \
+        DECRYPT_ROUND(37);                                                     \
+        DECRYPT_ROUND(38);                                                     \
+        DECRYPT_ROUND(39);                                                     \
+        DECRYPT_ROUND(40);                                                     \
+        DECRYPT_ROUND(41);                                                     \
+        DECRYPT_ROUND(42);                                                     \
+        DECRYPT_ROUND(43);                                                     \
+        DECRYPT_ROUND(44);                                                     \
+        DECRYPT_ROUND(45);                                                     \
+        DECRYPT_ROUND(46);                                                     \
+        if (Rounds & 1) {                                                      \
+            ADD_KEY(s0, s1, s2, s3, wk->Normal[0]);                            \
+        } else if (Rounds > 0) {                                               \
+            ADD_KEY(s0, s1, s2, s3, wk->Transposed[0]);                        \
+            TRANSPOSE(s0);                                                     \
+            TRANSPOSE(s1);                                                     \
+            TRANSPOSE(s2);                                                     \
+            TRANSPOSE(s3);                                                     \
+        }                                                                      \
+    } while (0)
+
+ALWAYS_INLINE uint64_t
+walk_body(uint64_t              x[WALK_LANES],
+          const uint64_t        stop[WALK_LANES],
+          uint64_t              steps,
+          uint64_t              dpMask,
+          const struct WalkKey* wk,
+          uint16_t              Rounds,
+          _Bool                 Decrypt)
+{
+    uint64_t s[4], g[4], m[4];
+    uint64_t s0, s1, s2, s3, n;
+    uint64_t mask = fixslice_pack(dpMask);
+    int      i;
+
+    // The slices of the lanes, the stop values and the mask. The packed
+    // layout only moves bits, so it keeps a point distinguished.
+    for (i = 0; i < WALK_LANES; i++) {
+        s[i] = fixslice_pack(x[i]);
+        g[i] = fixslice_pack(stop[i]);
+        m[i] = REP((mask >> (16 * i)) & 0xFFFF);
+    }
+    transpose_lanes(s);
+    transpose_lanes(g);
+    s0 = s[0];
+    s1 = s[1];
+    s2 = s[2];
+    s3 = s[3];
+
+    for (n = 0; n < steps;) {
+        if (Decrypt)
+            DECRYPT_STEP();
+        else
+            ENCRYPT_STEP();
+        n++;
+
+        if (HAS_ZERO_LANE((s0 & m[0]) | (s1 & m[1]) | (s2 & m[2]) |
+                          (s3 & m[3])) ||
+            HAS_ZERO_LANE((s0 ^ g[0]) | (s1 ^ g[1]) | (s2 ^ g[2]) |
+                          (s3 ^ g[3])))
+            break;
+    }
+
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+    transpose_lanes(s);
+    for (i = 0; i < WALK_LANES; i++) {
+        x[i] = fixslice_unpack(s[i]);
+    }
+    return n;
+}
+
+// One instance per supported round count
+#define WALK_ROUNDS(X)                                                         \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7)                                   \
+    X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15)                             \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23)                           \
+    X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)                           \
+    X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39)                           \
+    X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47)
+#define DEFINE_WALK(R)                                                         \
+    static uint64_t walk_encrypt_r##R(uint64_t              x[WALK_LANES],     \
+                                      const uint64_t        stop[WALK_LANES],  \
+                                      uint64_t              steps,             \
+                                      uint64_t              dpMask,            \
+                                      const struct WalkKey* wk)                \
+    {                                                                          \
+        return walk_body(x, stop, steps, dpMask, wk, R, 0);                    \
+    }                                                                          \
+    static uint64_t walk_decrypt_r##R(uint64_t              x[WALK_LANES],     \
+                                      const uint64_t        stop[WALK_LANES],  \
+                                      uint64_t              steps,             \
+                                      uint64_t              dpMask,            \
+                                      const struct WalkKey* wk)                \
+    {                                                                          \
+        return walk_body(x, stop, steps, dpMask, wk, R, 1);                    \
+    }
+#define ENCRYPT_ENTRY(R) walk_encrypt_r##R,
+#define DECRYPT_ENTRY(R) walk_decrypt_r##R,
+
+WALK_ROUNDS(DEFINE_WALK)
+
+static const WalkKernel WalkEncrypt[] = { WALK_ROUNDS(ENCRYPT_ENTRY) };
+static const WalkKernel WalkDecrypt[] = { WALK_ROUNDS(DECRYPT_ENTRY) };
+
+//----------------------------------
+// Dispatch
+//----------------------------------
+WalkKernel
+walk_encrypt_for(uint16_t Rounds)
+{
+    return Rounds <= 47 ? WalkEncrypt[Rounds] : NULL;
+}
+
+WalkKernel
+walk_decrypt_for(uint16_t Rounds)
+{
+    return Rounds <= 47 ? WalkDecrypt[Rounds] : NULL;
+}
@@ -0,0 +1,57 @@
+/**
+ * Multi-step GIFT-64 walks, four orbits at a time
+ *
+ * Riley Myers (william.myers@inl.gov)
+ *
+ * Walking an orbit feeds every block back into the cipher, so a kernel that
+ * runs many steps per call can leave the state in the fixsliced layout of
+ * fixslice.h between steps instead of converting it for every block. The
+ * kernels also hold slice b of four orbits in one 64-bit word, 16 bits each.
+ * No operation of a round crosses a slice, so with its masks repeated four
+ * times the round advances all four orbits for the price of one.
+ *
+ * A walk stops at the first step that brings any orbit to a distinguished
+ * point, a value with none of the bits of the mask set, or to its stop value,
+ * so the caller sees every such point. As with unrolled_encrypt_for() there
+ * is one fully unrolled kernel for every round count.
+ *
+ */
+
+#pragma once
+#include <stdint.h>
+
+#define WALK_LANES 4
+
+//----------------------------------
+// Struct declaration
+//----------------------------------
+// The round keys of a FixsliceKey, one word per slice with the 16 bits of the
+// slice repeated in every lane
+struct WalkKey
+{
+    uint64_t Normal[47][4];
+    uint64_t Transposed[47][4];
+    uint16_t Rounds;
+};
+
+// Advances every x[i] by the same number of steps, at most steps, and returns
+// that number. A stop value that is a distinguished point itself, such as 0,
+// never ends a walk early.
+typedef uint64_t (*WalkKernel)(uint64_t              x[WALK_LANES],
+                               const uint64_t        stop[WALK_LANES],
+                               uint64_t              steps,
+                               uint64_t              dpMask,
+                               const struct WalkKey* wk);
+
+//----------------------------------
+// Function prototypes
+//----------------------------------
+void
+walk_key(struct WalkKey* wk, const uint64_t* subkey, uint16_t Rounds);
+
+// The kernels for a round count (0 to 47), NULL for any other count
+WalkKernel
+walk_encrypt_for(uint16_t Rounds);
+
+WalkKernel
+walk_decrypt_for(uint16_t Rounds);